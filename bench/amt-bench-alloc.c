@@ -0,0 +1,294 @@
+/**
+ * @file amt-bench-alloc.c
+ * @brief Acronym Management Tool (amt). Benchmark of the SQLite allocators amt can use, over a long session.
+ * @details Runs the same long session of searches and changes against a database once for each SQLite allocator
+ * set up by 'amt-alloc.c': malloc, and the arena sized for a command, the shell and the server. Each session runs in
+ * its own process, as SQLite can only be set up once. The session is mostly exact and prefix searches as amt runs
+ * them, with records copied into and trimmed from a temporary table, and statements prepared once and thrown away,
+ * as a shell or server does over hours of use. The operations per second, the most memory SQLite held, and the
+ * resident size of the process are shown for the first and last tenth of the session, so an allocator that slows
+ * or grows as its memory fragments shows up as a difference between the two.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note Build with CMake as target 'amt-bench-alloc', or directly with
+ * @code cc -O2 -Wall -std=gnu11 -DSQLITE_ENABLE_MEMSYS5 -I./src -o amt-bench-alloc ./bench/amt-bench-alloc.c
+ * ./src/amt-alloc.c ./src/sqlite3.c -lpthread -ldl -lm
+ * @note Usage: amt-bench-alloc <database> [operations] [seed]
+ * @code ./amt-bench-alloc ~/.acronyms.db 200000
+ * @note The database is opened read only, and is not changed. Without 'SQLITE_ENABLE_MEMSYS5' the arena sessions
+ * are shown as not available.
+ */
+
+#include "amt-alloc.h" /** @note SQLite allocator set up used by amt */
+#include "sqlite3.h"   /** @note SQLite database C amalgamation header */
+
+#include <stdbool.h>  /* bool */
+#include <stdio.h>    /* printf */
+#include <stdlib.h>   /* exit atol */
+#include <string.h>   /* memcpy strlen */
+#include <sys/wait.h> /* waitpid */
+#include <time.h>     /* clock_gettime */
+#include <unistd.h>   /* fork pipe sysconf */
+
+#define BENCH_OPS 50000      /** @note operations in each session, unless given */
+#define BENCH_SEED 1         /** @note seed of the operations chosen, unless given */
+#define BENCH_PHASES 10      /** @note parts of the session measured separately */
+#define BENCH_CHURN_ROWS 500 /** @note records kept in the temporary table as it is trimmed */
+
+/** @note the allocators compared: each is a mode and allocator as 'alloc_setup()' takes them */
+static const struct bench_config {
+    const char *name;
+    alloc_mode mode;
+    const char *choice;
+} bench_configs[] = {
+    {"malloc", ALLOC_COMMAND, "malloc"},
+    {"arena command", ALLOC_COMMAND, "arena"},
+    {"arena shell", ALLOC_SHELL, "arena"},
+    {"arena server", ALLOC_SERVER, "arena"},
+};
+
+#define BENCH_CONFIGS (sizeof(bench_configs) / sizeof(bench_configs[0]))
+
+/** @note the results of one session, sent from its process to the parent */
+typedef struct bench_result {
+    bool ok;
+    size_t arena;
+    double ops_per_sec[BENCH_PHASES];
+    long long rss[BENCH_PHASES];
+    long long heap_max;
+    long long mallocs_max;
+    long long failed;
+} bench_result;
+
+/** @note the statements prepared once for the session, as amt keeps them in its registry */
+typedef enum { STMT_RECORD, STMT_EXACT, STMT_RANGE, STMT_CHURN_ADD, STMT_CHURN_TRIM, STMT_COUNT } bench_stmt;
+
+static const char *bench_sql[STMT_COUNT] = {
+    [STMT_RECORD] = "select Acronym, ifnull(Description,'') from ACRONYMS where rowid >= ?1 limit 1;",
+    [STMT_EXACT] = "select rowid,ifnull(Acronym,''), ifnull(Definition,''), ifnull(Source,''), "
+                   "ifnull(Description,''), ifnull(Changed,'') from ACRONYMS where Acronym = ?1 COLLATE NOCASE "
+                   "ORDER BY Source;",
+    [STMT_RANGE] = "select rowid,ifnull(Acronym,''), ifnull(Definition,''), ifnull(Source,''), "
+                   "ifnull(Description,''), ifnull(Changed,'') from ACRONYMS where Acronym >= ?1 COLLATE NOCASE "
+                   "and Acronym < ?2 COLLATE NOCASE ORDER BY Source;",
+    [STMT_CHURN_ADD] = "insert into temp.churn(d) values(?1);",
+    [STMT_CHURN_TRIM] = "delete from temp.churn where id <= (select max(id) from temp.churn) - ?1;",
+};
+
+static double now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/** @note xorshift64: the same seed gives the same session for every allocator */
+static unsigned long long bench_next(unsigned long long *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/** @note the resident size of this process in bytes, or zero where '/proc' is not available */
+static long long bench_rss(void)
+{
+    long long pages = 0, resident = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm != NULL) {
+        if (fscanf(statm, "%lld %lld", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(statm);
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+/** @note step a statement to the end, reading each row as amt does. Returns false on any error, such as no memory */
+static bool bench_step(sqlite3_stmt *stmt)
+{
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        for (int i = 0; i < sqlite3_column_count(stmt); i++) {
+            sqlite3_column_text(stmt, i);
+        }
+    }
+    sqlite3_reset(stmt);
+    return rc == SQLITE_DONE;
+}
+
+/** @note run one session with the allocator given. Only returns the results if it could be started */
+static bool bench_session(const char *dbfile, const struct bench_config *config, long long ops,
+                          unsigned long long seed, bench_result *result)
+{
+    sqlite3 *db = NULL;
+    sqlite3_stmt *stmts[STMT_COUNT] = {NULL};
+
+    if (!alloc_setup(config->mode, config->choice)) {
+        return false;
+    }
+    result->arena = alloc_heap_bytes();
+    if (strcmp(config->choice, "malloc") != 0 && result->arena == 0) {
+        return false;
+    }
+
+    if (sqlite3_open_v2(dbfile, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK ||
+        sqlite3_exec(db, "PRAGMA temp_store = memory; create temp table churn(id integer primary key, d text);",
+                     NULL, NULL, NULL) != SQLITE_OK) {
+        fprintf(stderr, "ERROR: unable to open '%s': %s\n", dbfile, sqlite3_errmsg(db));
+        return false;
+    }
+    for (int i = 0; i < STMT_COUNT; i++) {
+        if (sqlite3_prepare_v2(db, bench_sql[i], -1, &stmts[i], NULL) != SQLITE_OK) {
+            fprintf(stderr, "ERROR: unable to prepare '%s': %s\n", bench_sql[i], sqlite3_errmsg(db));
+            return false;
+        }
+    }
+
+    sqlite3_stmt *max_stmt = NULL;
+    long long max_id = 0;
+    if (sqlite3_prepare_v2(db, "select max(rowid) from ACRONYMS;", -1, &max_stmt, NULL) == SQLITE_OK &&
+        sqlite3_step(max_stmt) == SQLITE_ROW) {
+        max_id = sqlite3_column_int64(max_stmt, 0);
+    }
+    sqlite3_finalize(max_stmt);
+    if (max_id < 1) {
+        fprintf(stderr, "ERROR: no records found in '%s'.\n", dbfile);
+        return false;
+    }
+
+    unsigned long long state = seed * 2654435761ULL + 1;
+    const long long per_phase = (ops + BENCH_PHASES - 1) / BENCH_PHASES;
+    long long churn = 0;
+
+    for (int phase = 0; phase < BENCH_PHASES; phase++) {
+        const double start = now_secs();
+        const long long end = (phase + 1) * per_phase < ops ? (phase + 1) * per_phase : ops;
+        for (long long op = phase * per_phase; op < end; op++) {
+            /** @note every operation starts from a record chosen at random, as a person would search */
+            sqlite3_stmt *rec = stmts[STMT_RECORD];
+            sqlite3_bind_int64(rec, 1, 1 + (long long)(bench_next(&state) % (unsigned long long)max_id));
+            if (sqlite3_step(rec) != SQLITE_ROW) {
+                sqlite3_reset(rec);
+                continue;
+            }
+            char acronym[64];
+            snprintf(acronym, sizeof(acronym), "%s", (const char *)sqlite3_column_text(rec, 0));
+            const unsigned kind = (unsigned)(bench_next(&state) % 100);
+            bool ok = true;
+
+            if (kind < 70) {
+                sqlite3_reset(rec);
+                sqlite3_bind_text(stmts[STMT_EXACT], 1, acronym, -1, SQLITE_STATIC);
+                ok = bench_step(stmts[STMT_EXACT]);
+            } else if (kind < 75) {
+                sqlite3_reset(rec);
+                /** @note the first three letters, as typed before a hint is taken */
+                char from[4], to[4];
+                const size_t len = strlen(acronym) < 3 ? strlen(acronym) : 3;
+                memcpy(from, acronym, len);
+                from[len] = '\0';
+                memcpy(to, from, len + 1);
+                to[len ? len - 1 : 0]++;
+                sqlite3_bind_text(stmts[STMT_RANGE], 1, from, -1, SQLITE_STATIC);
+                sqlite3_bind_text(stmts[STMT_RANGE], 2, to, -1, SQLITE_STATIC);
+                ok = bench_step(stmts[STMT_RANGE]);
+            } else if (kind < 90) {
+                /** @note descriptions vary from empty to several KB, so the churn uses blocks of every size */
+                sqlite3_bind_text(stmts[STMT_CHURN_ADD], 1, (const char *)sqlite3_column_text(rec, 1), -1,
+                                  SQLITE_TRANSIENT);
+                sqlite3_reset(rec);
+                ok = bench_step(stmts[STMT_CHURN_ADD]);
+                if (++churn >= 2 * BENCH_CHURN_ROWS) {
+                    sqlite3_bind_int(stmts[STMT_CHURN_TRIM], 1, BENCH_CHURN_ROWS);
+                    ok = bench_step(stmts[STMT_CHURN_TRIM]) && ok;
+                    churn = BENCH_CHURN_ROWS;
+                }
+            } else {
+                /** @note a statement prepared for one use, as the shell does for one off commands */
+                sqlite3_reset(rec);
+                char *sql = sqlite3_mprintf("select count(*) from ACRONYMS where Acronym = %Q COLLATE NOCASE "
+                                            "and Source <> 'x%lld';", acronym, op);
+                sqlite3_stmt *once = NULL;
+                ok = sql != NULL && sqlite3_prepare_v2(db, sql, -1, &once, NULL) == SQLITE_OK && bench_step(once);
+                sqlite3_finalize(once);
+                sqlite3_free(sql);
+            }
+            result->failed += !ok;
+        }
+        const double secs = now_secs() - start;
+        result->ops_per_sec[phase] = (secs > 0.0) ? (double)(end - phase * per_phase) / secs : 0.0;
+        result->rss[phase] = bench_rss();
+    }
+
+    sqlite3_int64 current, highest;
+    sqlite3_status64(SQLITE_STATUS_MEMORY_USED, &current, &highest, 0);
+    result->heap_max = highest;
+    sqlite3_status64(SQLITE_STATUS_MALLOC_COUNT, &current, &highest, 0);
+    result->mallocs_max = highest;
+
+    for (int i = 0; i < STMT_COUNT; i++) {
+        sqlite3_finalize(stmts[i]);
+    }
+    sqlite3_close(db);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <database> [operations] [seed]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    const long long ops = (argc > 2) ? atoll(argv[2]) : BENCH_OPS;
+    const unsigned long long seed = (argc > 3) ? (unsigned long long)atoll(argv[3]) : BENCH_SEED;
+    if (ops < BENCH_PHASES) {
+        fprintf(stderr, "ERROR: the operations must be at least '%d'.\n", BENCH_PHASES);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("\nSession of '%lld' operations on '%s'\n\n", ops, argv[1]);
+    printf("%-14s %8s  %12s %12s  %12s %10s  %12s %12s  %7s\n", "allocator", "arena MB", "ops/s first",
+           "ops/s last", "SQLite peak", "allocs", "RSS first", "RSS last", "failed");
+
+    bool failed = false;
+    for (size_t i = 0; i < BENCH_CONFIGS; i++) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            perror("ERROR: unable to create a pipe");
+            exit(EXIT_FAILURE);
+        }
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("ERROR: unable to start a session");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            bench_result result = {0};
+            result.ok = bench_session(argv[1], &bench_configs[i], ops, seed, &result);
+            _exit(write(fds[1], &result, sizeof(result)) == (ssize_t)sizeof(result) ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+        close(fds[1]);
+        bench_result result = {0};
+        const bool got = read(fds[0], &result, sizeof(result)) == (ssize_t)sizeof(result);
+        close(fds[0]);
+        waitpid(pid, NULL, 0);
+
+        if (!got || !result.ok) {
+            printf("%-14s   not available\n", bench_configs[i].name);
+            continue;
+        }
+        failed = failed || result.failed > 0;
+        printf("%-14s %8zu  %12.0f %12.0f  %10lld K %10lld  %10lld K %10lld K  %7lld\n", bench_configs[i].name,
+               result.arena / (1024 * 1024), result.ops_per_sec[0], result.ops_per_sec[BENCH_PHASES - 1],
+               result.heap_max / 1024, result.mallocs_max, result.rss[0] / 1024, result.rss[BENCH_PHASES - 1] / 1024,
+               result.failed);
+    }
+    printf("\n");
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,237 @@
+/**
+ * @file amt-bench-concurrency.c
+ * @brief Acronym Management Tool (amt). Stress test of many copies of amt using one database at the same time.
+ * @details Starts a number of worker processes that each run the 'amt' program given over and over against the same
+ * database. Most workers search for an acronym with 'amt -s', and every fourth one adds a record with
+ * 'amt --import'. Each run is timed, and any run that exits with an error is counted as a failure. Once every worker
+ * has finished the number of records in the database is checked against the records added. The run time percentiles
+ * of the searches and the additions are reported, and the exit status is non zero if any run failed or a record is
+ * missing.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note Build with CMake as target 'amt-bench-concurrency', or directly with
+ * @code cc -O2 -Wall -std=gnu11 -I./src -o amt-bench-concurrency ./bench/amt-bench-concurrency.c ./src/sqlite3.c
+ * -lpthread -ldl -lm
+ * @note Usage: amt-bench-concurrency <amt program> <database> [workers] [runs per worker]
+ * @code ./amt-bench-concurrency ./bin/amt /tmp/stress.db 32 50
+ * @note The database is changed by the test, so use a copy. Set env 'AMT_JOURNAL_MODE' to 'delete' to compare
+ * with the rollback journal.
+ */
+
+#include "sqlite3.h" /** @note SQLite database C amalgamation header */
+
+#include <fcntl.h>     /* open */
+#include <spawn.h>     /* posix_spawn */
+#include <stdbool.h>   /* bool */
+#include <stdio.h>     /* printf */
+#include <stdlib.h>    /* exit qsort setenv */
+#include <string.h>    /* strerror */
+#include <sys/wait.h>  /* waitpid */
+#include <time.h>      /* clock_gettime */
+#include <unistd.h>    /* fork pipe */
+
+#define BENCH_WORKERS 16     /** @note worker processes run at once, unless given */
+#define BENCH_RUNS 20        /** @note runs of 'amt' by each worker, unless given */
+#define BENCH_WRITER_EVERY 4 /** @note every this many workers adds records rather than searching */
+
+extern char **environ;
+
+/** @note the result of one run of 'amt', sent from a worker to the parent. Small enough to be written atomically */
+typedef struct bench_result {
+    int writer;
+    int ok;
+    double secs;
+} bench_result;
+
+static double now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/** @note run the 'amt' program once with its output sent to '/dev/null'. Returns true if it exited without error */
+static bool run_amt(char *const args[])
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    pid_t pid;
+    int status = -1;
+    int rc = posix_spawn(&pid, args[0], &actions, NULL, args, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (rc != 0) {
+        fprintf(stderr, "ERROR: unable to run '%s': %s\n", args[0], strerror(rc));
+        return false;
+    }
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/** @note the work of one worker process: 'runs' searches or additions, each result written to 'fd' */
+static void bench_worker(const char *amt, int worker, int runs, int fd)
+{
+    const int writer = (worker % BENCH_WRITER_EVERY) == 0;
+    char csv[64] = "";
+    char acronym[32];
+    snprintf(acronym, sizeof(acronym), "STRESS%d", worker);
+
+    if (writer) {
+        snprintf(csv, sizeof(csv), "/tmp/amt-bench-concurrency-%d-%d.csv", (int)getpid(), worker);
+        FILE *file = fopen(csv, "w");
+        if (file == NULL) {
+            perror("ERROR: unable to create the records to import");
+            exit(EXIT_FAILURE);
+        }
+        fprintf(file, "Acronym,Definition,Description,Source\n%s,Stress test record,Added by worker %d,Stress\n",
+                acronym, worker);
+        fclose(file);
+    }
+
+    char *import_args[] = {(char *)amt, "--import", csv, NULL};
+    char *search_args[] = {(char *)amt, "-s", acronym, NULL};
+
+    for (int run = 0; run < runs; run++) {
+        bench_result result = {writer, 0, 0.0};
+        double start = now_secs();
+        result.ok = run_amt(writer ? import_args : search_args);
+        result.secs = now_secs() - start;
+        if (write(fd, &result, sizeof(result)) != (ssize_t)sizeof(result)) {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if (writer) {
+        unlink(csv);
+    }
+    exit(EXIT_SUCCESS);
+}
+
+static int compare_secs(const void *a, const void *b)
+{
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+/** @note output the count, failures and run time percentiles of one kind of run */
+static void bench_report(const char *name, double *secs, int count, int failed)
+{
+    qsort(secs, (size_t)count, sizeof(double), compare_secs);
+    printf("%-8s runs %6d  failed %4d", name, count, failed);
+    if (count > 0) {
+        printf("  p50 %8.2f ms  p90 %8.2f ms  p99 %8.2f ms  max %8.2f ms", secs[count / 2] * 1000.0,
+               secs[(count * 9) / 10] * 1000.0, secs[(count * 99) / 100] * 1000.0, secs[count - 1] * 1000.0);
+    }
+    printf("\n");
+}
+
+/** @note the number of records in the database, or -1 if it could not be counted */
+static long long count_records(const char *dbfile)
+{
+    sqlite3 *db = NULL;
+    sqlite3_stmt *stmt = NULL;
+    long long count = -1;
+
+    if (sqlite3_open_v2(dbfile, &db, SQLITE_OPEN_READONLY, NULL) == SQLITE_OK &&
+        sqlite3_busy_timeout(db, 10000) == SQLITE_OK &&
+        sqlite3_prepare_v2(db, "select count(*) from ACRONYMS;", -1, &stmt, NULL) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        count = sqlite3_column_int64(stmt, 0);
+    } else {
+        fprintf(stderr, "ERROR: unable to count the records in '%s': %s\n", dbfile, sqlite3_errmsg(db));
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return count;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <amt program> <database> [workers] [runs per worker]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    const char *amt = argv[1];
+    const int workers = (argc > 3) ? atoi(argv[3]) : BENCH_WORKERS;
+    const int runs = (argc > 4) ? atoi(argv[4]) : BENCH_RUNS;
+    if (workers < 1 || runs < 1) {
+        fprintf(stderr, "ERROR: the workers and runs per worker must both be at least one.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /** @note every run uses the database given directly, not a server that may be running */
+    setenv("ACRODB", argv[2], 1);
+    setenv("AMT_SOCKET", "", 1);
+
+    const long long before = count_records(argv[2]);
+    if (before < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("ERROR: unable to create a pipe");
+        exit(EXIT_FAILURE);
+    }
+
+    double start = now_secs();
+    for (int worker = 0; worker < workers; worker++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("ERROR: unable to start a worker");
+            exit(EXIT_FAILURE);
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            bench_worker(amt, worker, runs, fds[1]);
+        }
+    }
+    close(fds[1]);
+
+    const int total = workers * runs;
+    double *read_secs = calloc((size_t)total, sizeof(double));
+    double *write_secs = calloc((size_t)total, sizeof(double));
+    if (read_secs == NULL || write_secs == NULL) {
+        fprintf(stderr, "ERROR: unable to allocate memory for the results.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int reads = 0, writes = 0, read_failed = 0, write_failed = 0;
+    bench_result result;
+    while (read(fds[0], &result, sizeof(result)) == (ssize_t)sizeof(result)) {
+        if (result.writer) {
+            write_secs[writes++] = result.secs;
+            write_failed += !result.ok;
+        } else {
+            read_secs[reads++] = result.secs;
+            read_failed += !result.ok;
+        }
+    }
+    while (wait(NULL) > 0) {
+    }
+    double elapsed = now_secs() - start;
+
+    const long long after = count_records(argv[2]);
+    const long long expected = before + (writes - write_failed);
+
+    printf("\nWorkers: %d (%d adding records)  runs each: %d  elapsed: %.2f s\n\n", workers,
+           (workers + BENCH_WRITER_EVERY - 1) / BENCH_WRITER_EVERY, runs, elapsed);
+    bench_report("search", read_secs, reads, read_failed);
+    bench_report("add", write_secs, writes, write_failed);
+    printf("\nRecords: %lld before, %lld after, %lld expected\n", before, after, expected);
+
+    free(read_secs);
+    free(write_secs);
+
+    if (read_failed > 0 || write_failed > 0 || reads + writes != total || after != expected) {
+        printf("\nFAILED\n");
+        return EXIT_FAILURE;
+    }
+    printf("\nPASSED\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,305 @@
+/**
+ * @file amt-bench-keystroke.c
+ * @brief Acronym Management Tool (amt). Benchmark of how quickly the line editor shows each key typed.
+ * @details Runs 'amt -n' on a pseudo terminal, as if a person were adding a record, and types a long description
+ * one key at a time. For each key the time until amt has finished redrawing the line, and the bytes it wrote to the
+ * terminal, are recorded. The same description is then pasted in one go, as a terminal does for a paste, and the
+ * total time and bytes are recorded. The record is never saved, so the database is not changed. The percentiles of
+ * the key times are shown for the first and last quarter of the description, as well as for every key, so a redraw
+ * that grows with the length of the line shows up as a difference between the two.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note Build with CMake as target 'amt-bench-keystroke', or directly with
+ * @code cc -O2 -Wall -std=gnu11 -o amt-bench-keystroke ./bench/amt-bench-keystroke.c
+ * @note Usage: amt-bench-keystroke <amt program> <database> [description length] [runs]
+ * @code ./amt-bench-keystroke ./bin/amt ~/.acronyms.db 2000 5
+ * @note The terminal is 80 columns by 24 rows. The time for a key ends when amt has written nothing more for
+ * 'BENCH_QUIET_MS', and that quiet time is not counted.
+ */
+
+#define _GNU_SOURCE /* posix_openpt ptsname memmem on glibc */
+
+#include <errno.h>     /* errno */
+#include <fcntl.h>     /* open posix_openpt */
+#include <poll.h>      /* poll */
+#include <signal.h>    /* kill */
+#include <stdbool.h>   /* bool */
+#include <stdio.h>     /* printf */
+#include <stdlib.h>    /* exit qsort setenv grantpt */
+#include <string.h>    /* memmem strerror */
+#include <sys/ioctl.h> /* ioctl TIOCSWINSZ */
+#include <sys/wait.h>  /* waitpid */
+#include <termios.h>   /* struct winsize */
+#include <time.h>      /* clock_gettime */
+#include <unistd.h>    /* fork read write */
+
+#define BENCH_DESC_LEN 2000    /** @note characters in the description typed, unless given */
+#define BENCH_RUNS 3           /** @note times the description is typed, unless given */
+#define BENCH_QUIET_MS 2       /** @note no output for this long means amt has finished with a key */
+#define BENCH_PROMPT_SECS 10.0 /** @note longest wait for amt to show a prompt */
+#define BENCH_COLS 80          /** @note columns of the pseudo terminal */
+#define BENCH_ROWS 24          /** @note rows of the pseudo terminal */
+
+/** @note the time and terminal output of one key typed */
+typedef struct bench_key {
+    double secs;
+    size_t bytes;
+} bench_key;
+
+static double now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/** @note start 'amt -n' with a new pseudo terminal as its stdin, stdout and stderr. Returns the terminal master */
+static int bench_spawn(const char *amt, pid_t *pid)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("ERROR: unable to create a pseudo terminal");
+        exit(EXIT_FAILURE);
+    }
+    const char *slave_name = ptsname(master);
+    struct winsize size = {.ws_row = BENCH_ROWS, .ws_col = BENCH_COLS};
+    ioctl(master, TIOCSWINSZ, &size);
+
+    *pid = fork();
+    if (*pid < 0) {
+        perror("ERROR: unable to start amt");
+        exit(EXIT_FAILURE);
+    }
+    if (*pid == 0) {
+        setsid();
+        int slave = open(slave_name, O_RDWR);
+        if (slave < 0) {
+            _exit(EXIT_FAILURE);
+        }
+        ioctl(slave, TIOCSCTTY, 0);
+        dup2(slave, STDIN_FILENO);
+        dup2(slave, STDOUT_FILENO);
+        dup2(slave, STDERR_FILENO);
+        close(slave);
+        close(master);
+        execl(amt, amt, "-n", (char *)NULL);
+        _exit(EXIT_FAILURE);
+    }
+    return master;
+}
+
+/** @note read all amt writes until it has been quiet for 'BENCH_QUIET_MS'. Returns the bytes read, and sets 'last'
+ * to the time the last of them arrived. The first output may take up to 'wait_ms' to arrive */
+static size_t bench_drain(int master, int wait_ms, double *last)
+{
+    char buf[65536];
+    size_t total = 0;
+    struct pollfd pfd = {.fd = master, .events = POLLIN};
+
+    while (poll(&pfd, 1, total == 0 ? wait_ms : BENCH_QUIET_MS) > 0) {
+        ssize_t got = read(master, buf, sizeof(buf));
+        if (got <= 0) {
+            break;
+        }
+        total += (size_t)got;
+        *last = now_secs();
+    }
+    return total;
+}
+
+/** @note read amt output until 'text' is seen, or exit if it is not seen in time */
+static void bench_expect(int master, const char *text)
+{
+    char buf[65536];
+    size_t used = 0;
+    const size_t len = strlen(text);
+    const double end = now_secs() + BENCH_PROMPT_SECS;
+    struct pollfd pfd = {.fd = master, .events = POLLIN};
+
+    while (now_secs() < end) {
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+        ssize_t got = read(master, buf + used, sizeof(buf) - used);
+        if (got <= 0) {
+            break;
+        }
+        used += (size_t)got;
+        if (memmem(buf, used, text, len) != NULL) {
+            return;
+        }
+        /** @note keep only the end of the output, where the text may have started */
+        if (used > sizeof(buf) / 2) {
+            memmove(buf, buf + used - len, len);
+            used = len;
+        }
+    }
+    fprintf(stderr, "ERROR: amt did not show '%s'. Is the database given a valid amt database?\n", text);
+    exit(EXIT_FAILURE);
+}
+
+static void bench_write(int master, const char *text, size_t len)
+{
+    while (len > 0) {
+        ssize_t put = write(master, text, len);
+        if (put < 0 && errno == EINTR) {
+            continue;
+        }
+        if (put <= 0) {
+            perror("ERROR: unable to write to amt");
+            exit(EXIT_FAILURE);
+        }
+        text += put;
+        len -= (size_t)put;
+    }
+}
+
+/** @note a made up description of words of two to nine lower case letters, the same for every run */
+static void bench_description(char *desc, size_t len)
+{
+    unsigned int seed = 12345;
+    size_t i = 0;
+    while (i < len) {
+        seed = seed * 1103515245u + 12345u;
+        size_t word = 2 + (seed >> 16) % 8;
+        for (size_t j = 0; j < word && i < len; j++) {
+            seed = seed * 1103515245u + 12345u;
+            desc[i++] = (char)('a' + (seed >> 16) % 26);
+        }
+        if (i < len) {
+            desc[i++] = ' ';
+        }
+    }
+    desc[len] = '\0';
+}
+
+/** @note go through 'amt -n' to the description prompt, ready for it to be typed */
+static int bench_to_description(const char *amt, pid_t *pid)
+{
+    double last;
+    int master = bench_spawn(amt, pid);
+    bench_expect(master, "Enter the acronym: ");
+    bench_write(master, "BENCH\r", 6);
+    bench_expect(master, "Enter the expanded acronym: ");
+    bench_write(master, "Keystroke benchmark\r", 20);
+    bench_expect(master, "Enter the acronym description:");
+    bench_drain(master, 100, &last);
+    return master;
+}
+
+/** @note finish the record and answer 'q' so it is not saved, then wait for amt to end */
+static void bench_finish(int master, pid_t pid)
+{
+    bench_write(master, "\r", 1);
+    bench_expect(master, "Enter the acronym source: ");
+    bench_write(master, "Bench\r", 6);
+    bench_expect(master, "Enter record?");
+    bench_write(master, "q\r", 2);
+
+    double last;
+    bench_drain(master, 1000, &last);
+    close(master);
+    if (waitpid(pid, NULL, 0) != pid) {
+        kill(pid, SIGKILL);
+    }
+}
+
+static int compare_secs(const void *a, const void *b)
+{
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+/** @note output the key time percentiles, and the bytes written, of the keys 'from' up to 'to' of every run */
+static void bench_report(const char *name, bench_key *keys, size_t len, int runs, size_t from, size_t to)
+{
+    const size_t count = (to - from) * (size_t)runs;
+    double *secs = calloc(count, sizeof(double));
+    if (secs == NULL) {
+        fprintf(stderr, "ERROR: unable to allocate memory for the results.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t n = 0, bytes = 0, most = 0;
+    for (int run = 0; run < runs; run++) {
+        for (size_t i = from; i < to; i++) {
+            const bench_key *key = &keys[(size_t)run * len + i];
+            secs[n++] = key->secs;
+            bytes += key->bytes;
+            most = (key->bytes > most) ? key->bytes : most;
+        }
+    }
+    qsort(secs, count, sizeof(double), compare_secs);
+    printf("%-14s p50 %8.1f us  p90 %8.1f us  p99 %8.1f us  max %8.1f us  bytes/key %8.1f  max %6zu\n", name,
+           secs[count / 2] * 1e6, secs[(count * 9) / 10] * 1e6, secs[(count * 99) / 100] * 1e6,
+           secs[count - 1] * 1e6, (double)bytes / (double)count, most);
+    free(secs);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <amt program> <database> [description length] [runs]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    const char *amt = argv[1];
+    const long len = (argc > 3) ? atol(argv[3]) : BENCH_DESC_LEN;
+    const int runs = (argc > 4) ? atoi(argv[4]) : BENCH_RUNS;
+    if (len < 4 || len > 4000 || runs < 1) {
+        fprintf(stderr, "ERROR: the description length must be from 4 to 4000, and the runs at least one.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    /** @note every run uses the database given directly, on a terminal amt knows how to draw on */
+    setenv("ACRODB", argv[2], 1);
+    setenv("AMT_SOCKET", "", 1);
+    setenv("TERM", "xterm", 1);
+
+    char *desc = malloc((size_t)len + 1);
+    bench_key *keys = calloc((size_t)len * (size_t)runs, sizeof(bench_key));
+    if (desc == NULL || keys == NULL) {
+        fprintf(stderr, "ERROR: unable to allocate memory for the results.\n");
+        exit(EXIT_FAILURE);
+    }
+    bench_description(desc, (size_t)len);
+
+    double paste_secs = 0.0;
+    size_t paste_bytes = 0;
+
+    for (int run = 0; run < runs; run++) {
+        pid_t pid;
+        int master = bench_to_description(amt, &pid);
+        for (long i = 0; i < len; i++) {
+            bench_key *key = &keys[(size_t)run * (size_t)len + (size_t)i];
+            const double start = now_secs();
+            double last = start;
+            bench_write(master, &desc[i], 1);
+            key->bytes = bench_drain(master, 1000, &last);
+            key->secs = last - start;
+        }
+        bench_finish(master, pid);
+
+        /** @note the paste: all the description written at once, timed until amt has shown all of it */
+        master = bench_to_description(amt, &pid);
+        const double start = now_secs();
+        double last = start;
+        bench_write(master, desc, (size_t)len);
+        paste_bytes += bench_drain(master, 1000, &last);
+        paste_secs += last - start;
+        bench_finish(master, pid);
+    }
+
+    printf("\nDescription of '%ld' characters typed '%d' times on a %dx%d terminal\n\n", len, runs, BENCH_COLS,
+           BENCH_ROWS);
+    bench_report("first quarter", keys, (size_t)len, runs, 0, (size_t)len / 4);
+    bench_report("last quarter", keys, (size_t)len, runs, (size_t)len - (size_t)len / 4, (size_t)len);
+    bench_report("every key", keys, (size_t)len, runs, 0, (size_t)len);
+    printf("\npasted         %10.2f ms  bytes %10.1f\n\n", paste_secs * 1000.0 / runs, (double)paste_bytes / runs);
+
+    free(keys);
+    free(desc);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file amt-bench-output.c
+ * @brief Acronym Management Tool (amt). Benchmark of the record output used by searches.
+ * @details Runs the same search query over an acronyms database and outputs every record found, first with the
+ * original 'printf()' per field, and then with the buffered writer in 'amt-output.c'. The records are written to
+ * '/dev/null' (or the file given) so only the cost of formatting and writing them is measured. The 'printf()' output
+ * is run both line buffered, as when stdout is a terminal, and fully buffered, as when it is a pipe or file. The best
+ * of several runs of each is reported in rows per second, along with the time spent on output alone.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note Build with CMake as target 'amt-bench-output', or directly with
+ * @code cc -O2 -Wall -std=gnu11 -I./src -o amt-bench-output ./bench/amt-bench-output.c ./src/amt-output.c
+ * ./src/sqlite3.c -lpthread -ldl -lm
+ * @note Usage: amt-bench-output <database> [search pattern] [output file]
+ * @code ./amt-bench-output ./acronyms.db '%'
+ */
+
+#include "amt-output.h" /** @note the buffered writer being measured */
+#include "sqlite3.h"    /** @note SQLite database C amalgamation header */
+
+#include <fcntl.h>   /* open */
+#include <stdio.h>   /* printf */
+#include <stdlib.h>  /* exit */
+#include <time.h>    /* clock_gettime */
+#include <unistd.h>  /* dup2 */
+
+#define BENCH_RUNS 5 /** @note runs of each method, of which the fastest is reported */
+
+/** @note the query run by 'do_acronym_search()' when the search pattern includes wildcards */
+static const char bench_sql[] = "select rowid,ifnull(Acronym,''), ifnull(Definition,''), ifnull(Source,''), "
+                                "ifnull(Description,''), ifnull(Changed,'') from ACRONYMS "
+                                "where Acronym like ?1 COLLATE NOCASE ORDER BY Source;";
+
+static double now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/** @note record output as it was done before the buffered writer was added */
+static void output_printf(sqlite3_stmt *stmt)
+{
+    printf("\nID:          %s\n", (const char *)sqlite3_column_text(stmt, 0));
+    printf("ACRONYM:     '%s' is: '%s'.\n",
+           (const char *)sqlite3_column_text(stmt, 1),
+           (const char *)sqlite3_column_text(stmt, 2));
+    printf("SOURCE:      '%s'\n",
+           (const char *)sqlite3_column_text(stmt, 3));
+    printf("LAST UPDATE: %s\n", (const char *)sqlite3_column_text(stmt, 5));
+    printf("DESCRIPTION: %s\n", (const char *)sqlite3_column_text(stmt, 4));
+}
+
+/** @note the ways of outputting records that are compared */
+typedef enum { BENCH_NONE, BENCH_PRINTF_LINE, BENCH_PRINTF_FULL, BENCH_BUFFERED, BENCH_METHODS } bench_method;
+
+static const char *bench_names[BENCH_METHODS] = {
+    [BENCH_NONE] = "query only",
+    [BENCH_PRINTF_LINE] = "printf, line buffered (as on a terminal)",
+    [BENCH_PRINTF_FULL] = "printf, fully buffered (as to a pipe)",
+    [BENCH_BUFFERED] = "buffered writer",
+};
+
+/** @note run the query once, outputting each row with the 'method' given. Returns the rows output */
+static long long bench_run(sqlite3_stmt *stmt, bench_method method, double *secs)
+{
+    static char stdio_buf[BUFSIZ];
+    long long rows = 0;
+
+    fflush(stdout);
+    setvbuf(stdout, stdio_buf, (method == BENCH_PRINTF_LINE) ? _IOLBF : _IOFBF, sizeof(stdio_buf));
+
+    double start = now_secs();
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        switch (method) {
+        case BENCH_PRINTF_LINE:
+        case BENCH_PRINTF_FULL:
+            output_printf(stmt);
+            break;
+        case BENCH_BUFFERED:
+            outbuf_record(stmt);
+            break;
+        default:
+            break;
+        }
+        rows++;
+    }
+    outbuf_flush();
+    fflush(stdout);
+
+    *secs = now_secs() - start;
+    sqlite3_reset(stmt);
+    return rows;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <database> [search pattern] [output file]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    const char *pattern = (argc > 2) ? argv[2] : "%";
+    const char *outfile = (argc > 3) ? argv[3] : "/dev/null";
+
+    sqlite3 *db = NULL;
+    sqlite3_stmt *stmt = NULL;
+    if (sqlite3_open_v2(argv[1], &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, bench_sql, -1, &stmt, NULL) != SQLITE_OK ||
+        sqlite3_bind_text(stmt, 1, pattern, -1, SQLITE_STATIC) != SQLITE_OK) {
+        fprintf(stderr, "ERROR: unable to query database '%s': %s\n", argv[1], sqlite3_errmsg(db));
+        exit(EXIT_FAILURE);
+    }
+
+    int fd = open(outfile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || dup2(fd, STDOUT_FILENO) < 0) {
+        perror("ERROR: unable to open the output file");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+
+    /** @note a first untimed run so every method starts with the database pages cached */
+    double secs;
+    long long rows = bench_run(stmt, BENCH_NONE, &secs);
+
+    double best[BENCH_METHODS] = {0};
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        for (int method = 0; method < BENCH_METHODS; method++) {
+            bench_run(stmt, (bench_method)method, &secs);
+            if (run == 0 || secs < best[method]) {
+                best[method] = secs;
+            }
+        }
+    }
+
+    fprintf(stderr, "\nRecords output for search '%s': %lld (best of %d runs to '%s')\n\n", pattern, rows,
+            BENCH_RUNS, outfile);
+    for (int method = 0; method < BENCH_METHODS; method++) {
+        /** @note the time spent on output alone, with the query time measured by 'query only' taken off */
+        double output = best[method] - best[BENCH_NONE];
+        fprintf(stderr, "%-42s %10.3f ms %12.0f rows/sec", bench_names[method], best[method] * 1000.0,
+                best[method] > 0 ? (double)rows / best[method] : 0.0);
+        if (method != BENCH_NONE) {
+            fprintf(stderr, "   output %10.3f ms", output * 1000.0);
+        }
+        fprintf(stderr, "\n");
+    }
+
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return EXIT_SUCCESS;
+}
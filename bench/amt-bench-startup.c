@@ -0,0 +1,307 @@
+/**
+ * @file amt-bench-startup.c
+ * @brief Acronym Management Tool (amt). Benchmark of how long amt takes to start and answer, by database size.
+ * @details Creates acronym databases of several sizes, and times the 'amt' program given from start to exit for a
+ * search with '-s', the latest records with '-l', and the database summary shown when no command is given. Each is
+ * run with the database pages cached by the operating system (warm), and with them dropped from the cache before
+ * every run (cold). The percentiles of the run times are written one JSON object per line to the results file, and
+ * shown in a table, so results from different builds can be compared.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note Build with CMake as target 'amt-bench-startup', or directly with
+ * @code cc -O2 -Wall -std=gnu11 -I./src -o amt-bench-startup ./bench/amt-bench-startup.c ./src/sqlite3.c
+ * -lpthread -ldl -lm
+ * @note Usage: amt-bench-startup <amt program> <database directory> [runs] [results file] [rows ...]
+ * @code ./amt-bench-startup ./bin/amt /tmp/amt-bench 50 startup.ndjson 1000 100000
+ * @note The databases are named 'amt-bench-<rows>.db' in the directory given, and are kept for later runs. Each
+ * line of the results file is like:
+ * @code {"rows":1000,"command":"-s","cache":"warm","runs":50,"p50_ms":1.21,"p90_ms":1.40,"p99_ms":1.90,"max_ms":2.02}
+ * @note The cold runs drop the pages with 'posix_fadvise(POSIX_FADV_DONTNEED)', which needs no special permission
+ * but only drops pages that are not in use, and leaves the program and SQLite library cached.
+ */
+
+#include "sqlite3.h" /** @note SQLite database C amalgamation header */
+
+#include <fcntl.h>     /* open posix_fadvise */
+#include <spawn.h>     /* posix_spawn */
+#include <stdbool.h>   /* bool */
+#include <stdio.h>     /* printf */
+#include <stdlib.h>    /* exit qsort setenv */
+#include <string.h>    /* strerror */
+#include <sys/stat.h>  /* mkdir */
+#include <sys/wait.h>  /* waitpid */
+#include <time.h>      /* clock_gettime */
+#include <unistd.h>    /* close */
+
+#define BENCH_RUNS 20          /** @note timed runs of each command, unless given */
+#define BENCH_BATCH_ROWS 50000 /** @note rows inserted in each transaction when creating a database */
+#define BENCH_SOURCES 50       /** @note number of different sources given to the records created */
+
+extern char **environ;
+
+/** @note database sizes used when none are given */
+static const long long bench_sizes[] = {1000, 100000, 1000000, 10000000};
+
+/** @note the commands timed. The summary is shown, with an error, when no command is given */
+typedef enum { BENCH_SEARCH, BENCH_LATEST, BENCH_SUMMARY, BENCH_COMMANDS } bench_command;
+
+static const char *bench_names[BENCH_COMMANDS] = {
+    [BENCH_SEARCH] = "-s",
+    [BENCH_LATEST] = "-l",
+    [BENCH_SUMMARY] = "summary",
+};
+
+static double now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/** @note the acronym of record 'n': 'A', 'B' ... 'Z', 'AA', 'AB' ... so every record has a different acronym */
+static void bench_acronym(long long n, char *acronym, size_t size)
+{
+    char reversed[16];
+    size_t len = 0;
+    do {
+        reversed[len++] = (char)('A' + n % 26);
+        n = n / 26 - 1;
+    } while (n >= 0 && len < sizeof(reversed) - 1);
+
+    size_t i = 0;
+    for (; i < len && i < size - 1; i++) {
+        acronym[i] = reversed[len - 1 - i];
+    }
+    acronym[i] = '\0';
+}
+
+/** @note create a database of 'rows' records, unless one of that size is already there */
+static bool bench_create(const char *dbfile, long long rows)
+{
+    sqlite3 *db = NULL;
+    sqlite3_stmt *stmt = NULL;
+    long long have = -1;
+
+    if (sqlite3_open_v2(dbfile, &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) != SQLITE_OK) {
+        fprintf(stderr, "ERROR: unable to create '%s': %s\n", dbfile, sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return false;
+    }
+    if (sqlite3_prepare_v2(db, "select count(*) from ACRONYMS;", -1, &stmt, NULL) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW) {
+        have = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    stmt = NULL;
+    if (have == rows) {
+        sqlite3_close(db);
+        return true;
+    }
+
+    fprintf(stderr, "Creating '%s' with %lld records...\n", dbfile, rows);
+    bool result = sqlite3_exec(db, "PRAGMA journal_mode=OFF; PRAGMA synchronous=OFF;"
+                                   "DROP TABLE IF EXISTS ACRONYMS;"
+                                   "CREATE TABLE ACRONYMS (\"Acronym\",\"Definition\",\"Description\",\"Source\","
+                                   "\"Changed\");"
+                                   "BEGIN;", NULL, NULL, NULL) == SQLITE_OK &&
+                  sqlite3_prepare_v2(db, "insert into ACRONYMS(Acronym, Definition, Description, Source, Changed) "
+                                         "values(?,?,?,?,datetime('now'));", -1, &stmt, NULL) == SQLITE_OK;
+
+    char acronym[16], definition[64], description[128], source[32];
+    for (long long n = 0; result && n < rows; n++) {
+        bench_acronym(n, acronym, sizeof(acronym));
+        snprintf(definition, sizeof(definition), "Definition of %s number %lld", acronym, n);
+        snprintf(description, sizeof(description), "Record %lld created to measure how long amt takes to start", n);
+        snprintf(source, sizeof(source), "Source %lld", n % BENCH_SOURCES);
+        sqlite3_bind_text(stmt, 1, acronym, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, definition, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, description, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 4, source, -1, SQLITE_STATIC);
+        result = sqlite3_step(stmt) == SQLITE_DONE && sqlite3_reset(stmt) == SQLITE_OK;
+        if (result && (n + 1) % BENCH_BATCH_ROWS == 0) {
+            result = sqlite3_exec(db, "COMMIT; BEGIN;", NULL, NULL, NULL) == SQLITE_OK;
+        }
+    }
+    if (result) {
+        result = sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL) == SQLITE_OK;
+    }
+    if (!result) {
+        fprintf(stderr, "ERROR: unable to create '%s': %s\n", dbfile, sqlite3_errmsg(db));
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return result;
+}
+
+/** @note drop the database files from the operating systems page cache */
+static void bench_uncache(const char *dbfile)
+{
+    static const char *suffixes[] = {"", "-wal", "-shm"};
+    char path[4096];
+
+    for (size_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+        snprintf(path, sizeof(path), "%s%s", dbfile, suffixes[i]);
+        int fd = open(path, O_RDONLY);
+        if (fd >= 0) {
+            fdatasync(fd);
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            close(fd);
+        }
+    }
+}
+
+/** @note run the 'amt' program once with its output sent to '/dev/null'. Returns the run time, or -1 on failure */
+static double bench_run(char *const args[], bool check_status)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    pid_t pid;
+    int status = -1;
+    double start = now_secs();
+    int rc = posix_spawn(&pid, args[0], &actions, NULL, args, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (rc != 0) {
+        fprintf(stderr, "ERROR: unable to run '%s': %s\n", args[0], strerror(rc));
+        return -1.0;
+    }
+    waitpid(pid, &status, 0);
+    double secs = now_secs() - start;
+
+    if (!WIFEXITED(status) || (check_status && WEXITSTATUS(status) != 0)) {
+        return -1.0;
+    }
+    return secs;
+}
+
+static int compare_secs(const void *a, const void *b)
+{
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+/** @note the 'percent' percentile of the sorted run times, in milliseconds, by the nearest rank method */
+static double bench_percentile(const double *secs, int count, int percent)
+{
+    int rank = (count * percent + 99) / 100;
+    return secs[(rank > 0 ? rank : 1) - 1] * 1000.0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <amt program> <database directory> [runs] [results file] [rows ...]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    const int runs = (argc > 3) ? atoi(argv[3]) : BENCH_RUNS;
+    const char *results_file = (argc > 4) ? argv[4] : "amt-bench-startup.ndjson";
+    if (runs < 1) {
+        fprintf(stderr, "ERROR: the number of runs must be at least one.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int nsizes = (argc > 5) ? argc - 5 : (int)(sizeof(bench_sizes) / sizeof(bench_sizes[0]));
+    long long *sizes = calloc((size_t)nsizes, sizeof(long long));
+    double *secs = calloc((size_t)runs, sizeof(double));
+    if (sizes == NULL || secs == NULL) {
+        fprintf(stderr, "ERROR: unable to allocate memory for the results.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < nsizes; i++) {
+        sizes[i] = (argc > 5) ? atoll(argv[5 + i]) : bench_sizes[i];
+        if (sizes[i] < 1) {
+            fprintf(stderr, "ERROR: '%s' is not a number of rows.\n", argv[5 + i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    mkdir(argv[2], 0755);
+    FILE *results = fopen(results_file, "w");
+    if (results == NULL) {
+        perror("ERROR: unable to create the results file");
+        exit(EXIT_FAILURE);
+    }
+
+    /** @note every run uses the database given directly, not a server that may be running */
+    setenv("AMT_SOCKET", "", 1);
+
+    printf("\n%12s %-8s %-5s %10s %10s %10s %10s\n", "rows", "command", "cache", "p50 ms", "p90 ms", "p99 ms",
+           "max ms");
+    bool result = true;
+
+    for (int s = 0; s < nsizes && result; s++) {
+        char dbfile[4096];
+        snprintf(dbfile, sizeof(dbfile), "%s/amt-bench-%lld.db", argv[2], sizes[s]);
+        if (!bench_create(dbfile, sizes[s])) {
+            result = false;
+            break;
+        }
+        setenv("ACRODB", dbfile, 1);
+
+        /** @note search for the acronym of the middle record, so it is found by every run */
+        char acronym[16];
+        bench_acronym(sizes[s] / 2, acronym, sizeof(acronym));
+        char *const search_args[] = {argv[1], "-s", acronym, NULL};
+        char *const latest_args[] = {argv[1], "-l", NULL};
+        char *const summary_args[] = {argv[1], NULL};
+        char *const *command_args[BENCH_COMMANDS] = {
+            [BENCH_SEARCH] = search_args,
+            [BENCH_LATEST] = latest_args,
+            [BENCH_SUMMARY] = summary_args,
+        };
+
+        /** @note an untimed first run adds the tables and index amt creates on first use, so are not measured */
+        if (bench_run(command_args[BENCH_SEARCH], true) < 0) {
+            fprintf(stderr, "ERROR: '%s -s %s' failed for '%s'.\n", argv[1], acronym, dbfile);
+            result = false;
+            break;
+        }
+
+        for (int cold = 0; cold <= 1 && result; cold++) {
+            for (int c = 0; c < BENCH_COMMANDS && result; c++) {
+                for (int run = 0; run < runs; run++) {
+                    if (cold) {
+                        bench_uncache(dbfile);
+                    }
+                    /** @note the summary is shown with an error status, as no command was given */
+                    secs[run] = bench_run(command_args[c], c != BENCH_SUMMARY);
+                    if (secs[run] < 0) {
+                        fprintf(stderr, "ERROR: '%s %s' failed for '%s'.\n", argv[1], bench_names[c], dbfile);
+                        result = false;
+                        break;
+                    }
+                }
+                if (!result) {
+                    break;
+                }
+
+                qsort(secs, (size_t)runs, sizeof(double), compare_secs);
+                const char *cache = cold ? "cold" : "warm";
+                fprintf(results, "{\"rows\":%lld,\"command\":\"%s\",\"cache\":\"%s\",\"runs\":%d,"
+                                 "\"p50_ms\":%.3f,\"p90_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f}\n",
+                        sizes[s], bench_names[c], cache, runs, bench_percentile(secs, runs, 50),
+                        bench_percentile(secs, runs, 90), bench_percentile(secs, runs, 99), secs[runs - 1] * 1000.0);
+                printf("%12lld %-8s %-5s %10.2f %10.2f %10.2f %10.2f\n", sizes[s], bench_names[c], cache,
+                       bench_percentile(secs, runs, 50), bench_percentile(secs, runs, 90),
+                       bench_percentile(secs, runs, 99), secs[runs - 1] * 1000.0);
+                fflush(stdout);
+            }
+        }
+    }
+
+    fclose(results);
+    free(sizes);
+    free(secs);
+
+    if (!result) {
+        return EXIT_FAILURE;
+    }
+    printf("\nResults written to '%s'\n", results_file);
+    return EXIT_SUCCESS;
+}
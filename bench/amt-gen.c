@@ -0,0 +1,372 @@
+/**
+ * @file amt-gen.c
+ * @brief Acronym Management Tool (amt). Creates an acronyms database of made up records for benchmarks and load tests.
+ * @details Writes the number of records asked for into a new 'ACRONYMS' table. The records are made to look like a
+ * real acronyms database, so results measured with them are close to those of one that can not be shared:
+ * - acronyms are mostly three or four capital letters, ranging from two to eight, and a few include a digit or '&'.
+ * - the definition has a word starting with each letter of the acronym.
+ * - some acronyms are used again with another definition from another source, the most common ones most often.
+ * - sources follow a long tail: a few are used by many records, and most by only a few.
+ * - descriptions are often empty and mostly short, but some run to several KB.
+ * - the time each record was changed is spread over the ten years before the run.
+ * The same seed always gives the same database.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note Build with CMake as target 'amt-gen', or directly with
+ * @code cc -O2 -Wall -std=gnu11 -I./src -o amt-gen ./bench/amt-gen.c ./src/sqlite3.c -lpthread -ldl -lm
+ * @note Usage: amt-gen <database> [rows] [seed] [sources]
+ * @code ./amt-gen /tmp/acronyms-10m.db 10000000 42
+ * @note The database must not already exist. A database amt has used holds more than the 'ACRONYMS' table, such as
+ * its record counts, search indexes and the triggers that keep them up to date, which would no longer match the new
+ * records, so it is not changed. Remove it first to make it again.
+ */
+
+#include "sqlite3.h" /** @note SQLite database C amalgamation header */
+
+#include <math.h>      /* pow log exp sqrt */
+#include <stdbool.h>   /* bool */
+#include <stdint.h>    /* uint64_t */
+#include <stdio.h>     /* printf */
+#include <stdlib.h>    /* exit strtoll strtoull */
+#include <string.h>    /* memcpy strlen */
+#include <time.h>      /* clock_gettime time */
+#include <unistd.h>    /* access */
+
+#define GEN_ROWS 100000          /** @note records created, unless given */
+#define GEN_SEED 1               /** @note random number seed, unless given */
+#define GEN_SOURCES 2000         /** @note number of different sources, unless given */
+#define GEN_BATCH_ROWS 100000    /** @note records inserted in each transaction */
+#define GEN_REUSE_PERCENT 15     /** @note records that use an acronym already given to another record */
+#define GEN_REUSE_POOL 65536     /** @note recent acronyms kept to be used again */
+#define GEN_ZIPF_EXPONENT 1.1    /** @note how steeply the use of sources falls away: higher is steeper */
+#define GEN_MAX_DESCRIPTION 6144 /** @note longest description, in bytes */
+#define GEN_MAX_ACRONYM 8        /** @note longest acronym, in characters */
+
+/** @note words the definitions and descriptions are made from, by first letter. 'X' is often 'Ex', as in 'XML' */
+static const char *gen_words[26][6] = {
+    {"Advanced", "Automated", "Application", "Agency", "Access", "Analysis"},
+    {"Business", "Base", "Board", "Broadband", "Binary", "Bureau"},
+    {"Control", "Central", "Computer", "Council", "Command", "Channel"},
+    {"Data", "Defence", "Digital", "Department", "Design", "Device"},
+    {"Electronic", "European", "Engineering", "Exchange", "Energy", "Environment"},
+    {"Federal", "Function", "Field", "Force", "Framework", "Frequency"},
+    {"General", "Global", "Group", "Ground", "Graphics", "Gateway"},
+    {"High", "Health", "Hardware", "Host", "House", "Human"},
+    {"International", "Information", "Integrated", "Interface", "Internet", "Intelligence"},
+    {"Joint", "Journal", "Junction", "Job", "Justice", "Java"},
+    {"Key", "Kernel", "Knowledge", "Kit", "Keyboard", "Kinetic"},
+    {"Local", "Logic", "Line", "Layer", "Language", "Link"},
+    {"Management", "Military", "Memory", "Mobile", "Module", "Media"},
+    {"National", "Network", "Naval", "Node", "North", "Number"},
+    {"Operations", "Office", "Object", "Open", "Optical", "Organisation"},
+    {"Protocol", "Program", "Processing", "Public", "Power", "Policy"},
+    {"Quality", "Query", "Queue", "Quick", "Quantum", "Quarter"},
+    {"Research", "Remote", "Resource", "Radio", "Regional", "Reference"},
+    {"System", "Service", "Security", "Standard", "Software", "Support"},
+    {"Technology", "Transfer", "Terminal", "Test", "Transport", "Treaty"},
+    {"Unit", "United", "Universal", "User", "Update", "Utility"},
+    {"Virtual", "Vehicle", "Video", "Value", "Version", "Voice"},
+    {"Wireless", "Wide", "Web", "Working", "Warfare", "World"},
+    {"Extended", "Exchange", "Express", "Xenon", "X-ray", "Experimental"},
+    {"Year", "Yield", "Young", "Yard", "Yellow", "Youth"},
+    {"Zone", "Zero", "Zonal", "Zoom", "Zulu", "Zenith"},
+};
+
+/** @note words used to make up source names */
+static const char *gen_source_words[] = {
+    "Defence", "Finance", "Networking", "Medical", "Aviation", "Legal", "Computing", "Telecoms", "Education",
+    "Energy", "Logistics", "Marine", "Science", "Space", "Retail", "Policing", "Insurance", "Rail", "Media", "Army",
+};
+#define GEN_SOURCE_WORDS (sizeof(gen_source_words) / sizeof(gen_source_words[0]))
+
+/** @note state of the 'xoshiro256**' random number generator */
+static uint64_t gen_state[4];
+
+static uint64_t gen_rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t gen_next(void)
+{
+    const uint64_t result = gen_rotl(gen_state[1] * 5, 7) * 9;
+    const uint64_t t = gen_state[1] << 17;
+    gen_state[2] ^= gen_state[0];
+    gen_state[3] ^= gen_state[1];
+    gen_state[1] ^= gen_state[2];
+    gen_state[0] ^= gen_state[3];
+    gen_state[2] ^= t;
+    gen_state[3] = gen_rotl(gen_state[3], 45);
+    return result;
+}
+
+/** @note fill the generator state from the seed with 'splitmix64', as its authors recommend */
+static void gen_seed(uint64_t seed)
+{
+    for (int i = 0; i < 4; i++) {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        gen_state[i] = z ^ (z >> 31);
+    }
+}
+
+/** @note a random number from 0 to 'n' - 1 */
+static uint64_t gen_below(uint64_t n)
+{
+    return gen_next() % n;
+}
+
+/** @note a random number from 0 up to, but not including, 1 */
+static double gen_unit(void)
+{
+    return (double)(gen_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/** @note a random number from a normal distribution with a mean of 0 and standard deviation of 1 */
+static double gen_normal(void)
+{
+    double u = gen_unit();
+    double v = gen_unit();
+    return sqrt(-2.0 * log(u > 0.0 ? u : 1e-300)) * cos(2.0 * 3.14159265358979323846 * v);
+}
+
+/** @note pick one of 'n' items where item 'k' is picked in proportion to 1 / (k + 1) ^ exponent */
+static size_t gen_zipf(const double *cumulative, size_t n)
+{
+    const double u = gen_unit() * cumulative[n - 1];
+    size_t low = 0;
+    size_t high = n - 1;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (cumulative[mid] <= u) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/** @note make up a new acronym. Returns its length */
+static size_t gen_acronym(char *acronym)
+{
+    /** @note the share of acronyms of each length from two to eight, in percent */
+    static const int lengths[] = {14, 38, 27, 12, 5, 3, 1};
+    int pick = (int)gen_below(100);
+    size_t len = 2;
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]) && pick >= lengths[i]; i++) {
+        pick -= lengths[i];
+        len++;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        acronym[i] = (char)('A' + gen_below(26));
+    }
+    /** @note a few have a digit in place of a letter, as 'B2B', or an '&' as 'R&D' */
+    const uint64_t odd = gen_below(100);
+    if (odd < 4 && len > 2) {
+        acronym[1 + gen_below(len - 1)] = (char)('0' + gen_below(10));
+    } else if (odd < 6 && len == 3) {
+        acronym[1] = '&';
+    }
+    acronym[len] = '\0';
+    return len;
+}
+
+/** @note the definition: a word for each letter of the acronym. Returns its length */
+static size_t gen_definition(const char *acronym, char *definition, size_t size)
+{
+    size_t len = 0;
+    for (const char *c = acronym; *c != '\0'; c++) {
+        const char *word = (*c >= 'A' && *c <= 'Z') ? gen_words[*c - 'A'][gen_below(6)]
+                                                      : (*c == '&' ? "and" : "to");
+        len += (size_t)snprintf(definition + len, size - len, "%s%s", (len > 0) ? " " : "", word);
+        if (len >= size) {
+            return size - 1;
+        }
+    }
+    return len;
+}
+
+/** @note the description: empty for a third, otherwise sentences of words, of a length that is mostly short but
+ * sometimes several KB. Returns its length */
+static size_t gen_description(char *description, size_t size)
+{
+    description[0] = '\0';
+    if (gen_below(3) == 0) {
+        return 0;
+    }
+
+    /** @note a log normal length, with a median of about 120 bytes */
+    double want = exp(4.8 + 1.1 * gen_normal());
+    size_t target = (want >= (double)(size - 1)) ? size - 1 : (size_t)want;
+
+    size_t len = 0;
+    bool start = true;
+    while (len < target) {
+        const char *word = gen_words[gen_below(26)][gen_below(6)];
+        const size_t wlen = strlen(word);
+        if (len + wlen + 2 >= size) {
+            break;
+        }
+        if (!start) {
+            description[len++] = ' ';
+        }
+        memcpy(description + len, word, wlen);
+        if (!start) {
+            description[len] = (char)(description[len] | 0x20); /* lower case inside a sentence */
+        }
+        len += wlen;
+        start = (gen_below(12) == 0);
+        if (start) {
+            description[len++] = '.';
+        }
+    }
+    if (len > 0 && description[len - 1] != '.' && len + 1 < size) {
+        description[len++] = '.';
+    }
+    description[len] = '\0';
+    return len;
+}
+
+static double now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/** @note read a whole number argument, or exit if it is not one */
+static long long gen_number(const char *arg, const char *name, long long least)
+{
+    char *end = NULL;
+    long long value = strtoll(arg, &end, 10);
+    if (end == arg || *end != '\0' || value < least) {
+        fprintf(stderr, "ERROR: the %s '%s' is not a whole number of at least %lld.\n", name, arg, least);
+        exit(EXIT_FAILURE);
+    }
+    return value;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)) {
+        printf("Usage: %s <database> [rows] [seed] [sources]\n", argv[0]);
+        return EXIT_SUCCESS;
+    }
+    if (argc < 2 || argc > 5 || argv[1][0] == '-' || argv[1][0] == '\0') {
+        fprintf(stderr, "Usage: %s <database> [rows] [seed] [sources]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    const long long rows = (argc > 2) ? gen_number(argv[2], "rows", 1) : GEN_ROWS;
+    const uint64_t seed = (argc > 3) ? (uint64_t)gen_number(argv[3], "seed", 0) : GEN_SEED;
+    const long long nsources = (argc > 4) ? gen_number(argv[4], "sources", 1) : GEN_SOURCES;
+
+    /** @note only a new database is made, so no tables, indexes or triggers are left from before */
+    if (access(argv[1], F_OK) == 0) {
+        fprintf(stderr, "ERROR: '%s' already exists. Remove it first to make a new database there.\n", argv[1]);
+        exit(EXIT_FAILURE);
+    }
+    gen_seed(seed);
+
+    /** @note the source names, and the running total of the chance of picking each, for 'gen_zipf()' */
+    char (*sources)[48] = calloc((size_t)nsources, sizeof(*sources));
+    double *cumulative = calloc((size_t)nsources, sizeof(double));
+    char (*pool)[GEN_MAX_ACRONYM + 1] = calloc(GEN_REUSE_POOL, sizeof(*pool));
+    char *description = malloc(GEN_MAX_DESCRIPTION + 1);
+    if (sources == NULL || cumulative == NULL || pool == NULL || description == NULL) {
+        fprintf(stderr, "ERROR: unable to allocate memory for the records.\n");
+        exit(EXIT_FAILURE);
+    }
+    double total = 0.0;
+    for (long long i = 0; i < nsources; i++) {
+        snprintf(sources[i], sizeof(sources[i]), "%s %s %lld", gen_source_words[gen_below(GEN_SOURCE_WORDS)],
+                 (i % 3 == 0) ? "Glossary" : (i % 3 == 1) ? "Handbook" : "Standard", i + 1);
+        total += 1.0 / pow((double)(i + 1), GEN_ZIPF_EXPONENT);
+        cumulative[i] = total;
+    }
+
+    sqlite3 *db = NULL;
+    sqlite3_stmt *stmt = NULL;
+    if (sqlite3_open_v2(argv[1], &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) != SQLITE_OK) {
+        fprintf(stderr, "ERROR: unable to open '%s': %s\n", argv[1], sqlite3_errmsg(db));
+        exit(EXIT_FAILURE);
+    }
+
+    /** @note no journal and no waiting for the disk: if the program fails part way the database is just made again */
+    bool result = sqlite3_exec(db, "PRAGMA journal_mode=OFF; PRAGMA synchronous=OFF; PRAGMA cache_size=-65536;"
+                                   "CREATE TABLE ACRONYMS (\"Acronym\",\"Definition\",\"Description\",\"Source\","
+                                   "\"Changed\");"
+                                   "BEGIN;", NULL, NULL, NULL) == SQLITE_OK &&
+                  sqlite3_prepare_v2(db, "insert into ACRONYMS(Acronym, Definition, Description, Source, Changed) "
+                                         "values(?,?,?,?,?);", -1, &stmt, NULL) == SQLITE_OK;
+
+    const time_t now = time(NULL);
+    const long long span = 10LL * 365 * 24 * 60 * 60;
+    char acronym[GEN_MAX_ACRONYM + 1];
+    char definition[256];
+    char changed[32];
+    size_t pooled = 0;
+    long long reused = 0;
+    double start = now_secs();
+
+    for (long long n = 0; result && n < rows; n++) {
+        size_t alen;
+        if (pooled > 0 && gen_below(100) < GEN_REUSE_PERCENT) {
+            /** @note an acronym given before, picked favouring the most recent so some are used many times */
+            size_t back = gen_zipf(cumulative, (size_t)(pooled < (size_t)nsources ? pooled : (size_t)nsources));
+            size_t slot = (pooled - 1 - back) % GEN_REUSE_POOL;
+            alen = strlen(pool[slot]);
+            memcpy(acronym, pool[slot], alen + 1);
+            reused++;
+        } else {
+            alen = gen_acronym(acronym);
+            memcpy(pool[pooled % GEN_REUSE_POOL], acronym, alen + 1);
+            pooled++;
+        }
+        const size_t dlen = gen_definition(acronym, definition, sizeof(definition));
+        const size_t desclen = gen_description(description, GEN_MAX_DESCRIPTION + 1);
+        const char *source = sources[gen_zipf(cumulative, (size_t)nsources)];
+
+        time_t when = now - (time_t)gen_below((uint64_t)span);
+        struct tm tm;
+        gmtime_r(&when, &tm);
+        const size_t clen = strftime(changed, sizeof(changed), "%Y-%m-%d %H:%M:%S", &tm);
+
+        sqlite3_bind_text(stmt, 1, acronym, (int)alen, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, definition, (int)dlen, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, description, (int)desclen, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 4, source, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 5, changed, (int)clen, SQLITE_STATIC);
+        result = sqlite3_step(stmt) == SQLITE_DONE && sqlite3_reset(stmt) == SQLITE_OK;
+
+        if (result && (n + 1) % GEN_BATCH_ROWS == 0) {
+            result = sqlite3_exec(db, "COMMIT; BEGIN;", NULL, NULL, NULL) == SQLITE_OK;
+            fprintf(stderr, "\r%lld records written", n + 1);
+        }
+    }
+    if (result) {
+        result = sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL) == SQLITE_OK;
+    }
+    if (!result) {
+        fprintf(stderr, "\nERROR: unable to write the records to '%s': %s\n", argv[1], sqlite3_errmsg(db));
+    }
+
+    double secs = now_secs() - start;
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    free(sources);
+    free(cumulative);
+    free(pool);
+    free(description);
+
+    if (!result) {
+        return EXIT_FAILURE;
+    }
+    fprintf(stderr, "\r%lld records written to '%s' in %.2f seconds (%.0f records/sec), %lld with a reused acronym."
+                    "\n", rows, argv[1], secs, (double)rows / (secs > 0.0 ? secs : 1.0), reused);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file amt-alloc.c
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ * @details Program to managed SQLite database containing acronyms. This source code sets up the memory SQLite uses,
+ * before SQLite is first used, for the way amt is being run.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note By default SQLite uses malloc for all of its memory. Set env 'AMT_ALLOC' to 'arena' and SQLite is instead
+ * given one block of memory (its 'memsys5' allocator) sized for the mode amt runs in, with a buffer of page cache
+ * slots and lookaside slots for each connection, so its memory use is fixed when amt starts and does not fragment
+ * the process heap over a long shell session or server run. Use 'arena:<MB>' to give the size, and
+ * 'AMT_ALLOC_COMMAND', 'AMT_ALLOC_SHELL' or 'AMT_ALLOC_SERVER' to choose for one mode only. The page cache is held
+ * to 'AMT_ALLOC_SOFT_LIMIT_PCT' of the arena, so reading a large database reuses cache pages rather than running
+ * out of memory.
+ */
+
+#include "amt-alloc.h"
+
+#include <stdio.h>  /* fprintf */
+#include <stdlib.h> /* getenv malloc strtol */
+#include <string.h> /* strcmp strncmp */
+
+/** @note the SQLite memory given to each mode when the arena is used */
+static const struct alloc_sizes {
+    const char *env;     /* env choosing the allocator for this mode only */
+    int heap_mb;         /* arena size, unless given */
+    int cache_pages;     /* page cache buffer slots */
+    int lookaside_size;  /* bytes in each lookaside slot */
+    int lookaside_count; /* lookaside slots for each connection */
+} alloc_sizes[ALLOC_MODES] = {
+    [ALLOC_COMMAND] = {"AMT_ALLOC_COMMAND", 16, 256, 1200, 40},
+    [ALLOC_SHELL] = {"AMT_ALLOC_SHELL", 32, 512, 1200, 100},
+    [ALLOC_SERVER] = {"AMT_ALLOC_SERVER", 64, 2048, 1200, 200},
+};
+
+/** @note the size of the arena given to SQLite, or zero if it uses malloc */
+static size_t alloc_heap = 0;
+
+
+/**
+ * @brief Set up the memory SQLite uses as chosen by env, for the mode given.
+ * @param alloc_mode mode : the way amt is being run.
+ * @return bool : false if the allocator chosen is not known or can not be set up.
+ * @note Must be called before SQLite is first used. The env for the mode, such as 'AMT_ALLOC_SERVER', is used if it
+ * is set, or else 'AMT_ALLOC'. If neither is set SQLite is left to use malloc.
+ */
+bool alloc_configure(alloc_mode mode)
+{
+    const char *choice = getenv(alloc_sizes[mode].env);
+    if (choice == NULL) {
+        choice = getenv(AMT_ALLOC_ENV);
+    }
+    return alloc_setup(mode, choice);
+}
+
+
+/**
+ * @brief Set up the memory SQLite uses as named, for the mode given.
+ * @param alloc_mode mode : the way amt is being run, which gives the sizes used.
+ * @param const char *choice : 'malloc', 'arena', or 'arena:<MB>' for an arena of the size given. NULL or empty is
+ * the same as 'malloc'.
+ * @return bool : false if the allocator named is not known or can not be set up.
+ * @note Must be called before SQLite is first used. The arena is only in SQLite when it is built with
+ * 'SQLITE_ENABLE_MEMSYS5', as the CMake build does. Without it a warning is shown and malloc is used.
+ */
+bool alloc_setup(alloc_mode mode, const char *choice)
+{
+    if (choice == NULL || choice[0] == '\0' || strcmp(choice, "malloc") == 0) {
+        return true;
+    }
+    if (strncmp(choice, "arena", 5) != 0 || (choice[5] != '\0' && choice[5] != ':')) {
+        fprintf(stderr, "\nERROR: unknown SQLite allocator '%s'. Use one of: malloc, arena, arena:<MB>.\n", choice);
+        return false;
+    }
+
+    const struct alloc_sizes *sizes = &alloc_sizes[mode];
+    long heap_mb = sizes->heap_mb;
+    if (choice[5] == ':') {
+        char *end = NULL;
+        heap_mb = strtol(choice + 6, &end, 10);
+        /** @note SQLite takes the arena size as an 'int' */
+        if (heap_mb < 1 || heap_mb > 2047 || *end != '\0') {
+            fprintf(stderr, "\nERROR: SQLite arena size '%s' is not a number of megabytes from 1 to 2047.\n",
+                    choice + 6);
+            return false;
+        }
+    }
+
+    int hdrsz = 0;
+    sqlite3_config(SQLITE_CONFIG_PCACHE_HDRSZ, &hdrsz);
+    const int slot = AMT_ALLOC_PAGE_SIZE + hdrsz;
+    const size_t heap_bytes = (size_t)heap_mb * 1024 * 1024;
+    void *heap = malloc(heap_bytes);
+    void *pages = malloc((size_t)slot * (size_t)sizes->cache_pages);
+    if (heap == NULL || pages == NULL) {
+        fprintf(stderr, "\nERROR: unable to allocate '%ld' MB of memory for SQLite.\n", heap_mb);
+        free(heap);
+        free(pages);
+        return false;
+    }
+
+    if (sqlite3_config(SQLITE_CONFIG_HEAP, heap, (int)heap_bytes, AMT_ALLOC_MIN_REQ) != SQLITE_OK) {
+        fprintf(stderr, "WARNING: this SQLite was built without its arena allocator, so malloc is used.\n");
+        free(heap);
+        free(pages);
+        return true;
+    }
+    if (sqlite3_config(SQLITE_CONFIG_PAGECACHE, pages, slot, sizes->cache_pages) != SQLITE_OK) {
+        free(pages);
+    }
+    sqlite3_config(SQLITE_CONFIG_LOOKASIDE, sizes->lookaside_size, sizes->lookaside_count);
+
+    /** @note this starts SQLite, so is done last */
+    sqlite3_soft_heap_limit64((sqlite3_int64)(heap_bytes / 100 * AMT_ALLOC_SOFT_LIMIT_PCT));
+    alloc_heap = heap_bytes;
+    return true;
+}
+
+
+/**
+ * @brief Get the size of the arena given to SQLite by 'alloc_setup()'.
+ * @return size_t : the arena size in bytes, or zero if SQLite uses malloc.
+ */
+size_t alloc_heap_bytes(void)
+{
+    return alloc_heap;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file amt-alloc.h
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ *
+ * @author     simon rowe <simon@wiremoons.com>
+ * @license    open-source released under "MIT License"
+ * @source     https://github.com/wiremoons/acroman
+ *
+ */
+
+#ifndef AMT_AMT_ALLOC_H /* Include guard */
+#define AMT_AMT_ALLOC_H
+
+#include "sqlite3.h"    /** @note SQLite database C amalgamation header */
+#include <stdbool.h>    /** @note use of true / false booleans for declarations below*/
+#include <stddef.h>     /** @note size_t */
+
+#define AMT_ALLOC_ENV "AMT_ALLOC"      /** @note env naming the SQLite allocator: 'malloc', 'arena' or 'arena:<MB>' */
+#define AMT_ALLOC_MIN_REQ 64           /** @note smallest block the arena gives out, a power of two */
+#define AMT_ALLOC_PAGE_SIZE 4096       /** @note database page size the page cache buffer slots are sized for */
+#define AMT_ALLOC_SOFT_LIMIT_PCT 75    /** @note part of the arena the page cache may grow into before reusing pages */
+
+/** @note the ways amt runs, each given its own SQLite memory sizes when the arena is used */
+typedef enum AmtAlloc_Mode {
+    ALLOC_COMMAND, /* one command run from the command line, then exit */
+    ALLOC_SHELL,   /* the interactive shell, '--shell' */
+    ALLOC_SERVER,  /* the resident server, '--serve' */
+    ALLOC_MODES    /* number of modes - must be last */
+} alloc_mode;
+
+bool alloc_configure(alloc_mode mode);                 /* set up SQLite memory as chosen by env, before first use */
+bool alloc_setup(alloc_mode mode, const char *choice); /* set up SQLite memory as named by 'choice' */
+size_t alloc_heap_bytes(void);                         /* size of the arena in use, or zero if none */
+
+#endif // AMT_AMT_ALLOC_H
@@ -17,48 +17,216 @@
 #include <malloc.h> /* free for use with strdup and malloc */
 #endif
 
+#include <ctype.h>             /* tolower */
 #include <errno.h>             /* strerror */
 #include <libgen.h>            /* basename and dirname */
+#include <limits.h>            /* INT_MAX */
 #include <locale.h>            /* number output formatting with commas */
 #include <stdio.h>             /* printf and asprintf */
-#include <stdlib.h>            /* getenv */
+#include <stdlib.h>            /* getenv strtol rand_r realpath */
 #include <string.h>            /* strlen strdup */
+#include <strings.h>           /* strcasecmp */
 #include <sys/stat.h>          /* stat */
 #include <sys/types.h>         /* stat */
-#include <time.h>              /* stat file modification time */
+#include <time.h>              /* stat file modification time, clock_gettime nanosleep */
 #include <unistd.h>            /* strdup access stat and FILE */
+#include "amt-fuzzy.h"        /** @note 'did you mean' suggestions index kept up to date on changes */
+#include "amt-hints.h"         /** @note acronym hints shown as the acronym is typed */
+#include "amt-output.h"        /** @note buffered output of record blocks */
+#include "amt-profile.h"       /** @note '--profile' output of each statement run */
+#include "amt-sources.h"       /** @note tab completion of acronym sources */
 #include "linenoise.h"         /** @note Linenoise library: readline replacement */
 
+/**
+ * @note SQL text and report names for each statement in the prepared statement registry. Indexed by 'amt_stmt_id'
+ * as declared in 'types.h'.
+ */
+static const struct {
+    const char *name;
+    const char *sql;
+} amt_stmt_sql[AMT_STMT_MAX] = {
+    [AMT_STMT_META_COUNT] = {"meta count", "select record_count from amt_meta where id = 1;"},
+    [AMT_STMT_TABLE_COUNT] = {"table count", "select count(*) from ACRONYMS;"},
+    [AMT_STMT_META_MAXID] = {"meta max id", "select max_rowid from amt_meta where id = 1;"},
+    [AMT_STMT_TABLE_MAXID] = {"table max id", "select MAX(rowid) from ACRONYMS;"},
+    [AMT_STMT_META_READ] = {"meta read", "select record_count, max_rowid from amt_meta where id = 1;"},
+    [AMT_STMT_META_LAST] = {"meta last", "SELECT ifnull(last_acronym,'') FROM amt_meta WHERE id = 1;"},
+    [AMT_STMT_TABLE_LAST] = {"table last", "SELECT ifnull(Acronym,'') FROM acronyms Order by rowid DESC LIMIT 1;"},
+    [AMT_STMT_OBJECT_EXISTS] = {"object exists", "select 1 from sqlite_master where type = ? "
+                                                 "and name = ? COLLATE NOCASE;"},
+    [AMT_STMT_LATEST] = {"latest", "select rowid,ifnull(Acronym,''), ifnull(Definition,''), "
+                                   "ifnull(Source,''), ifnull(Description,''), ifnull(Changed,'') "
+                                   "from ACRONYMS Order by rowid DESC LIMIT 5;"},
+    [AMT_STMT_SEARCH_EXACT] = {"search exact", "select rowid,ifnull(Acronym,''), ifnull(Definition,''), "
+                                               "ifnull(Source,''), ifnull(Description,''), ifnull(Changed,'') "
+                                               "from ACRONYMS where Acronym = ?1 COLLATE NOCASE ORDER BY Source;"},
+    [AMT_STMT_SEARCH_RANGE] = {"search prefix", "select rowid,ifnull(Acronym,''), ifnull(Definition,''), "
+                                                "ifnull(Source,''), ifnull(Description,''), ifnull(Changed,'') "
+                                                "from ACRONYMS where Acronym >= ?1 COLLATE NOCASE "
+                                                "and Acronym < ?2 COLLATE NOCASE ORDER BY Source;"},
+    [AMT_STMT_SEARCH_FROM] = {"search prefix open", "select rowid,ifnull(Acronym,''), ifnull(Definition,''), "
+                                                    "ifnull(Source,''), ifnull(Description,''), ifnull(Changed,'') "
+                                                    "from ACRONYMS where Acronym >= ?1 COLLATE NOCASE "
+                                                    "ORDER BY Source;"},
+    [AMT_STMT_SEARCH_LIKE] = {"search like", "select rowid,ifnull(Acronym,''), ifnull(Definition,''), "
+                                             "ifnull(Source,''), ifnull(Description,''), ifnull(Changed,'') "
+                                             "from ACRONYMS where Acronym like ?1 COLLATE NOCASE ORDER BY Source;"},
+    [AMT_STMT_TEXT_SEARCH] = {"text search", "select a.rowid,ifnull(a.Acronym,''), ifnull(a.Definition,''), "
+                                             "ifnull(a.Source,''), ifnull(a.Description,''), ifnull(a.Changed,'') "
+                                             "from ACRONYMS_FTS f join ACRONYMS a on a.rowid = f.rowid "
+                                             "where ACRONYMS_FTS match ? ORDER BY bm25(ACRONYMS_FTS);"},
+    [AMT_STMT_FTS_IN_STEP] = {"fts in step", "select (select MAX(rowid) from ACRONYMS) is "
+                                             "(select MAX(id) from ACRONYMS_FTS_docsize);"},
+    [AMT_STMT_INSERT] = {"insert", "insert into ACRONYMS(Acronym, Definition, Description, Source) "
+                                   "values(?,?,?,?);"},
+    [AMT_STMT_RECORD_BY_ID] = {"record by id", "select rowid, ifnull(Acronym,''), ifnull(Definition,''), "
+                                               "ifnull(Description,''), ifnull(Source,'') "
+                                               "from ACRONYMS where rowid = ?;"},
+    [AMT_STMT_DELETE] = {"delete", "delete from ACRONYMS where rowid = ?;"},
+    [AMT_STMT_SOURCE_LIST] = {"source list", "select source, uses from ACRONYMS_SOURCES;"},
+    [AMT_STMT_SOURCE_COUNTS] = {"source counts", "select ifnull(Source,''), count(*) from ACRONYMS "
+                                                 "group by Source;"},
+    [AMT_STMT_UPDATE] = {"update", "update ACRONYMS set Acronym = ?, Definition = ?, Description = ?, "
+                                   "Source = ? where rowid = ?;"},
+    [AMT_STMT_ACRONYM_EXISTS] = {"acronym exists", "select 1 from ACRONYMS where Acronym = ?1 COLLATE NOCASE "
+                                                   "and Acronym = ?1 limit 1;"},
+    [AMT_STMT_DISTINCT_ACRONYMS] = {"distinct acronyms", "select distinct Acronym from ACRONYMS "
+                                                         "where Acronym is not null;"},
+    [AMT_STMT_FUZZY_INSERT] = {"fuzzy insert", "insert or ignore into ACRONYMS_FUZZY(variant, acronym) "
+                                               "values(?, ?);"},
+    [AMT_STMT_FUZZY_DELETE] = {"fuzzy delete", "delete from ACRONYMS_FUZZY where variant = ? and acronym = ?;"},
+    [AMT_STMT_FUZZY_LOOKUP] = {"fuzzy lookup", "select acronym from ACRONYMS_FUZZY where variant = ?;"},
+    [AMT_STMT_DEFINITIONS] = {"definitions", "select ifnull(Definition,''), ifnull(Source,'') from ACRONYMS "
+                                             "where Acronym = ?1 COLLATE NOCASE and Acronym = ?1 ORDER BY Source;"},
+    [AMT_STMT_LIST_ALL] = {"list all", "select rowid,ifnull(Acronym,''), ifnull(Definition,''), "
+                                       "ifnull(Source,''), ifnull(Description,''), ifnull(Changed,'') "
+                                       "from ACRONYMS ORDER BY Acronym COLLATE NOCASE, Source;"},
+    [AMT_STMT_EXPORT] = {"export", "select rowid,ifnull(Acronym,''), ifnull(Definition,''), "
+                                   "ifnull(Source,''), ifnull(Description,''), ifnull(Changed,'') "
+                                   "from ACRONYMS;"},
+    [AMT_STMT_HINTS] = {"hints", "select ifnull(Acronym,''), ifnull(Definition,'') from ACRONYMS;"},
+};
+
+
+/**
+ * @brief Get a statement from the prepared statement registry ready to have its parameters bound.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @param amt_stmt_id id : the registry statement to return.
+ * @return sqlite3_stmt* : the statement, or NULL if it could not be prepared.
+ * @note The statement is prepared on first use with 'SQLITE_PREPARE_PERSISTENT' and kept in 'amtdb->stmts'. On
+ * later use it is reset and its old bindings cleared instead. Call 'release_stmt()' once finished with it.
+ */
+sqlite3_stmt *get_stmt(amtdb_struct *amtdb, amt_stmt_id id)
+{
+    amtstmt_struct *entry = &amtdb->stmts[id];
+
+    if (entry->stmt != NULL) {
+        sqlite3_reset(entry->stmt);
+        sqlite3_clear_bindings(entry->stmt);
+        return entry->stmt;
+    }
+
+    int rc = sqlite3_prepare_v3(amtdb->db, amt_stmt_sql[id].sql, -1, SQLITE_PREPARE_PERSISTENT, &entry->stmt, NULL);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "SQL prepare error: %s\n", sqlite3_errmsg(amtdb->db));
+        entry->stmt = NULL;
+        return NULL;
+    }
+    entry->prepares++;
+
+    return entry->stmt;
+}
+
+
+/**
+ * @brief Step a registry statement, counting the step against it.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @param amt_stmt_id id : the registry statement to step, as obtained with 'get_stmt()'.
+ * @return int : the SQLite result code from 'sqlite3_step()'.
+ */
+int step_stmt(amtdb_struct *amtdb, amt_stmt_id id)
+{
+    amtdb->stmts[id].steps++;
+    return sqlite3_step(amtdb->stmts[id].stmt);
+}
+
+
+/**
+ * @brief Finish with a registry statement: reset it so it releases any read lock, and drop its bindings.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @param amt_stmt_id id : the registry statement to release.
+ */
+void release_stmt(amtdb_struct *amtdb, amt_stmt_id id)
+{
+    if (amtdb->stmts[id].stmt != NULL) {
+        sqlite3_reset(amtdb->stmts[id].stmt);
+        sqlite3_clear_bindings(amtdb->stmts[id].stmt);
+    }
+}
+
+
+/**
+ * @brief Finalize every statement held in the prepared statement registry. Run before the database is closed.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ */
+void finalize_stmts(amtdb_struct *amtdb)
+{
+    for (int id = 0; id < AMT_STMT_MAX; id++) {
+        if (amtdb->stmts[id].stmt != NULL) {
+            sqlite3_finalize(amtdb->stmts[id].stmt);
+            amtdb->stmts[id].stmt = NULL;
+        }
+    }
+}
+
+
+/**
+ * @brief Output the prepare and step counts for each statement used from the prepared statement registry.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ */
+void output_stmt_stats(amtdb_struct *amtdb)
+{
+    fprintf(stderr, "\nPrepared statement use:\n");
+    fprintf(stderr, "%-20s %10s %12s\n", "STATEMENT", "PREPARES", "STEPS");
+    for (int id = 0; id < AMT_STMT_MAX; id++) {
+        if (amtdb->stmts[id].prepares > 0) {
+            fprintf(stderr, "%-20s %10d %12lld\n", amt_stmt_sql[id].name, amtdb->stmts[id].prepares,
+                    amtdb->stmts[id].steps);
+        }
+    }
+}
+
+
 /**
  * @brief Get the total records held in the database; store any prior total; write both to 'amtdb' struct.
  * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
  * @return bool : success status for functions execution.
- * @note Uses the following SQL:
- * @code select count(*) from ACRONYMS;
+ * @note Uses the following SQL, or 'select count(*) from ACRONYMS;' if the 'amt_meta' table is not available:
+ * @code select record_count from amt_meta where id = 1;
  */
 bool set_record_count(amtdb_struct *amtdb)
 {
-    sqlite3_stmt *stmt = NULL;
-
     /* capture any previous record count if it exists */
     if (amtdb->totalrec > 0) {
         amtdb->prevtotalrec = amtdb->totalrec;
     }
 
-    int rc = sqlite3_prepare_v2(amtdb->db, "select count(*) from ACRONYMS", -1, &stmt,
-                            NULL);
+    /** @note use the trigger maintained count when available - avoids a full table scan */
+    const amt_stmt_id id = amtdb->meta_OK ? AMT_STMT_META_COUNT : AMT_STMT_TABLE_COUNT;
 
-    if (rc != SQLITE_OK) {
+    sqlite3_stmt *stmt = get_stmt(amtdb, id);
+
+    if (stmt == NULL) {
         perror("\nERROR: unable to access the SQLite database to "
                "perform a record count\n");
         return false;
     }
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
+    while (step_stmt(amtdb, id) == SQLITE_ROW) {
         amtdb->totalrec = sqlite3_column_int(stmt, 0);
     }
 
-    sqlite3_finalize(stmt);
+    release_stmt(amtdb, id);
     return true;
 }
 
@@ -67,26 +235,25 @@ bool set_record_count(amtdb_struct *amtdb)
  * @brief Get the maximum record id number in use by the database, and write result to 'amtdb' struct.
  * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
  * @return bool : success status for functions execution.
- * @note Uses the follow SQL:
- * @code select MAX(rowid) from ACRONYMS;
+ * @note Uses the follow SQL, or 'select MAX(rowid) from ACRONYMS;' if the 'amt_meta' table is not available:
+ * @code select max_rowid from amt_meta where id = 1;
  */
 bool update_max_recid(amtdb_struct *amtdb)
 {
-    sqlite3_stmt *stmt = NULL;
+    const amt_stmt_id id = amtdb->meta_OK ? AMT_STMT_META_MAXID : AMT_STMT_TABLE_MAXID;
 
-    int rc = sqlite3_prepare_v2(amtdb->db, "select MAX(rowid) from ACRONYMS", -1, &stmt,
-                                NULL);
+    sqlite3_stmt *stmt = get_stmt(amtdb, id);
 
-    if (rc != SQLITE_OK) {
+    if (stmt == NULL) {
         perror("\nERROR: unable to access the SQLite database to "
                "obtain the maximum record ID\n");
         return false;
     }
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
+    while (step_stmt(amtdb, id) == SQLITE_ROW) {
         amtdb->maxrecid = sqlite3_column_int(stmt, 0);
     }
-    sqlite3_finalize(stmt);
+    release_stmt(amtdb, id);
     return true;
 }
 
@@ -171,6 +338,44 @@ bool check_4_db_file(amtdb_struct *amtdb)
 }
 
 
+/**
+ * @brief Find the database file the same way as 'check_4_db_file()', without any output, and get its full path.
+ * @param const char *prog_name : the program name as run, used to find 'acronyms.db' beside the executable.
+ * @return char * : the real path of the database file, to be freed by the caller, or NULL if none is found.
+ * @note Used by a client of a server, so the server is told exactly which file the client would open, whatever
+ * the working directory of either.
+ */
+char *find_db_path(const char *prog_name)
+{
+    const char *env = getenv("ACRODB");
+    if (env != NULL && env[0] != '\0' && access(env, F_OK | R_OK) == 0) {
+        return realpath(env, NULL);
+    }
+
+    if (prog_name == NULL) {
+        return NULL;
+    }
+    /** @note dirname() may change the string it is given, so it is given a copy */
+    char *tmpDirname = strdup(prog_name);
+    if (tmpDirname == NULL) {
+        return NULL;
+    }
+    const char *dir = dirname(tmpDirname);
+    size_t dbfileSz = strlen(dir) + strlen("/acronyms.db") + 1;
+    char *dbfile = malloc(dbfileSz);
+    char *found = NULL;
+    if (dbfile != NULL) {
+        snprintf(dbfile, dbfileSz, "%s%s", dir, "/acronyms.db");
+        if (access(dbfile, F_OK | R_OK) == 0) {
+            found = realpath(dbfile, NULL);
+        }
+    }
+    free(dbfile);
+    free(tmpDirname);
+    return found;
+}
+
+
 /**
  * @brief Check the valid SQLite database file. Record the database file stats into the 'amtdb' struct.
  * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
@@ -220,202 +425,1119 @@ bool check_db_access(amtdb_struct *amtdb)
 }
 
 /**
- * @brief Output the database stats as stored in the 'amtdb' struct populated by 'check_db_access()'.
- * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
- * @return bool : success status for functions execution.
+ * @brief Output the database stats as stored in the 'amtdb' struct populated by 'check_db_access()'.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : success status for functions execution.
+ */
+bool output_db_stats(amtdb_struct *amtdb)
+{
+    if ( strlen(amtdb->dbfile) <= 0 && strlen(amtdb->dblastmod) <= 0 && amtdb->dbsize < 0  && amtdb->totalrec < 0) {
+        fprintf(stderr,
+                "ERROR: The database status information for file '%s' is missing\n",
+                amtdb->dbfile);
+        return false;
+    }
+
+    printf("Database full path:   '%s'\n", amtdb->dbfile);
+    printf("Database file size:   '%'lld' bytes\n", amtdb->dbsize);
+    printf("Database modified:    '%s'\n\n", amtdb->dblastmod);
+    printf("SQLite version:       '%s'\n", SQLITE_VERSION);
+    printf("Total acronyms:       '%'d'\n", amtdb->totalrec);
+    printf("Last acronym entered: '%s'\n", get_last_acronym(amtdb));
+
+    return true;
+}
+
+
+/**
+ * @brief Check the 'amt_meta' table and all three of the triggers that keep it up to date exist.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : true if the table can be relied on to be current.
+ */
+static bool meta_table_complete(amtdb_struct *amtdb)
+{
+    return db_object_exists(amtdb, "table", "amt_meta") && db_object_exists(amtdb, "trigger", "amt_meta_ai") &&
+           db_object_exists(amtdb, "trigger", "amt_meta_ad") && db_object_exists(amtdb, "trigger", "amt_meta_au");
+}
+
+
+/**
+ * @brief Ensure the 'amt_meta' table and the triggers on 'ACRONYMS' that keep it up to date exist.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : true if the 'amt_meta' table is available for use.
+ * @note The single row table holds the record count, maximum rowid, and the acronym of the newest record. It is
+ * seeded with a full count when first created; after that the triggers keep it current so start up does not need
+ * to scan the 'ACRONYMS' table. If any trigger is missing, such as when one was dropped by another program, the
+ * row may be out of date, so the triggers are made again and the row seeded afresh.
+ */
+bool ensure_meta_table(amtdb_struct *amtdb)
+{
+    if (meta_table_complete(amtdb)) {
+        return true;
+    }
+    if (amtdb->read_only) {
+        return false;
+    }
+
+#if DEBUG
+    fprintf(stderr, "DEBUG: creating the 'amt_meta' table and its triggers\n");
+#endif
+
+    /** @note 'BEGIN IMMEDIATE' so two programs starting at once can not both seed the table */
+    int rc = sqlite3_exec(amtdb->db,
+                          "BEGIN IMMEDIATE;"
+                          "CREATE TABLE IF NOT EXISTS amt_meta ("
+                          "id INTEGER PRIMARY KEY CHECK (id = 1), "
+                          "record_count INTEGER NOT NULL, "
+                          "max_rowid INTEGER NOT NULL, "
+                          "last_acronym TEXT);"
+                          "INSERT OR REPLACE INTO amt_meta(id, record_count, max_rowid, last_acronym) "
+                          "SELECT 1, (select count(*) from ACRONYMS), "
+                          "ifnull((select MAX(rowid) from ACRONYMS), 0), "
+                          "(select Acronym from ACRONYMS order by rowid desc limit 1);"
+                          "CREATE TRIGGER IF NOT EXISTS amt_meta_ai AFTER INSERT ON ACRONYMS BEGIN "
+                          "UPDATE amt_meta SET record_count = record_count + 1, "
+                          "last_acronym = CASE WHEN new.rowid >= max_rowid THEN new.Acronym "
+                          "ELSE last_acronym END, "
+                          "max_rowid = max(max_rowid, new.rowid) WHERE id = 1; END;"
+                          "CREATE TRIGGER IF NOT EXISTS amt_meta_ad AFTER DELETE ON ACRONYMS BEGIN "
+                          "UPDATE amt_meta SET record_count = record_count - 1, "
+                          "last_acronym = CASE WHEN old.rowid >= max_rowid THEN "
+                          "(select Acronym from ACRONYMS order by rowid desc limit 1) "
+                          "ELSE last_acronym END, "
+                          "max_rowid = CASE WHEN old.rowid >= max_rowid THEN "
+                          "ifnull((select MAX(rowid) from ACRONYMS), 0) "
+                          "ELSE max_rowid END WHERE id = 1; END;"
+                          "CREATE TRIGGER IF NOT EXISTS amt_meta_au AFTER UPDATE OF Acronym ON ACRONYMS "
+                          "WHEN new.rowid >= (select max_rowid from amt_meta where id = 1) BEGIN "
+                          "UPDATE amt_meta SET last_acronym = new.Acronym WHERE id = 1; END;"
+                          "COMMIT;",
+                          NULL, NULL, NULL);
+    if (rc != SQLITE_OK) {
+        /* not fatal - the counts can still be obtained directly from the 'ACRONYMS' table */
+#if DEBUG
+        fprintf(stderr, "DEBUG: unable to create the 'amt_meta' table: %s\n", sqlite3_errmsg(amtdb->db));
+#endif
+        sqlite3_exec(amtdb->db, "ROLLBACK;", NULL, NULL, NULL);
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Read the record count and maximum record id from the 'amt_meta' table into the 'amtdb' struct.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : success status for functions execution.
+ * @note Uses the following SQL:
+ * @code select record_count, max_rowid from amt_meta where id = 1;
+ */
+bool read_db_meta(amtdb_struct *amtdb)
+{
+    bool result = false;
+
+    sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_META_READ);
+    if (stmt == NULL) {
+        return false;
+    }
+
+    if (step_stmt(amtdb, AMT_STMT_META_READ) == SQLITE_ROW) {
+        if (amtdb->totalrec > 0) {
+            amtdb->prevtotalrec = amtdb->totalrec;
+        }
+        amtdb->totalrec = sqlite3_column_int(stmt, 0);
+        amtdb->maxrecid = sqlite3_column_int(stmt, 1);
+        result = true;
+    }
+
+    release_stmt(amtdb, AMT_STMT_META_READ);
+    return result;
+}
+
+
+/**
+ * @brief SQLite busy handler: wait before the next attempt to get a lock held by another program.
+ * @param void *arg : the 'amtdb_struct' of the connection waiting.
+ * @param int count : the number of times the handler has been called for this lock.
+ * @return int : non zero to try for the lock again, or zero to give up and return 'SQLITE_BUSY'.
+ * @note The wait doubles from 1ms up to 'AMT_DB_BUSY_MAX_SLEEP', and is picked at random from the upper half of that
+ * range, so programs waiting on the same writer do not all try again at the same moment. It gives up once
+ * 'amtdb->busy_timeout' milliseconds have passed since the first attempt.
+ */
+static int busy_backoff(void *arg, int count)
+{
+    amtdb_struct *amtdb = arg;
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (count == 0) {
+        amtdb->busy_start = now;
+    }
+
+    const long waited = (now.tv_sec - amtdb->busy_start.tv_sec) * 1000L +
+                        (now.tv_nsec - amtdb->busy_start.tv_nsec) / 1000000L;
+    if (waited >= amtdb->busy_timeout) {
+        return 0;
+    }
+
+    static unsigned int seed = 0;
+    if (seed == 0) {
+        seed = (unsigned int)getpid() ^ (unsigned int)now.tv_nsec;
+    }
+
+    long sleep_ms = (count < 7) ? (1L << count) : AMT_DB_BUSY_MAX_SLEEP;
+    if (sleep_ms > AMT_DB_BUSY_MAX_SLEEP) {
+        sleep_ms = AMT_DB_BUSY_MAX_SLEEP;
+    }
+    if (sleep_ms > amtdb->busy_timeout - waited) {
+        sleep_ms = amtdb->busy_timeout - waited;
+    }
+    const long sleep_us = sleep_ms * 500L + (long)(rand_r(&seed) % (unsigned int)(sleep_ms * 500L + 1));
+
+    struct timespec ts = {sleep_us / 1000000L, (sleep_us % 1000000L) * 1000L};
+    nanosleep(&ts, NULL);
+    return 1;
+}
+
+
+/**
+ * @brief Run a 'PRAGMA' that returns a single text value, such as 'journal_mode'.
+ * @return bool : true if the pragma ran and its value was copied to 'value'.
+ */
+static bool pragma_text(amtdb_struct *amtdb, const char *sql, char *value, size_t size)
+{
+    sqlite3_stmt *stmt = NULL;
+    bool result = false;
+
+    if (sqlite3_prepare_v2(amtdb->db, sql, -1, &stmt, NULL) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_text(stmt, 0) != NULL) {
+        snprintf(value, size, "%s", (const char *)sqlite3_column_text(stmt, 0));
+        result = true;
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+
+/**
+ * @brief Set how the database connection shares the database with other programs using it at the same time.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : true if the connection is in WAL mode.
+ * @note The busy timeout is 'AMT_DB_BUSY_TIMEOUT' milliseconds, or as set by env 'AMT_BUSY_TIMEOUT'. The journal
+ * mode is 'AMT_DB_JOURNAL_MODE', or one of 'wal', 'delete', 'truncate' or 'persist' as set by env
+ * 'AMT_JOURNAL_MODE'. In WAL mode readers never wait for a writer, and a writer only waits for another writer. The
+ * mode is stored in the database file, so it is only changed when it differs, and never when opened read only. A
+ * failure to change it, such as for a database the user can not write to, is not fatal.
+ */
+bool configure_connection(amtdb_struct *amtdb)
+{
+    amtdb->busy_timeout = AMT_DB_BUSY_TIMEOUT;
+    const char *env = getenv("AMT_BUSY_TIMEOUT");
+    if (env != NULL && env[0] != '\0') {
+        char *end = NULL;
+        long timeout = strtol(env, &end, 10);
+        if (*end != '\0' || timeout < 0 || timeout > 3600000) {
+            fprintf(stderr, "WARNING: ignoring 'AMT_BUSY_TIMEOUT' of '%s': it is not a number of milliseconds.\n",
+                    env);
+        } else {
+            amtdb->busy_timeout = (int)timeout;
+        }
+    }
+    sqlite3_busy_handler(amtdb->db, busy_backoff, amtdb);
+
+    static const char *modes[] = {"wal", "delete", "truncate", "persist"};
+    const char *mode = AMT_DB_JOURNAL_MODE;
+    env = getenv("AMT_JOURNAL_MODE");
+    if (env != NULL && env[0] != '\0') {
+        mode = NULL;
+        for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+            if (strcasecmp(env, modes[i]) == 0) {
+                mode = modes[i];
+            }
+        }
+        if (mode == NULL) {
+            fprintf(stderr, "WARNING: ignoring 'AMT_JOURNAL_MODE' of '%s': use one of 'wal', 'delete', "
+                            "'truncate' or 'persist'.\n", env);
+            mode = AMT_DB_JOURNAL_MODE;
+        }
+    }
+
+    char current[16] = "";
+    if (pragma_text(amtdb, "PRAGMA journal_mode;", current, sizeof(current)) && !amtdb->read_only &&
+        strcasecmp(current, mode) != 0) {
+        char sql[64];
+        snprintf(sql, sizeof(sql), "PRAGMA journal_mode=%s;", mode);
+        if (!pragma_text(amtdb, sql, current, sizeof(current)) || strcasecmp(current, mode) != 0) {
+#if DEBUG
+            fprintf(stderr, "DEBUG: unable to set journal mode '%s': %s\n", mode, sqlite3_errmsg(amtdb->db));
+#endif
+        }
+    }
+
+    amtdb->wal_OK = (strcasecmp(current, "wal") == 0);
+    if (amtdb->wal_OK) {
+        /** @note in WAL mode 'NORMAL' is still safe from corruption, and a commit does not wait for the disk */
+        char sql[128];
+        snprintf(sql, sizeof(sql), "PRAGMA synchronous=NORMAL; PRAGMA journal_size_limit=%d;",
+                 AMT_DB_JOURNAL_SIZE_LIMIT);
+        sqlite3_exec(amtdb->db, sql, NULL, NULL, NULL);
+        sqlite3_wal_autocheckpoint(amtdb->db, AMT_DB_WAL_AUTOCHECKPOINT);
+    }
+
+    return amtdb->wal_OK;
+}
+
+
+/**
+ * @brief Start a write transaction, waiting for any other program writing to the database to finish first.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : success status for functions execution.
+ * @note 'BEGIN IMMEDIATE' takes the write lock at the start, so a transaction that reads and then writes can not
+ * fail part way through because another program wrote first. The wait is managed by 'busy_backoff()'.
+ */
+bool begin_write(amtdb_struct *amtdb)
+{
+    if (sqlite3_exec(amtdb->db, "BEGIN IMMEDIATE;", NULL, NULL, NULL) != SQLITE_OK) {
+        fprintf(stderr, "ERROR: unable to start writing to the database: %s\n", sqlite3_errmsg(amtdb->db));
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Commit, or roll back, a write transaction started by 'begin_write()'.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @param bool commit : true to keep the changes made, false to undo them.
+ * @return bool : true if the changes were committed.
+ * @note Does nothing if no transaction is open, so can be called on every error path.
+ */
+bool end_write(amtdb_struct *amtdb, bool commit)
+{
+    if (sqlite3_get_autocommit(amtdb->db)) {
+        return false;
+    }
+    if (commit && sqlite3_exec(amtdb->db, "COMMIT;", NULL, NULL, NULL) == SQLITE_OK) {
+        return true;
+    }
+    if (commit) {
+        fprintf(stderr, "ERROR: unable to save the changes to the database: %s\n", sqlite3_errmsg(amtdb->db));
+    }
+    sqlite3_exec(amtdb->db, "ROLLBACK;", NULL, NULL, NULL);
+    return false;
+}
+
+
+/**
+ * @brief Copy the changes this program made from the WAL file into the database, without waiting for other programs.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @note A 'PASSIVE' checkpoint copies what it can while readers carry on, so the WAL file does not keep growing when
+ * the database is never left idle. The WAL file is reset by a later writer once every reader has moved on.
+ */
+void checkpoint_database(amtdb_struct *amtdb)
+{
+    if (!amtdb->wal_OK || sqlite3_total_changes(amtdb->db) == 0) {
+        return;
+    }
+
+    int rc = sqlite3_wal_checkpoint_v2(amtdb->db, NULL, SQLITE_CHECKPOINT_PASSIVE, NULL, NULL);
+#if DEBUG
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "DEBUG: WAL checkpoint failed with: %s\n", sqlite3_errstr(rc));
+    }
+#else
+    (void)rc;
+#endif
+}
+
+
+/**
+ * @brief Check if env 'AMT_IMMUTABLE' is set, to read the database as on read only media that nothing can change.
+ * @return bool : true if it is set to anything but '0'.
+ */
+static bool immutable_requested(void)
+{
+    const char *env = getenv("AMT_IMMUTABLE");
+    return (env != NULL && env[0] != '\0' && strcmp(env, "0") != 0);
+}
+
+
+/**
+ * @brief Open the database read only, for a command that only searches or lists records.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : true if the database was opened read only. false if it could not be, or if it is writable but does
+ * not yet have the 'amt_meta' table and its triggers, or the search index, that are added on first use, so should
+ * be opened read write. The fuzzy search index is only needed when a search finds nothing, so if it is missing the
+ * database is reopened read write by 'reopen_read_write()' only when a suggestion is to be made.
+ * @note The database is opened with the URI 'file:<path>?mode=ro', or with 'file:<path>?immutable=1' when env
+ * 'AMT_IMMUTABLE' is set, for a database on read only media that nothing can change. An immutable database is read
+ * without any locking and without checking for a journal or WAL file. Reads are made through memory mapped I/O of up
+ * to 'AMT_DB_MMAP_SIZE' bytes, so the pages are read straight from the operating systems cache.
+ */
+static bool open_read_only(amtdb_struct *amtdb)
+{
+    const bool immutable = immutable_requested();
+
+    /** @note '?', '#' and '%' have a meaning in a URI, so are escaped where found in the path */
+    const size_t len = strlen(amtdb->dbfile);
+    char *uri = malloc(len * 3 + 32);
+    if (uri == NULL) {
+        return false;
+    }
+    char *out = uri + sprintf(uri, "file:");
+    for (const char *in = amtdb->dbfile; *in != '\0'; in++) {
+        if (*in == '?' || *in == '#' || *in == '%') {
+            out += sprintf(out, "%%%02X", (unsigned char)*in);
+        } else {
+            *out++ = *in;
+        }
+    }
+    sprintf(out, "%s", immutable ? "?immutable=1" : "?mode=ro");
+
+    int rc = sqlite3_open_v2(uri, &amtdb->db, SQLITE_OPEN_READONLY | SQLITE_OPEN_URI, NULL);
+    free(uri);
+    if (rc != SQLITE_OK) {
+#if DEBUG
+        fprintf(stderr, "DEBUG: unable to open the database read only: %s\n", sqlite3_errstr(rc));
+#endif
+        sqlite3_close_v2(amtdb->db);
+        amtdb->db = NULL;
+        return false;
+    }
+
+    if (!immutable && access(amtdb->dbfile, W_OK) == 0 &&
+        (!meta_table_complete(amtdb) || !db_object_exists(amtdb, "index", "ACRONYMS_ACRONYM_IDX"))) {
+#if DEBUG
+        fprintf(stderr, "DEBUG: database not yet set up for use - opening it read write\n");
+#endif
+        finalize_stmts(amtdb);
+        sqlite3_close_v2(amtdb->db);
+        amtdb->db = NULL;
+        return false;
+    }
+
+    char sql[64];
+    snprintf(sql, sizeof(sql), "PRAGMA mmap_size=%lld;", (long long)AMT_DB_MMAP_SIZE);
+    sqlite3_exec(amtdb->db, sql, NULL, NULL, NULL);
+    return true;
+}
+
+
+/**
+ * @brief Reopen a database opened read only by 'open_read_only()' read write, so a missing index can be built.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : true if the database is now open read write. false if it can not be written to, or is immutable,
+ * in which case it is left open read only.
+ * @note Any registry statements are finalized first, and prepared again on the new connection when next used.
+ */
+bool reopen_read_write(amtdb_struct *amtdb)
+{
+    if (!amtdb->read_only) {
+        return true;
+    }
+    if (immutable_requested() || access(amtdb->dbfile, W_OK) != 0) {
+        return false;
+    }
+
+#if DEBUG
+    fprintf(stderr, "DEBUG: reopening the database read write\n");
+#endif
+
+    sqlite3 *db = NULL;
+    int rc = sqlite3_open_v2(amtdb->dbfile, &db, SQLITE_OPEN_READWRITE, NULL);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "ERROR: unable to open the database read write: %s\n", sqlite3_errstr(rc));
+        sqlite3_close_v2(db);
+        return false;
+    }
+
+    finalize_stmts(amtdb);
+    sqlite3_close_v2(amtdb->db);
+    amtdb->db = db;
+    amtdb->read_only = false;
+
+    if (amtdb->profile) {
+        profile_start(amtdb);
+    }
+    configure_connection(amtdb);
+    return true;
+}
+
+
+/**
+ * @brief Ensure the database is opened and working correctly. Get initial record counts and max record ID.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : success status for functions execution.
+ * @note The counts come from the trigger maintained 'amt_meta' table, which is created if missing. When it can not
+ * be used, such as for a read only database without it, the 'ACRONYMS' table is counted directly instead. If
+ * 'amtdb->read_only' is set the database is opened read only by 'open_read_only()' where it can be, and
+ * 'amtdb->read_only' is cleared if it was opened read write instead.
+ */
+bool initialise_database(amtdb_struct *amtdb) {
+
+    int rc = sqlite3_initialize();
+    if (rc != SQLITE_OK) {
+        fprintf(stderr,"ERROR: 'sqlite3_initialize()' failed with: '%d'.",rc);
+        return false;
+    }
+
+    /** @note commands that only read records open the database read only when it is ready for them */
+    if (!amtdb->read_only || !open_read_only(amtdb)) {
+        amtdb->read_only = false;
+        rc = sqlite3_open_v2(amtdb->dbfile, &amtdb->db,
+                             SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+        if (rc != SQLITE_OK) {
+            fprintf(stderr,"ERROR: attempt to open database failed with: '%d'.",rc);
+            return false;
+        }
+    }
+
+    /** @note started first, so every statement run on the connection is shown */
+    if (amtdb->profile && !profile_start(amtdb)) {
+        return false;
+    }
+
+    /** @note set before anything else is read, so a program writing at the same time is waited for */
+    configure_connection(amtdb);
+
+    /** @note with the 'amt_meta' table both values are obtained in one primary key read */
+    amtdb->meta_OK = ensure_meta_table(amtdb);
+    if (amtdb->meta_OK && read_db_meta(amtdb)) {
+        return true;
+    }
+
+    if (!update_max_recid(amtdb)) {
+        fprintf(stderr,
+                "ERROR: Failed to obtain the database maximum record ID.\n");
+        return false;
+    }
+
+    if (!set_record_count(amtdb)) {
+        fprintf(stderr,
+                "ERROR: Failed to set the database record count.\n");
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Get the last acronym entered into the database.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return char* : a pointer to a heap allocated string containing the last acronym entered.
+ * @note Uses the following SQL, or 'SELECT ifnull(Acronym,'') FROM acronyms Order by rowid DESC LIMIT 1;' without
+ * 'amt_meta':
+ * @code SELECT ifnull(last_acronym,'') FROM amt_meta WHERE id = 1;
+ */
+char *get_last_acronym(amtdb_struct *amtdb)
+{
+    char *acronymName = NULL;
+    const amt_stmt_id id = amtdb->meta_OK ? AMT_STMT_META_LAST : AMT_STMT_TABLE_LAST;
+
+    sqlite3_stmt *stmt = get_stmt(amtdb, id);
+    if (stmt == NULL) {
+        exit(-1);
+    }
+
+    while (step_stmt(amtdb, id) == SQLITE_ROW) {
+        acronymName = strdup((const char *)sqlite3_column_text(stmt, 0));
+    }
+
+    release_stmt(amtdb, id);
+
+    if (acronymName == NULL) {
+        fprintf(stderr, "ERROR: last acronym lookup return NULL\n");
+    }
+
+    return (acronymName);
+}
+
+
+/**
+ * @brief Display the five latest acronym records in the database.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : true if records found.
+ * @note Uses the following SQL:
+ * @code select rowid,ifnull(Acronym,''), ifnull(Definition,''), ifnull(Source,''), ifnull(Description,'')
+ * from ACRONYMS Order by rowid DESC LIMIT 5;
+ */
+bool latest_acronym(amtdb_struct *amtdb)
+{
+    bool result = false;
+
+    sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_LATEST);   /* pre-prepared SQL query statement */
+
+    if (stmt == NULL) {
+        result = false;
+        exit(EXIT_FAILURE);
+    }
+
+    int searchRecCount = 0;
+    if (amtdb->format == OUTPUT_TEXT) {
+        printf("\nFive newest acronym records added are:\n");
+    }
+    while (step_stmt(amtdb, AMT_STMT_LATEST) == SQLITE_ROW) {
+        outbuf_record(stmt);
+        searchRecCount++;
+    }
+    outbuf_flush();
+
+    release_stmt(amtdb, AMT_STMT_LATEST);
+
+    return result = true;
+}
+
+
+/**
+ * @brief Output every acronym record in the database, ordered by acronym and then source.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return int : the number of records output, or '-1' on failure.
+ * @note Rows are read in the order of the 'ACRONYMS_ACRONYM_IDX' index, so no sort is needed and each record is
+ * written out as it is stepped to. Memory use stays the same however large the table is. Uses the following SQL:
+ * @code select rowid,ifnull(Acronym,''), ifnull(Definition,''), ifnull(Source,''), ifnull(Description,''),
+ * ifnull(Changed,'') from ACRONYMS ORDER BY Acronym COLLATE NOCASE, Source;
+ */
+int do_list_all(amtdb_struct *amtdb)
+{
+    /** @note without the index SQLite has to sort the whole table first */
+    ensure_search_index(amtdb);
+
+    sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_LIST_ALL);
+
+    if (stmt == NULL) {
+        return -1;
+    }
+
+    int listRecCount = 0;
+    int rc;
+    while ((rc = step_stmt(amtdb, AMT_STMT_LIST_ALL)) == SQLITE_ROW) {
+        outbuf_record(stmt);
+        listRecCount++;
+    }
+    outbuf_flush();
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "SQL step error: %s\n", sqlite3_errmsg(amtdb->db));
+        listRecCount = -1;
+    }
+
+    release_stmt(amtdb, AMT_STMT_LIST_ALL);
+
+    return listRecCount;
+}
+
+
+/**
+ * @brief Check if a named table, index or trigger already exists in the database schema.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @param const char *type : the schema object type, such as 'table', 'index', or 'trigger'.
+ * @param const char *name : the name of the schema object to look for.
+ * @return bool : true if the object exists.
+ * @note Uses the following SQL:
+ * @code select 1 from sqlite_master where type = ? and name = ? COLLATE NOCASE;
+ */
+bool db_object_exists(amtdb_struct *amtdb, const char *type, const char *name)
+{
+    bool exists = false;
+
+    sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_OBJECT_EXISTS);
+    if (stmt == NULL) {
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, type, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, name, -1, SQLITE_STATIC);
+
+    if (step_stmt(amtdb, AMT_STMT_OBJECT_EXISTS) == SQLITE_ROW) {
+        exists = true;
+    }
+    release_stmt(amtdb, AMT_STMT_OBJECT_EXISTS);
+
+    return exists;
+}
+
+
+/**
+ * @brief Ensure the acronym search index exists, creating it if it is missing.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : true if the index is available for use by searches.
+ * @note The index sorts case insensitively to match the 'LIKE' search semantics, and includes 'Source' so exact
+ * matches are returned in the required order without a separate sort. Uses the following SQL:
+ * @code CREATE INDEX ACRONYMS_ACRONYM_IDX ON ACRONYMS(Acronym COLLATE NOCASE, Source);
+ */
+bool ensure_search_index(amtdb_struct *amtdb)
+{
+    /** @note only check the schema once per run, as batch searches call this for every lookup */
+    if (amtdb->index_checked) {
+        return amtdb->index_OK;
+    }
+    amtdb->index_checked = true;
+
+    if (db_object_exists(amtdb, "index", "ACRONYMS_ACRONYM_IDX")) {
+        amtdb->index_OK = true;
+        return true;
+    }
+    if (amtdb->read_only) {
+        return false;
+    }
+
+#if DEBUG
+    fprintf(stderr, "DEBUG: creating the search index 'ACRONYMS_ACRONYM_IDX'\n");
+#endif
+
+    int rc = sqlite3_exec(amtdb->db,
+                          "CREATE INDEX IF NOT EXISTS ACRONYMS_ACRONYM_IDX ON "
+                          "ACRONYMS(Acronym COLLATE NOCASE, Source);",
+                          NULL, NULL, NULL);
+    if (rc != SQLITE_OK) {
+        /* not fatal - searches can still be completed with a table scan */
+#if DEBUG
+        fprintf(stderr, "DEBUG: unable to create the search index: %s\n", sqlite3_errmsg(amtdb->db));
+#endif
+        return false;
+    }
+
+    amtdb->index_OK = true;
+    return true;
+}
+
+
+/**
+ * @brief Decide how a search pattern can be run, and for a prefix search compute its index range bounds.
+ * @param const char *findme : Pointer to a string containing the acronym search pattern.
+ * @param char **lower : set to a heap allocated lower bound for a prefix search. Free with 'sqlite3_free()'.
+ * @param char **upper : set to a heap allocated upper bound for a prefix search, or NULL if there is none.
+ * @return search_plan : 'SEARCH_EXACT' if the pattern has no wildcards; 'SEARCH_PREFIX' if the only wildcards are
+ * '%' at the end of the pattern; otherwise 'SEARCH_LIKE'.
+ * @note Bounds are folded to lower case, so the range matches the same case insensitive rows as 'LIKE' does.
  */
-bool output_db_stats(amtdb_struct *amtdb)
+search_plan plan_acronym_search(const char *findme, char **lower, char **upper)
 {
-    if ( strlen(amtdb->dbfile) <= 0 && strlen(amtdb->dblastmod) <= 0 && amtdb->dbsize < 0  && amtdb->totalrec < 0) {
-        fprintf(stderr,
-                "ERROR: The database status information for file '%s' is missing\n",
-                amtdb->dbfile);
-        return false;
+    *lower = NULL;
+    *upper = NULL;
+
+    size_t len = strlen(findme);
+    size_t prefix_len = strcspn(findme, "%_");
+
+    if (prefix_len == len) {
+        return SEARCH_EXACT;
     }
 
-    printf("Database full path:   '%s'\n", amtdb->dbfile);
-    printf("Database file size:   '%'lld' bytes\n", amtdb->dbsize);
-    printf("Database modified:    '%s'\n\n", amtdb->dblastmod);
-    printf("SQLite version:       '%s'\n", SQLITE_VERSION);
-    printf("Total acronyms:       '%'d'\n", amtdb->totalrec);
-    printf("Last acronym entered: '%s'\n", get_last_acronym(amtdb));
+    /* only '%' characters are allowed after the prefix for a range search */
+    if (prefix_len == 0 || strspn(findme + prefix_len, "%") != len - prefix_len) {
+        return SEARCH_LIKE;
+    }
 
-    return true;
+    char *lo = sqlite3_malloc((int)prefix_len + 1);
+    char *hi = sqlite3_malloc((int)prefix_len + 1);
+    if (lo == NULL || hi == NULL) {
+        sqlite3_free(lo);
+        sqlite3_free(hi);
+        return SEARCH_LIKE;
+    }
+
+    for (size_t i = 0; i < prefix_len; i++) {
+        lo[i] = (char)tolower((unsigned char)findme[i]);
+    }
+    lo[prefix_len] = '\0';
+    memcpy(hi, lo, prefix_len + 1);
+
+    /** @note upper bound is the smallest string greater than every string starting with the prefix: increment the
+     * last byte that is not 0xFF and drop anything after it. As 'NOCASE' compares 'A-Z' as 'a-z', a byte that
+     * becomes an upper case letter must be moved past 'Z' to '['.
+     */
+    size_t end = prefix_len;
+    while (end > 0 && (unsigned char)hi[end - 1] == 0xFF) {
+        end--;
+    }
+    if (end == 0) {
+        sqlite3_free(hi);
+        hi = NULL;
+    } else {
+        hi[end - 1]++;
+        if (hi[end - 1] >= 'A' && hi[end - 1] <= 'Z') {
+            hi[end - 1] = '[';
+        }
+        hi[end] = '\0';
+    }
+
+    *lower = lo;
+    *upper = hi;
+    return SEARCH_PREFIX;
 }
 
 
 /**
- * @brief Ensure the database is opened and working correctly. Get initial record counts and max record ID.
+ * @brief Search for the provided acronym in the database and return the matching number of records found.
+ * @param char *findme : Pointer to a string containing the acronym to be searched for.
  * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
- * @return bool : success status for functions execution.
+ * @return int : the number of matching acronyms found in the database, or '-1' on failure.
+ * @note Exact and prefix ('ABC%') searches are run as lookups on the 'ACRONYMS_ACRONYM_IDX' index, and only
+ * patterns with other wildcards need a 'LIKE' table scan. Uses one of the following SQL:
+ * @code select rowid,ifnull(Acronym,''), ifnull(Definition,''), ifnull(Source,''), ifnull(Description,'')
+ * from ACRONYMS where Acronym = ? COLLATE NOCASE ORDER BY Source;
+ * @code ... from ACRONYMS where Acronym >= ? COLLATE NOCASE and Acronym < ? COLLATE NOCASE ORDER BY Source;
+ * @code ... from ACRONYMS where Acronym like ? COLLATE NOCASE ORDER BY Source;
  */
-bool initialise_database(amtdb_struct *amtdb) {
+int do_acronym_search(char *findme, amtdb_struct *amtdb)
+{
+    char *lower = NULL;
+    char *upper = NULL;
+    amt_stmt_id id;
+
+    search_plan plan = plan_acronym_search(findme, &lower, &upper);
+    if (plan != SEARCH_LIKE && !ensure_search_index(amtdb)) {
+        sqlite3_free(lower);
+        sqlite3_free(upper);
+        lower = upper = NULL;
+        plan = SEARCH_LIKE;
+    }
 
-    int rc = sqlite3_initialize();
-    if (rc != SQLITE_OK) {
-        fprintf(stderr,"ERROR: 'sqlite3_initialize()' failed with: '%d'.",rc);
-        return false;
+    switch (plan) {
+    case SEARCH_EXACT:
+        id = AMT_STMT_SEARCH_EXACT;
+        break;
+    case SEARCH_PREFIX:
+        id = (upper != NULL) ? AMT_STMT_SEARCH_RANGE : AMT_STMT_SEARCH_FROM;
+        break;
+    default:
+        id = AMT_STMT_SEARCH_LIKE;
+        break;
     }
 
-    rc = sqlite3_open_v2(amtdb->dbfile, &amtdb->db,
-                         SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr,"ERROR: attempt to open database failed with: '%d'.",rc);
-        return false;
+#if DEBUG
+    fprintf(stderr, "DEBUG: search plan '%d' for '%s' uses statement: '%d'\n", plan, findme, id);
+#endif
+
+    sqlite3_stmt *stmt = get_stmt(amtdb, id);   	    /* pre-prepared SQL query statement */
+
+    /** @note a failure is returned, not exited on, so a shell or server carries on after it */
+    if (stmt == NULL) {
+        sqlite3_free(lower);
+        sqlite3_free(upper);
+        return -1;
     }
 
-    if (!update_max_recid(amtdb)) {
-        fprintf(stderr,
-                "ERROR: Failed to obtain the database maximum record ID.\n");
-        return false;
+    int rc;
+    if (plan == SEARCH_PREFIX) {
+        /* SQLite frees a bound string with its destructor even when the bind fails */
+        rc = sqlite3_bind_text(stmt, 1, (const char *)lower, -1, sqlite3_free);
+        if (rc == SQLITE_OK && upper != NULL) {
+            rc = sqlite3_bind_text(stmt, 2, (const char *)upper, -1, sqlite3_free);
+        } else if (rc != SQLITE_OK) {
+            sqlite3_free(upper);
+        }
+    } else {
+        rc = sqlite3_bind_text(stmt, 1, (const char *)findme, -1, SQLITE_STATIC);
     }
 
-    if (!set_record_count(amtdb)) {
-        fprintf(stderr,
-                "ERROR: Failed to set the database record count.\n");
-        return false;
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "SQL bind error: %s\n", sqlite3_errmsg(amtdb->db));
+        release_stmt(amtdb, id);
+        return -1;
     }
 
-    return true;
-}
+    int searchRecCount = 0;
+    while (step_stmt(amtdb, id) == SQLITE_ROW) {
+        outbuf_record(stmt);
+        searchRecCount++;
+    }
+    outbuf_flush();
+
+    release_stmt(amtdb, id);
 
+    return searchRecCount;
+}
 
 /**
- * @brief Get the last acronym entered into the database.
+ * @brief Search for many acronyms in one run, outputting a result block for each in the order given.
+ * @param FILE *input : stream to read acronyms from, one per line, or NULL to use 'terms' instead.
+ * @param char **terms : array of acronyms to search for when 'input' is NULL.
+ * @param int nterms : number of acronyms in 'terms'.
  * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
- * @return char* : a pointer to a heap allocated string containing the last acronym entered.
- * @note Uses the following SQL:
- * @code SELECT Acronym FROM acronyms Order by rowid DESC LIMIT 1;
+ * @return int : the number of acronyms searched for, or '-1' on failure.
+ * @note All the searches run inside one read transaction, so they see the same data and only take the database
+ * lock once. Each search reuses the registry statement for its search plan.
  */
-char *get_last_acronym(amtdb_struct *amtdb)
+int do_batch_search(FILE *input, char **terms, int nterms, amtdb_struct *amtdb)
 {
-    char *acronymName;
-    sqlite3_stmt *stmt = NULL;
+    char *line = NULL;
+    size_t linesize = 0;
+    int searched = 0;
+    int matched = 0;
 
-    int rc = sqlite3_prepare_v2(
-        amtdb->db, "SELECT Acronym FROM acronyms Order by rowid DESC LIMIT 1;", -1,
-        &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "SQL prepare error: %s\n", sqlite3_errmsg(amtdb->db));
-        exit(-1);
+    /** @note any write to create the search index must happen before the read transaction is started */
+    ensure_search_index(amtdb);
+
+    if (sqlite3_exec(amtdb->db, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK) {
+        fprintf(stderr, "ERROR: unable to start the batch search transaction: %s\n", sqlite3_errmsg(amtdb->db));
+        return -1;
     }
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        acronymName = strdup((const char *)sqlite3_column_text(stmt, 0));
+    /** @note all the result blocks are gathered in the output buffer and written out as it fills */
+    outbuf_hold(true);
+
+    while (1) {
+        char *findme = NULL;
+
+        if (input != NULL) {
+            ssize_t len = getline(&line, &linesize, input);
+            if (len == -1) {
+                break;
+            }
+            /* remove the line ending - including any Windows style '\r' */
+            while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+                line[--len] = '\0';
+            }
+            if (len == 0) {
+                continue;
+            }
+            findme = line;
+        } else {
+            if (searched >= nterms) {
+                break;
+            }
+            findme = terms[searched];
+        }
+
+        /** @note the records output in other formats carry the acronym, so need no search and match lines */
+        if (amtdb->format == OUTPUT_TEXT) {
+            outbuf_puts("\nSEARCH:      '");
+            outbuf_puts(findme);
+            outbuf_puts("'\n");
+        }
+        const int rec_match = do_acronym_search(findme, amtdb);
+        if (rec_match < 0) {
+            outbuf_hold(false);
+            free(line);
+            sqlite3_exec(amtdb->db, "COMMIT;", NULL, NULL, NULL);
+            return -1;
+        }
+        if (amtdb->format == OUTPUT_TEXT) {
+            outbuf_puts("MATCHES:     ");
+            outbuf_int(rec_match);
+            outbuf_puts("\n");
+        }
+        matched += rec_match;
+        searched++;
     }
 
-    sqlite3_finalize(stmt);
+    outbuf_hold(false);
+    free(line);
+    sqlite3_exec(amtdb->db, "COMMIT;", NULL, NULL, NULL);
 
-    if (acronymName == NULL) {
-        fprintf(stderr, "ERROR: last acronym lookup return NULL\n");
+    if (amtdb->format == OUTPUT_TEXT) {
+        printf("\nBatch search of '%'d' records for '%'d' acronyms found '%'d' matches.\n\n", amtdb->totalrec,
+               searched, matched);
     }
 
-    return (acronymName);
+    return searched;
 }
 
 
 /**
- * @brief Display the five latest acronym records in the database.
+ * @brief Check the FTS5 index still refers to the same rows as the 'ACRONYMS' table, by their rowids.
  * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
- * @return bool : true if records found.
- * @note Uses the following SQL:
- * @code select rowid,ifnull(Acronym,''), ifnull(Definition,''), ifnull(Source,''), ifnull(Description,'')
- * from ACRONYMS Order by rowid DESC LIMIT 5;
+ * @return bool : true if the highest rowid indexed is the highest rowid in the table.
+ * @note 'ACRONYMS' has no 'INTEGER PRIMARY KEY', so a 'VACUUM' may give its rows new rowids, and the index would
+ * then return the wrong records. Rows keep their order when that happens, so any gap left by a deleted record
+ * closes up and the highest rowid falls. The two are found from the ends of each b-tree, so the check is cheap
+ * enough to make before every text search. Uses the following SQL:
+ * @code select (select MAX(rowid) from ACRONYMS) is (select MAX(id) from ACRONYMS_FTS_docsize);
  */
-bool latest_acronym(amtdb_struct *amtdb)
+static bool fts_index_in_step(amtdb_struct *amtdb)
 {
-    sqlite3_stmt *stmt = NULL;   	    /* pre-prepared SQL query statement */
-    bool result = false;
+    bool in_step = false;
+    sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_FTS_IN_STEP);
+    if (stmt != NULL && step_stmt(amtdb, AMT_STMT_FTS_IN_STEP) == SQLITE_ROW) {
+        in_step = (sqlite3_column_int(stmt, 0) == 1);
+    }
+    release_stmt(amtdb, AMT_STMT_FTS_IN_STEP);
+    return in_step;
+}
+
+
+/**
+ * @brief Ensure the FTS5 full text index over 'Definition' and 'Description' exists, and is kept in sync.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : success status for functions execution.
+ * @note The index is an external content FTS5 table, so no acronym text is duplicated. It is created on first use of
+ * a text search, populated with a one off 'rebuild', and then maintained by triggers on 'ACRONYMS' for any changes.
+ * The index finds records by their rowid. As 'ACRONYMS' has no 'INTEGER PRIMARY KEY' of its own, and adding one
+ * would mean copying the table of a database other programs may also use, the index is instead checked before each
+ * search, and rebuilt if the rowids have changed under it or any of its triggers is missing.
+ * @code CREATE VIRTUAL TABLE ACRONYMS_FTS USING fts5(Definition, Description, content='ACRONYMS', content_rowid='rowid');
+ */
+bool ensure_fts_index(amtdb_struct *amtdb)
+{
+    const bool exists = db_object_exists(amtdb, "table", "ACRONYMS_FTS");
+    if (exists && db_object_exists(amtdb, "trigger", "ACRONYMS_FTS_AI") &&
+        db_object_exists(amtdb, "trigger", "ACRONYMS_FTS_AD") && db_object_exists(amtdb, "trigger", "ACRONYMS_FTS_AU") &&
+        fts_index_in_step(amtdb)) {
+        return true;
+    }
 
-    int rc = sqlite3_prepare_v2(amtdb->db,
-                                "select rowid,ifnull(Acronym,''), "
-                                "ifnull(Definition,''), "
-                                "ifnull(Source,''), "
-                                "ifnull(Description,''), "
-                                "ifnull(Changed,'') "
-                                "from ACRONYMS "
-                                "Order by rowid DESC LIMIT 5;",
-                                -1, &stmt, NULL);
+#if DEBUG
+    fprintf(stderr, "DEBUG: %s the FTS5 index 'ACRONYMS_FTS' and its triggers\n", exists ? "rebuilding" : "creating");
+#endif
 
+    /** @note kept off stdout when it is being read by another program */
+    fprintf((amtdb->format == OUTPUT_TEXT) ? stdout : stderr, "\n%s\n",
+            exists ? "Rebuilding the full text search index, as it no longer matches the records..."
+                   : "Building the full text search index (one off task)...");
+
+    /** @note all in one transaction so a failure leaves no partial index or triggers behind */
+    int rc = sqlite3_exec(amtdb->db,
+                      "BEGIN IMMEDIATE;"
+                      "CREATE VIRTUAL TABLE IF NOT EXISTS ACRONYMS_FTS USING fts5("
+                      "Definition, Description, content='ACRONYMS', content_rowid='rowid');"
+                      "CREATE TRIGGER IF NOT EXISTS ACRONYMS_FTS_AI AFTER INSERT ON ACRONYMS BEGIN "
+                      "INSERT INTO ACRONYMS_FTS(rowid, Definition, Description) "
+                      "VALUES (new.rowid, new.Definition, new.Description); END;"
+                      "CREATE TRIGGER IF NOT EXISTS ACRONYMS_FTS_AD AFTER DELETE ON ACRONYMS BEGIN "
+                      "INSERT INTO ACRONYMS_FTS(ACRONYMS_FTS, rowid, Definition, Description) "
+                      "VALUES ('delete', old.rowid, old.Definition, old.Description); END;"
+                      "CREATE TRIGGER IF NOT EXISTS ACRONYMS_FTS_AU AFTER UPDATE ON ACRONYMS BEGIN "
+                      "INSERT INTO ACRONYMS_FTS(ACRONYMS_FTS, rowid, Definition, Description) "
+                      "VALUES ('delete', old.rowid, old.Definition, old.Description); "
+                      "INSERT INTO ACRONYMS_FTS(rowid, Definition, Description) "
+                      "VALUES (new.rowid, new.Definition, new.Description); END;"
+                      "INSERT INTO ACRONYMS_FTS(ACRONYMS_FTS) VALUES ('rebuild');"
+                      "COMMIT;",
+                      NULL, NULL, NULL);
     if (rc != SQLITE_OK) {
-        fprintf(stderr, "SQL prepare error: %s\n", sqlite3_errmsg(amtdb->db));
-        result = false;
-        exit(EXIT_FAILURE);
+        fprintf(stderr, "ERROR: unable to create the full text search index: %s\n", sqlite3_errmsg(amtdb->db));
+        sqlite3_exec(amtdb->db, "ROLLBACK;", NULL, NULL, NULL);
+        return false;
     }
 
-    int searchRecCount = 0;
-    printf("\nFive newest acronym records added are:\n");
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        printf("\nID:          %s\n", (const char *)sqlite3_column_text(stmt, 0));
-        printf("ACRONYM:     '%s' is: '%s'.\n",
-               (const char *)sqlite3_column_text(stmt, 1),
-               (const char *)sqlite3_column_text(stmt, 2));
-        printf("SOURCE:      '%s'\n",
-               (const char *)sqlite3_column_text(stmt, 3));
-        printf("LAST UPDATE: %s\n", (const char *)sqlite3_column_text(stmt, 5));
-        printf("DESCRIPTION: %s\n", (const char *)sqlite3_column_text(stmt, 4));
-        searchRecCount++;
+    return true;
+}
+
+
+/**
+ * @brief Convert the users search words into a safe FTS5 query, where each word is quoted as a literal term.
+ * @param char *findme : Pointer to a string containing the words to be searched for.
+ * @return char* : a pointer to a sqlite3 heap allocated string to be freed with 'sqlite3_free()', or NULL.
+ * @note Words such as 'NOT' or characters such as '-' and '*' would otherwise be parsed as FTS5 query syntax. All
+ * the words must be present in a record for it to match.
+ */
+static char *build_fts_query(const char *findme)
+{
+    sqlite3_str *query = sqlite3_str_new(NULL);
+    const char *pos = findme;
+
+    while (*pos != '\0') {
+        /* skip any white space before the next word */
+        while (*pos == ' ' || *pos == '\t') {
+            pos++;
+        }
+        if (*pos == '\0') {
+            break;
+        }
+        if (sqlite3_str_length(query) > 0) {
+            sqlite3_str_appendchar(query, 1, ' ');
+        }
+        sqlite3_str_appendchar(query, 1, '"');
+        while (*pos != '\0' && *pos != ' ' && *pos != '\t') {
+            /* a double quote inside a FTS5 string is escaped by doubling it */
+            if (*pos == '"') {
+                sqlite3_str_appendchar(query, 1, '"');
+            }
+            sqlite3_str_appendchar(query, 1, *pos);
+            pos++;
+        }
+        sqlite3_str_appendchar(query, 1, '"');
     }
 
-    sqlite3_finalize(stmt);
+    if (sqlite3_str_length(query) == 0) {
+        sqlite3_free(sqlite3_str_finish(query));
+        return NULL;
+    }
 
-    return result = true;
+    return sqlite3_str_finish(query);
 }
 
 
 /**
- * @brief Search for the provided acronym in the database and return the matching number of records found.
- * @param char *findme : Pointer to a string containing the acronym to be searched for.
+ * @brief Search the acronyms 'Definition' and 'Description' text for the provided words; return matches found.
+ * @param char *findme : Pointer to a string containing the words to be searched for.
  * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
- * @return int : the number of matching acronyms found in the database.
- * @note Uses the following SQL:
- * @code select rowid,ifnull(Acronym,''), ifnull(Definition,''), ifnull(Source,''), ifnull(Description,'')
- * from ACRONYMS where Acronym like ? COLLATE NOCASE ORDER BY Source;
+ * @return int : the number of matching acronyms found in the database, or '-1' on failure.
+ * @note Results are output best match first, as ranked by the FTS5 'bm25()' function. Uses the following SQL:
+ * @code select a.rowid,ifnull(a.Acronym,''), ifnull(a.Definition,''), ifnull(a.Source,''), ifnull(a.Description,'')
+ * from ACRONYMS_FTS f join ACRONYMS a on a.rowid = f.rowid where ACRONYMS_FTS match ? ORDER BY bm25(ACRONYMS_FTS);
  */
-int do_acronym_search(char *findme, amtdb_struct *amtdb)
+int do_text_search(char *findme, amtdb_struct *amtdb)
 {
-    sqlite3_stmt *stmt = NULL;   	    /* pre-prepared SQL query statement */
+    if (!ensure_fts_index(amtdb)) {
+        return -1;
+    }
 
-    int rc = sqlite3_prepare_v2(amtdb->db,
-                            "select rowid,ifnull(Acronym,''), "
-                            "ifnull(Definition,''), "
-                            "ifnull(Source,''), "
-                            "ifnull(Description,''), "
-                            "ifnull(Changed,'') "
-                            "from ACRONYMS where Acronym like ? "
-                            "COLLATE NOCASE ORDER BY Source;",
-                            -1, &stmt, NULL);
+    char *fts_query = build_fts_query(findme);
+    if (fts_query == NULL) {
+        fprintf(stderr, "ERROR: no words were provided to search for.\n");
+        return -1;
+    }
 
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "SQL prepare error: %s\n", sqlite3_errmsg(amtdb->db));
-        exit(EXIT_FAILURE);
+#if DEBUG
+    fprintf(stderr, "DEBUG: FTS5 query is: '%s'\n", fts_query);
+#endif
+
+    sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_TEXT_SEARCH);   /* pre-prepared SQL query statement */
+
+    if (stmt == NULL) {
+        sqlite3_free(fts_query);
+        return -1;
     }
 
-    rc = sqlite3_bind_text(stmt, 1, (const char *)findme, -1, SQLITE_STATIC);
+    int rc = sqlite3_bind_text(stmt, 1, (const char *)fts_query, -1, sqlite3_free);
 
     if (rc != SQLITE_OK) {
         fprintf(stderr, "SQL bind error: %s\n", sqlite3_errmsg(amtdb->db));
-        exit(EXIT_FAILURE);
+        release_stmt(amtdb, AMT_STMT_TEXT_SEARCH);
+        return -1;
     }
 
     int searchRecCount = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        printf("\nID:          %s\n", (const char *)sqlite3_column_text(stmt, 0));
-        printf("ACRONYM:     '%s' is: '%s'.\n",
-               (const char *)sqlite3_column_text(stmt, 1),
-               (const char *)sqlite3_column_text(stmt, 2));
-        printf("SOURCE:      '%s'\n",
-               (const char *)sqlite3_column_text(stmt, 3));
-        printf("LAST UPDATE: %s\n", (const char *)sqlite3_column_text(stmt, 5));
-        printf("DESCRIPTION: %s\n", (const char *)sqlite3_column_text(stmt, 4));
+    while (step_stmt(amtdb, AMT_STMT_TEXT_SEARCH) == SQLITE_ROW) {
+        outbuf_record(stmt);
         searchRecCount++;
     }
+    outbuf_flush();
 
-    sqlite3_finalize(stmt);
+    release_stmt(amtdb, AMT_STMT_TEXT_SEARCH);
 
     return searchRecCount;
 }
 
+/**
+ * @brief Get the most entries to keep in a linenoise history, for the record prompts and the shell alike.
+ * @return int : 'AMT_HISTORY_LEN', or the value of env 'AMT_HISTORY_LEN' if it is set to a valid number.
+ * @note The env is read on the first call only, so a bad value is only warned about once.
+ */
+int history_max_len(void)
+{
+    static int max_len = 0;
+
+    if (max_len == 0) {
+        max_len = AMT_HISTORY_LEN;
+        const char *len_env = getenv("AMT_HISTORY_LEN");
+        if (len_env != NULL && len_env[0] != '\0') {
+            const long len = strtol(len_env, NULL, 10);
+            if (len > 0 && len <= INT_MAX) {
+                max_len = (int)len;
+            } else {
+                fprintf(stderr, "WARNING: ignoring 'AMT_HISTORY_LEN' of '%s' - not a valid number.\n", len_env);
+            }
+        }
+    }
+    return max_len;
+}
+
+
 /**
  * @brief Ensure sane base setting for linenoise prior to is usse in the 'delete'; 'update'; and 'new' functions.
  * @param none
@@ -427,7 +1549,27 @@ void linenoise_initialise(void) {
     /** @note max size of the number if items to hold in the linenoise history that
      * must be greater than '0' to enable in linenoise library.
      */
-    linenoiseHistorySetMaxLen(20);
+    linenoiseHistorySetMaxLen(history_max_len());
+}
+
+
+/**
+ * @brief Free the answers given so far to the record prompts, when the input of a record is ended without saving it.
+ * @param bool aborted : true if it was ended by 'Ctrl + c' or the end of input, where 'linenoise()' returns NULL.
+ * @return bool : always false, to be returned by the caller as the record was not saved.
+ * @note Answers not yet given are NULL, which 'free()' ignores.
+ */
+static bool record_entry_ended(bool aborted, char *complete, char *acro, char *expd, char *desc, char *src)
+{
+    if (aborted) {
+        printf("\nInput of the record was abandoned - no changes were made.\n\n");
+    }
+    free(complete);
+    free(acro);
+    free(expd);
+    free(desc);
+    free(src);
+    return false;
 }
 
 
@@ -440,7 +1582,6 @@ void linenoise_initialise(void) {
  */
 bool new_acronym(amtdb_struct *amtdb)
 {
-    sqlite3_stmt *stmt = NULL;
     set_record_count(amtdb);
 
     linenoise_initialise();
@@ -454,17 +1595,39 @@ bool new_acronym(amtdb_struct *amtdb)
     char *nAcroDesc = NULL;
     char *nAcroSrc = NULL;
 
+    /** @note show any existing acronym matching what is typed, so a duplicate is seen before it is entered */
+    hints_load(amtdb);
+
     while (1) {
+        linenoiseSetHintsCallback(acronym_hint);
+        linenoiseSetCompletionCallback(acronym_completion);
         nAcro = linenoise("Enter the acronym: ");
+        linenoiseSetHintsCallback(NULL);
+        linenoiseSetCompletionCallback(NULL);
+        /** @note 'linenoise()' returns NULL for 'Ctrl + c' or the end of input: the record is not wanted */
+        if (nAcro == NULL) {
+            return record_entry_ended(true, complete, nAcro, nAcroExpd, nAcroDesc, nAcroSrc);
+        }
         linenoiseHistoryAdd(nAcro);
         nAcroExpd = linenoise("Enter the expanded acronym: ");
+        if (nAcroExpd == NULL) {
+            return record_entry_ended(true, complete, nAcro, nAcroExpd, nAcroDesc, nAcroSrc);
+        }
         linenoiseHistoryAdd(nAcroExpd);
         puts("Enter the acronym description:\n");
         nAcroDesc = linenoise("");
+        if (nAcroDesc == NULL) {
+            return record_entry_ended(true, complete, nAcro, nAcroExpd, nAcroDesc, nAcroSrc);
+        }
         linenoiseHistoryAdd(nAcroDesc);
         puts("\n");
         get_acronym_src_list(amtdb);
+        linenoiseSetCompletionCallback(source_completion);
         nAcroSrc = linenoise("Enter the acronym source: ");
+        linenoiseSetCompletionCallback(NULL);
+        if (nAcroSrc == NULL) {
+            return record_entry_ended(true, complete, nAcro, nAcroExpd, nAcroDesc, nAcroSrc);
+        }
         linenoiseHistoryAdd(nAcroSrc);
 
         printf("\nConfirm entry for:\n\n");
@@ -473,65 +1636,60 @@ bool new_acronym(amtdb_struct *amtdb)
         printf("SOURCE:      %s\n\n", nAcroSrc);
 
         complete = linenoise("Enter record? [ y/n or q ] : ");
+        if (complete == NULL) {
+            return record_entry_ended(true, complete, nAcro, nAcroExpd, nAcroDesc, nAcroSrc);
+        }
         if (strcasecmp((const char *)complete, "y") == 0) {
             break;
         }
         if (strcasecmp((const char *)complete, "q") == 0) {
-            /* Clean up linenoise allocated memory */
-            if (complete != NULL) {
-                free(complete);
-            }
-            if (nAcro != NULL) {
-                free(nAcro);
-            }
-            if (nAcroExpd != NULL) {
-                free(nAcroExpd);
-            }
-            if (nAcroDesc != NULL) {
-                free(nAcroDesc);
-            }
-            if (nAcroSrc != NULL) {
-                free(nAcroSrc);
-            }
             // TODO: linenoise for below ??
             // clear_history();
-            return false;
+            return record_entry_ended(false, complete, nAcro, nAcroExpd, nAcroDesc, nAcroSrc);
         }
+        /* the record is entered again: the answers are still in the history to be recalled */
+        record_entry_ended(false, complete, nAcro, nAcroExpd, nAcroDesc, nAcroSrc);
+        complete = nAcro = nAcroExpd = nAcroDesc = nAcroSrc = NULL;
     }
 
-    char *sqlInsNew = NULL;
-    sqlInsNew = sqlite3_mprintf("insert into ACRONYMS"
-                              "(Acronym, Definition, Description, Source) "
-                              "values(%Q,%Q,%Q,%Q);",
-                                nAcro, nAcroExpd, nAcroDesc, nAcroSrc);
+    /** @note the record and the fuzzy index are written in one transaction, waiting for any other writer first */
+    sqlite3_stmt *stmt = begin_write(amtdb) ? get_stmt(amtdb, AMT_STMT_INSERT) : NULL;
+    int rc = SQLITE_ERROR;
 
-    int rc = sqlite3_prepare_v2(amtdb->db, sqlInsNew, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "SQL prepare error: %s\n", sqlite3_errmsg(amtdb->db));
-        /* Clean up linenoiseallocated memory */
-        if (complete != NULL) {
-            free(complete);
+    /** @note the users text is bound as parameters - so needs no SQL quoting or escaping */
+    if (stmt != NULL) {
+        rc = sqlite3_bind_text(stmt, 1, nAcro, -1, SQLITE_STATIC);
+        if (rc == SQLITE_OK) {
+            rc = sqlite3_bind_text(stmt, 2, nAcroExpd, -1, SQLITE_STATIC);
         }
-        if (nAcro != NULL) {
-            free(nAcro);
+        if (rc == SQLITE_OK) {
+            rc = sqlite3_bind_text(stmt, 3, nAcroDesc, -1, SQLITE_STATIC);
         }
-        if (nAcroExpd != NULL) {
-            free(nAcroExpd);
+        if (rc == SQLITE_OK) {
+            rc = sqlite3_bind_text(stmt, 4, nAcroSrc, -1, SQLITE_STATIC);
         }
-        if (nAcroDesc != NULL) {
-            free(nAcroDesc);
+        if (rc == SQLITE_OK) {
+            rc = step_stmt(amtdb, AMT_STMT_INSERT);
         }
-        if (nAcroSrc != NULL) {
-            free(nAcroSrc);
+        if (rc != SQLITE_DONE) {
+            fprintf(stderr, "SQL exec error: %s\n", sqlite3_errmsg(amtdb->db));
         }
-        // TODO: linenoise for below ??
-        // clear_history();
-        return false;
+        release_stmt(amtdb, AMT_STMT_INSERT);
     }
 
-    rc = sqlite3_exec(amtdb->db, sqlInsNew, NULL, NULL, NULL);
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "SQL exec error: %s\n", sqlite3_errmsg(amtdb->db));
+    if (rc == SQLITE_DONE) {
+        /* keep the 'did you mean' index up to date - a failure here does not undo the new record */
+        if (!fuzzy_index_add(amtdb, nAcro)) {
+            fprintf(stderr, "WARNING: unable to add '%s' to the fuzzy search index.\n", nAcro);
+        }
+        if (!end_write(amtdb, true)) {
+            rc = SQLITE_ERROR;
+        }
+    } else {
+        end_write(amtdb, false);
+    }
+
+    if (rc != SQLITE_DONE) {
         /* Clean up linenoiseallocated memory */
         if (complete != NULL) {
             free(complete);
@@ -553,12 +1711,8 @@ bool new_acronym(amtdb_struct *amtdb)
         return false;
     }
 
-    sqlite3_finalize(stmt);
-
-    /* free up any allocated memory by sqlite3 */
-    if (sqlInsNew != NULL) {
-        sqlite3_free(sqlInsNew);
-    }
+    hints_add(nAcro, nAcroExpd);
+    sources_changed();
 
     /* Clean up linenoiseallocated memory */
     if (complete != NULL) {
@@ -599,7 +1753,6 @@ bool new_acronym(amtdb_struct *amtdb)
  */
 bool delete_acronym_record(int delRecId, amtdb_struct *amtdb)
 {
-    sqlite3_stmt *stmt = NULL;
     set_record_count(amtdb);
 
     linenoise_initialise();
@@ -610,68 +1763,80 @@ bool delete_acronym_record(int delRecId, amtdb_struct *amtdb)
 
     printf("\nSearching for record ID: '%d' in database...\n\n", delRecId);
 
-    int rc = sqlite3_prepare_v2(amtdb->db,
-                            "select rowid,Acronym,Definition,Description,"
-                            "Source from ACRONYMS where rowid like ?;",
-                            -1, &stmt, NULL);
+    sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_RECORD_BY_ID);
 
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "SQL prepare error: %s\n", sqlite3_errmsg(amtdb->db));
+    if (stmt == NULL) {
         exit(EXIT_FAILURE);
     }
 
-    rc = sqlite3_bind_int(stmt, 1, delRecId);
+    int rc = sqlite3_bind_int(stmt, 1, delRecId);
     if (rc != SQLITE_OK) {
         fprintf(stderr, "SQL bind error: %s\n", sqlite3_errmsg(amtdb->db));
         exit(EXIT_FAILURE);
     }
 
     int deleteRecCount = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        printf("ID:          %s\n", (const char *)sqlite3_column_text(stmt, 0));
-        printf("ACRONYM:     '%s' is: %s.\n",
-               (const char *)sqlite3_column_text(stmt, 1),
-               (const char *)sqlite3_column_text(stmt, 2));
-        printf("DESCRIPTION: %s\n", (const char *)sqlite3_column_text(stmt, 3));
-        printf("SOURCE: %s\n", (const char *)sqlite3_column_text(stmt, 4));
+    char *delAcro = NULL;
+    while (step_stmt(amtdb, AMT_STMT_RECORD_BY_ID) == SQLITE_ROW) {
+        outbuf_record_detail(stmt);
+        /* keep a copy of the acronym so it can be removed from the fuzzy search index */
+        if (delAcro == NULL) {
+            delAcro = strdup((const char *)sqlite3_column_text(stmt, 1));
+        }
         deleteRecCount++;
     }
+    outbuf_flush();
 
-    sqlite3_finalize(stmt);
+    release_stmt(amtdb, AMT_STMT_RECORD_BY_ID);
 
     if (deleteRecCount == 1) {
         char *continueDelete = NULL;
         puts("");
         continueDelete = linenoise("Delete above record? [ y/n ] : ");
-        if (strcasecmp((const char *)continueDelete, "y") == 0) {
+        if (continueDelete != NULL && strcasecmp((const char *)continueDelete, "y") == 0) {
 
             /* free 'linenoise memory as no longer used */
             if (continueDelete != NULL) {
                 free(continueDelete);
             }
 
-            rc = sqlite3_prepare_v2(amtdb->db,
-                                    "delete from ACRONYMS where "
-                                    "rowid = ?;",
-                                    -1, &stmt, NULL);
-            if (rc != SQLITE_OK) {
-                fprintf(stderr, "SQL prepare error: %s\n", sqlite3_errmsg(amtdb->db));
+            /** @note the record and the fuzzy index are written in one transaction */
+            stmt = begin_write(amtdb) ? get_stmt(amtdb, AMT_STMT_DELETE) : NULL;
+            if (stmt == NULL) {
+                end_write(amtdb, false);
+                free(delAcro);
                 return false;
             }
 
             rc = sqlite3_bind_int(stmt, 1, delRecId);
             if (rc != SQLITE_OK) {
                 fprintf(stderr, "SQL bind error: %s\n", sqlite3_errmsg(amtdb->db));
+                release_stmt(amtdb, AMT_STMT_DELETE);
+                end_write(amtdb, false);
+                free(delAcro);
                 return false;
             }
 
-            rc = sqlite3_step(stmt);
+            rc = step_stmt(amtdb, AMT_STMT_DELETE);
             if (rc != SQLITE_DONE) {
                 fprintf(stderr, "SQL step error: %s\n", sqlite3_errmsg(amtdb->db));
+                release_stmt(amtdb, AMT_STMT_DELETE);
+                end_write(amtdb, false);
+                free(delAcro);
                 return false;
             }
 
-           sqlite3_finalize(stmt);
+            release_stmt(amtdb, AMT_STMT_DELETE);
+
+            if (!fuzzy_index_remove(amtdb, delAcro)) {
+                fprintf(stderr, "WARNING: unable to remove '%s' from the fuzzy search index.\n", delAcro);
+            }
+            if (!end_write(amtdb, true)) {
+                free(delAcro);
+                return false;
+            }
+            hints_remove(amtdb, delAcro);
+            sources_changed();
         } else {
             /* free 'linenoise memory as no longer used */
             if (continueDelete != NULL) {
@@ -691,6 +1856,8 @@ bool delete_acronym_record(int delRecId, amtdb_struct *amtdb)
                delRecId, deleteRecCount);
     }
 
+    free(delAcro);
+
     set_record_count(amtdb);
     printf("Deleted '%d' record. Total database record count is now"
            " %'d (was %'d).\n",
@@ -701,41 +1868,35 @@ bool delete_acronym_record(int delRecId, amtdb_struct *amtdb)
 
 
 /**
- * @brief Gets a list of all the 'source' entries from the SQLite database, and adds them to the linenoisehistory.
+ * @brief Load the list of all the 'source' entries from the SQLite database, for tab completion at the source prompt,
+ * and show the most used of them.
  * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
- * @note Uses the following SQL to delete the record:
- * @code select distinct(source) from acronyms;
+ * @note The sources and their counts are read from the trigger maintained 'ACRONYMS_SOURCES' table by
+ * 'sources_load()', and read again only after a record is added, changed or deleted.
  */
 void get_acronym_src_list(amtdb_struct *amtdb)
 {
-    sqlite3_stmt *stmt = NULL;
-    int rc = sqlite3_prepare_v2(amtdb->db,
-                            "select distinct(source) "
-                            "from acronyms order by source;",
-                            -1, &stmt, NULL);
-
-    if (rc != SQLITE_OK) {
+    if (!sources_load(amtdb)) {
         exit(-1);
     }
 
-    char *acroSrcName;
-
-    printf("\nSelect a source (use ↑ or ↓ ):\n\n");
+    const size_t count = sources_count();
+    if (count == 0) {
+        return;
+    }
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        acroSrcName = strdup((const char *)sqlite3_column_text(stmt, 0));
-        printf("[ %s ] ", acroSrcName);
-        linenoiseHistoryAdd(acroSrcName);
+    printf("\nSelect a source (type the start of it and press 'tab' to complete):\n\n");
 
-        /* free per loop to stop memory leaks - strdup malloc
-         * above */
-        if (acroSrcName != NULL) {
-            free(acroSrcName);
-        }
+    const char *found[AMT_SOURCES_MAX_SHOWN];
+    int uses[AMT_SOURCES_MAX_SHOWN];
+    const size_t shown = sources_complete("", found, uses, AMT_SOURCES_MAX_SHOWN);
+    for (size_t i = 0; i < shown; i++) {
+        printf("[ %s (%'d) ] ", found[i], uses[i]);
+    }
+    if (count > shown) {
+        printf("\n\nThe '%'zu' most used of '%'zu' known sources are shown.", shown, count);
     }
     printf("\n");
-
-    sqlite3_finalize(stmt);
 }
 
 
@@ -750,7 +1911,6 @@ void get_acronym_src_list(amtdb_struct *amtdb)
  */
 bool update_acronym_record(int updateRecId, amtdb_struct *amtdb)
 {
-    sqlite3_stmt *stmt = NULL;
     set_record_count(amtdb);
 
     linenoise_initialise();
@@ -760,32 +1920,28 @@ bool update_acronym_record(int updateRecId, amtdb_struct *amtdb)
 
     printf("\nSearching for record ID: '%d' in database...\n\n", updateRecId);
 
-    int rc = sqlite3_prepare_v2(amtdb->db,
-                           "select rowid, ifnull(Acronym,''),"
-                           " ifnull(Definition,''), ifnull(Description,''),"
-                           " ifnull(Source,'') from ACRONYMS where rowid is ?;",
-                           -1, &stmt, NULL);
+    sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_RECORD_BY_ID);
 
-    if (rc != SQLITE_OK) {
-        fprintf(stderr, "SQL prepare error: %s\n", sqlite3_errmsg(amtdb->db));
+    if (stmt == NULL) {
         return false;
     }
 
-    rc = sqlite3_bind_int(stmt, 1, updateRecId);
+    int rc = sqlite3_bind_int(stmt, 1, updateRecId);
     if (rc != SQLITE_OK) {
         fprintf(stderr, "SQL bind error: %s\n", sqlite3_errmsg(amtdb->db));
         return false;
     }
 
+    /** @note copy of the current acronym for the fuzzy search index and the hints. One byte longer than the longer
+     * of their limits, the hints, so an acronym too long for either stays too long when truncated and is ignored by
+     * 'fuzzy_index_remove()' and 'hints_remove()'.
+     */
+    char oldAcro[AMT_HINTS_MAX_LEN + 2] = "";
     int updateRecCount = 0;
-    while ( sqlite3_step(stmt) == SQLITE_ROW) {
-        printf("ID:          %s\n", (const char *)sqlite3_column_text(stmt, 0));
-        printf("ACRONYM:     '%s' is: %s.\n",
-               (const char *)sqlite3_column_text(stmt, 1),
-               (const char *)sqlite3_column_text(stmt, 2));
-
-        printf("DESCRIPTION: %s\n", (const char *)sqlite3_column_text(stmt, 3));
-        printf("SOURCE: %s\n", (const char *)sqlite3_column_text(stmt, 4));
+    while (step_stmt(amtdb, AMT_STMT_RECORD_BY_ID) == SQLITE_ROW) {
+        outbuf_record_detail(stmt);
+        snprintf(oldAcro, sizeof(oldAcro), "%s", (const char *)sqlite3_column_text(stmt, 1));
+
         /* grab a copy of the returned record id fields into Readline
          * history - for user recall later to save re-typing entries */
         linenoiseHistoryAdd((const char *)sqlite3_column_text(stmt, 1));
@@ -794,15 +1950,16 @@ bool update_acronym_record(int updateRecId, amtdb_struct *amtdb)
         linenoiseHistoryAdd((const char *)sqlite3_column_text(stmt, 4));
         updateRecCount++;
     }
+    outbuf_flush();
 
-    sqlite3_finalize(stmt);
+    release_stmt(amtdb, AMT_STMT_RECORD_BY_ID);
 
     /* if we found a record to update */
     if (updateRecCount == 1) {
         char *continueDelete = NULL;
         puts("");
         continueDelete = linenoise("Update above record? [ y/n ] : ");
-        if (strcasecmp((const char *)continueDelete, "y") == 0) {
+        if (continueDelete != NULL && strcasecmp((const char *)continueDelete, "y") == 0) {
 
             /* free 'linenoise memory as no longer used */
             if (continueDelete != NULL) {
@@ -818,17 +1975,38 @@ bool update_acronym_record(int updateRecId, amtdb_struct *amtdb)
             printf("\nUse ↑ or ↓ keys to select previous entries text "
                    "for re-editing or just type in new:\n\n");
 
+            hints_load(amtdb);
+
             while (1) {
+                linenoiseSetHintsCallback(acronym_hint);
+                linenoiseSetCompletionCallback(acronym_completion);
                 uAcro = linenoise("Enter the acronym: ");
+                linenoiseSetHintsCallback(NULL);
+                linenoiseSetCompletionCallback(NULL);
+                /** @note 'linenoise()' returns NULL for 'Ctrl + c' or the end of input: the update is not wanted */
+                if (uAcro == NULL) {
+                    return record_entry_ended(true, complete, uAcro, uAcroExpd, uAcroDesc, uAcroSrc);
+                }
                 linenoiseHistoryAdd(uAcro);
                 uAcroExpd = linenoise("Enter the expanded acronym: ");
+                if (uAcroExpd == NULL) {
+                    return record_entry_ended(true, complete, uAcro, uAcroExpd, uAcroDesc, uAcroSrc);
+                }
                 linenoiseHistoryAdd(uAcroExpd);
                 puts("Enter the acronym description:\n");
                 uAcroDesc = linenoise("");
+                if (uAcroDesc == NULL) {
+                    return record_entry_ended(true, complete, uAcro, uAcroExpd, uAcroDesc, uAcroSrc);
+                }
                 linenoiseHistoryAdd(uAcroDesc);
                 get_acronym_src_list(amtdb);
                 puts("");
+                linenoiseSetCompletionCallback(source_completion);
                 uAcroSrc = linenoise("Enter the acronym source: ");
+                linenoiseSetCompletionCallback(NULL);
+                if (uAcroSrc == NULL) {
+                    return record_entry_ended(true, complete, uAcro, uAcroExpd, uAcroDesc, uAcroSrc);
+                }
                 linenoiseHistoryAdd(uAcroSrc);
 
                 printf("\nConfirm entry for:\n\n");
@@ -837,48 +2015,27 @@ bool update_acronym_record(int updateRecId, amtdb_struct *amtdb)
                 printf("SOURCE:      %s\n\n", uAcroSrc);
 
                 complete = linenoise("Enter record? [ y/n or q ] : ");
+                if (complete == NULL) {
+                    return record_entry_ended(true, complete, uAcro, uAcroExpd, uAcroDesc, uAcroSrc);
+                }
                 if (strcasecmp((const char *)complete, "y") == 0) {
                     /* Clean up linenoiseallocated memory */
-                    if (complete != NULL) {
-                        free(complete);
-                    }
+                    free(complete);
                     break;
                 }
                 if (strcasecmp((const char *)complete, "q") == 0) {
-                    /* Clean up linenoiseallocated memory */
-                    if (complete != NULL) {
-                        free(complete);
-                    }
-                    if (uAcro != NULL) {
-                        free(uAcro);
-                    }
-                    if (uAcroExpd != NULL) {
-                        free(uAcroExpd);
-                    }
-                    if (uAcroDesc != NULL) {
-                        free(uAcroDesc);
-                    }
-                    if (uAcroSrc != NULL) {
-                        free(uAcroSrc);
-                    }
                     // TODO: linenoise for below ??
                     // clear_history();
-                    return false;
+                    return record_entry_ended(false, complete, uAcro, uAcroExpd, uAcroDesc, uAcroSrc);
                 }
+                /* the record is entered again: the answers are still in the history to be recalled */
+                record_entry_ended(false, complete, uAcro, uAcroExpd, uAcroDesc, uAcroSrc);
+                complete = uAcro = uAcroExpd = uAcroDesc = uAcroSrc = NULL;
             }
 
-            char *sqlUpdate = NULL;
-
-            /* build SQLite 'UPDATE' query */
-            sqlUpdate =
-                sqlite3_mprintf("update ACRONYMS set Acronym=%Q, "
-                                "Definition=%Q, Description=%Q, "
-                                "Source=%Q where rowid is ?;",
-                                uAcro, uAcroExpd, uAcroDesc, uAcroSrc);
-
-            rc = sqlite3_prepare_v2(amtdb->db, sqlUpdate, -1, &stmt, NULL);
-            if (rc != SQLITE_OK) {
-                fprintf(stderr, "SQL prepare error: %s\n", sqlite3_errmsg(amtdb->db));
+            /* get the SQLite 'UPDATE' query */
+            stmt = get_stmt(amtdb, AMT_STMT_UPDATE);
+            if (stmt == NULL) {
                 if (uAcro != NULL) {
                     free(uAcro);
                 }
@@ -896,11 +2053,24 @@ bool update_acronym_record(int updateRecId, amtdb_struct *amtdb)
                 return false;
             }
 
-            /* bind in the record id to UPDATE */
-            rc = sqlite3_bind_int(stmt, 1, updateRecId);
+            /* bind in the new field values and the record id to UPDATE */
+            rc = sqlite3_bind_text(stmt, 1, uAcro, -1, SQLITE_STATIC);
+            if (rc == SQLITE_OK) {
+                rc = sqlite3_bind_text(stmt, 2, uAcroExpd, -1, SQLITE_STATIC);
+            }
+            if (rc == SQLITE_OK) {
+                rc = sqlite3_bind_text(stmt, 3, uAcroDesc, -1, SQLITE_STATIC);
+            }
+            if (rc == SQLITE_OK) {
+                rc = sqlite3_bind_text(stmt, 4, uAcroSrc, -1, SQLITE_STATIC);
+            }
+            if (rc == SQLITE_OK) {
+                rc = sqlite3_bind_int(stmt, 5, updateRecId);
+            }
             if (rc != SQLITE_OK) {
                 fprintf(stderr, "SQL exec error: %s\n", sqlite3_errmsg(amtdb->db));
-                 if (uAcro != NULL) {
+                release_stmt(amtdb, AMT_STMT_UPDATE);
+                if (uAcro != NULL) {
                     free(uAcro);
                 }
                 if (uAcroExpd != NULL) {
@@ -920,8 +2090,9 @@ bool update_acronym_record(int updateRecId, amtdb_struct *amtdb)
             /* reset updateRecCount so can re-use here */
             updateRecCount = 0;
 
-            /* perform the actual database update */
-            while ( (rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            /* perform the actual database update, with the fuzzy index, in one transaction */
+            rc = begin_write(amtdb) ? SQLITE_ROW : SQLITE_BUSY;
+            while (rc == SQLITE_ROW && (rc = step_stmt(amtdb, AMT_STMT_UPDATE)) == SQLITE_ROW) {
                 /* should not run here as 'sqlite3_step(stmt)'
                    should
                    immediately return with SQLITE_DONE for an
@@ -931,6 +2102,8 @@ bool update_acronym_record(int updateRecId, amtdb_struct *amtdb)
 
             if (rc != SQLITE_DONE) {
                 fprintf(stderr, "SQL exec error: %s\n", sqlite3_errmsg(amtdb->db));
+                release_stmt(amtdb, AMT_STMT_UPDATE);
+                end_write(amtdb, false);
                 /* Clean up linenoiseallocated memory */
                 if (uAcro != NULL) {
                     free(uAcro);
@@ -968,11 +2141,17 @@ bool update_acronym_record(int updateRecId, amtdb_struct *amtdb)
                        updateRecId, updateRecCount);
             }
 
-            sqlite3_finalize(stmt);
+            release_stmt(amtdb, AMT_STMT_UPDATE);
 
-            /* free up any allocated memory by sqlite3 */
-            if (sqlUpdate != NULL) {
-                sqlite3_free(sqlUpdate);
+            /* move the record to its new acronym in the 'did you mean' index */
+            if (!fuzzy_index_remove(amtdb, oldAcro) || !fuzzy_index_add(amtdb, uAcro)) {
+                fprintf(stderr, "WARNING: unable to update the fuzzy search index for '%s'.\n", uAcro);
+            }
+            const bool committed = end_write(amtdb, true);
+            if (committed) {
+                hints_remove(amtdb, oldAcro);
+                hints_add(uAcro, uAcroExpd);
+                sources_changed();
             }
 
             if (uAcro != NULL) {
@@ -989,6 +2168,9 @@ bool update_acronym_record(int updateRecId, amtdb_struct *amtdb)
             }
             // TODO: linenoise for below ??
             // clear_history();
+            if (!committed) {
+                return false;
+            }
 
             set_record_count(amtdb);
             printf("Updated '%d' record. Total database record count "
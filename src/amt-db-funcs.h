@@ -14,13 +14,43 @@
 #include "types.h"      /** @note Programs own structure to manage SQLite database information */
 #include "sqlite3.h"    /** @note SQLite database C amalgamation header */
 #include <stdbool.h>    /** @note use of true / false booleans for declarations below*/
+#include <stdio.h>      /** @note FILE for batch input */
 
+#define AMT_DB_JOURNAL_MODE "wal"          /** @note journal mode used unless set by env 'AMT_JOURNAL_MODE' */
+#define AMT_DB_BUSY_TIMEOUT 5000           /** @note most milliseconds to wait for a lock, unless set by env */
+#define AMT_DB_BUSY_MAX_SLEEP 100          /** @note longest single wait, in milliseconds, between lock attempts */
+#define AMT_DB_WAL_AUTOCHECKPOINT 1000     /** @note WAL pages written before a checkpoint is run */
+#define AMT_DB_JOURNAL_SIZE_LIMIT 67108864 /** @note bytes the WAL file is cut back to after a checkpoint: 64MB */
+#define AMT_DB_MMAP_SIZE 268435456         /** @note most bytes read through memory mapped I/O when read only: 256MB */
+#define AMT_HISTORY_LEN 100000             /** @note most entries kept in a linenoise history, unless set by env */
+
+sqlite3_stmt *get_stmt(amtdb_struct *amtdb, amt_stmt_id id);     /* get a reset statement from the registry */
+int step_stmt(amtdb_struct *amtdb, amt_stmt_id id);                /* step a registry statement and count it */
+void release_stmt(amtdb_struct *amtdb, amt_stmt_id id);            /* reset a registry statement after use */
+void finalize_stmts(amtdb_struct *amtdb);                          /* finalize all registry statements */
+void output_stmt_stats(amtdb_struct *amtdb);                       /* show registry prepare and step counts */
 bool set_record_count(amtdb_struct *amtdb);                        /* get current acronym record count */
 bool check_4_db_file(amtdb_struct *amtdb);                         /* ensure database exists and is accessible */
 bool check_db_access(amtdb_struct *amtdb);                         /* database file exists and can be accessed? */
+char *find_db_path(const char *prog_name);                         /* full path of the database a command would use */
+bool ensure_meta_table(amtdb_struct *amtdb);                       /* create trigger maintained 'amt_meta' if missing */
+bool read_db_meta(amtdb_struct *amtdb);                            /* get record count and max record ID from 'amt_meta' */
+bool configure_connection(amtdb_struct *amtdb);                    /* set journal mode and busy handling */
 bool initialise_database(amtdb_struct *amtdb);                     /* initialise SQLite and open database file */
+bool reopen_read_write(amtdb_struct *amtdb);                       /* reopen a read only database read write */
+bool begin_write(amtdb_struct *amtdb);                             /* start a write transaction, waiting for the lock */
+bool end_write(amtdb_struct *amtdb, bool commit);                  /* commit or roll back a write transaction */
+void checkpoint_database(amtdb_struct *amtdb);                     /* copy WAL changes to the database on exit */
 char *get_last_acronym(amtdb_struct *amtdb);                       /* get last acronym added to database */
+bool db_object_exists(amtdb_struct *amtdb, const char *type, const char *name); /* is table/index in schema */
+bool ensure_search_index(amtdb_struct *amtdb);                     /* create the acronym search index if missing */
+search_plan plan_acronym_search(const char *findme, char **lower, char **upper); /* exact, prefix or like */
 int do_acronym_search(char *findme, amtdb_struct *amtdb);          /* search database for 'findme' string */
+int do_batch_search(FILE *input, char **terms, int nterms, amtdb_struct *amtdb); /* many searches, one txn */
+bool ensure_fts_index(amtdb_struct *amtdb);                        /* create full text index and triggers if missing */
+int do_text_search(char *findme, amtdb_struct *amtdb);             /* full text search of definitions and descriptions */
+int history_max_len(void);                                         /* most entries kept in a linenoise history */
+void linenoise_initialise(void);                                    /* set up linenoise for the record prompts */
 bool new_acronym(amtdb_struct *amtdb);                             /* add a new record entry to the database */
 void get_acronym_src_list(amtdb_struct *amtdb);                    /* get a list of acronym sources */
 bool delete_acronym_record(int delRecId, amtdb_struct *amtdb);     /* delete a acronym record */
@@ -28,5 +58,6 @@ bool update_acronym_record(int updateRecId, amtdb_struct *amtdb);  /* update a r
 bool output_db_stats(amtdb_struct *amtdb);                         /* show database file, file size, modified date */
 bool update_max_recid(amtdb_struct *amtdb);                        /* obtain max record ID number in the database */
 bool latest_acronym(amtdb_struct *amtdb);                          /* show five latest records in the database */
+int do_list_all(amtdb_struct *amtdb);                              /* output every record ordered by acronym */
 
 #endif // AMT_AMT_DB_FUNCS_H
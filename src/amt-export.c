@@ -0,0 +1,488 @@
+/**
+ * @file amt-export.c
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ * @details Program to managed SQLite database containing acronyms. This source code manages the export of every
+ * record in the database as CSV, TSV, NDJSON or SQL.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note Records are read with a single table scan and passed to the buffered writer as they are stepped to, so an
+ * unsorted export uses the same small amount of memory however large the table is. A sorted export gathers records
+ * in a memory area of a set size. Each time that fills, its records are sorted and written to a spill file as a
+ * sorted run, and the runs are then merged to produce the output. Only one record from each run needs to be held
+ * in memory during the merge.
+ */
+
+#include "amt-export.h"
+#include "amt-db-funcs.h"
+#include "amt-output.h"
+
+/* added to enable compile on macOS */
+#ifndef __clang__
+#include <malloc.h> /* free for use with malloc */
+#endif
+
+#include <stdint.h>  /* uint32_t */
+#include <stdio.h>   /* fread fwrite fdopen */
+#include <stdlib.h>  /* malloc qsort mkstemp getenv */
+#include <string.h>  /* memcmp */
+#include <unistd.h>  /* unlink close */
+
+/** @note a record as held in memory and in a spill file: this header, followed by the text of each field in turn */
+typedef struct {
+    long long id;
+    uint32_t len[AMT_OUTPUT_FIELDS];
+} rec_head;
+
+/** @note a sorted run held in a spill file, and the record from it that is next to be merged */
+typedef struct {
+    FILE *fp;
+    rec_head head;
+    unsigned char *data;
+    size_t size;
+} sort_run;
+
+/** @note records gathered in memory before they are sorted */
+typedef struct {
+    unsigned char *arena;
+    size_t arena_size;
+    size_t arena_used;
+    rec_head **recs;
+    size_t nrecs;
+    size_t size;
+    size_t budget;
+    sort_run runs[AMT_EXPORT_MAX_RUNS];
+    int nruns;
+    int spilled;
+} sort_state;
+
+/** @note where the records of a merge are sent: the output, or another spill file */
+typedef bool (*emit_fn)(const rec_head *head, const unsigned char *data, void *ctx);
+
+
+/** @note the text of a record held in memory follows its header */
+static inline const unsigned char *rec_data(const rec_head *head)
+{
+    return (const unsigned char *)(head + 1);
+}
+
+
+/** @note total length of the text of every field in a record */
+static inline size_t rec_text_len(const rec_head *head)
+{
+    size_t total = 0;
+    for (int f = 0; f < AMT_OUTPUT_FIELDS; f++) {
+        total += head->len[f];
+    }
+    return total;
+}
+
+
+/**
+ * @brief Compare two records by acronym ignoring case, as the SQLite 'NOCASE' collation does, then by source, then
+ * by record ID. This is the same order as 'amt --list' uses.
+ */
+static int compare_records(const rec_head *ha, const unsigned char *pa, const rec_head *hb, const unsigned char *pb)
+{
+    /* acronym is field 0 */
+    size_t la = ha->len[0];
+    size_t lb = hb->len[0];
+    size_t n = (la < lb) ? la : lb;
+    for (size_t i = 0; i < n; i++) {
+        int ca = (pa[i] >= 'A' && pa[i] <= 'Z') ? pa[i] + ('a' - 'A') : pa[i];
+        int cb = (pb[i] >= 'A' && pb[i] <= 'Z') ? pb[i] + ('a' - 'A') : pb[i];
+        if (ca != cb) {
+            return ca - cb;
+        }
+    }
+    if (la != lb) {
+        return (la < lb) ? -1 : 1;
+    }
+
+    /* source is field 2, after the acronym and the definition */
+    const unsigned char *sa = pa + ha->len[0] + ha->len[1];
+    const unsigned char *sb = pb + hb->len[0] + hb->len[1];
+    la = ha->len[2];
+    lb = hb->len[2];
+    int rc = memcmp(sa, sb, (la < lb) ? la : lb);
+    if (rc != 0) {
+        return rc;
+    }
+    if (la != lb) {
+        return (la < lb) ? -1 : 1;
+    }
+
+    return (ha->id < hb->id) ? -1 : (ha->id > hb->id);
+}
+
+
+/** @note qsort comparison for records held in memory */
+static int compare_in_memory(const void *a, const void *b)
+{
+    const rec_head *ha = *(rec_head *const *)a;
+    const rec_head *hb = *(rec_head *const *)b;
+    return compare_records(ha, rec_data(ha), hb, rec_data(hb));
+}
+
+
+/**
+ * @brief Emit callback: add a record to the output buffer, in the format chosen with '--format'.
+ */
+static bool emit_output(const rec_head *head, const unsigned char *data, void *ctx)
+{
+    const unsigned char *text[AMT_OUTPUT_FIELDS];
+    size_t len[AMT_OUTPUT_FIELDS];
+
+    (void)ctx;
+    for (int f = 0; f < AMT_OUTPUT_FIELDS; f++) {
+        text[f] = data;
+        len[f] = head->len[f];
+        data += head->len[f];
+    }
+    outbuf_record_values(head->id, text, len);
+    return true;
+}
+
+
+/**
+ * @brief Emit callback: write a record to the spill file 'ctx'.
+ */
+static bool emit_spill(const rec_head *head, const unsigned char *data, void *ctx)
+{
+    FILE *fp = ctx;
+    size_t len = rec_text_len(head);
+    return fwrite(head, sizeof(rec_head), 1, fp) == 1 && fwrite(data, 1, len, fp) == len;
+}
+
+
+/**
+ * @brief Create a spill file in '$TMPDIR', or '/tmp'. It is removed from the directory straight away, so it is
+ * deleted when closed however the program ends.
+ * @return FILE* : the open spill file, or NULL on failure.
+ */
+static FILE *open_spill(void)
+{
+    const char *dir = getenv("TMPDIR");
+    char path[4096];
+
+    snprintf(path, sizeof(path), "%s/amt-export-XXXXXX", (dir != NULL && dir[0] != '\0') ? dir : "/tmp");
+    int fd = mkstemp(path);
+    if (fd == -1) {
+        perror("\nERROR: unable to create a spill file to sort the export");
+        return NULL;
+    }
+    unlink(path);
+
+    FILE *fp = fdopen(fd, "w+b");
+    if (fp == NULL) {
+        perror("\nERROR: unable to open a spill file to sort the export");
+        close(fd);
+    }
+    return fp;
+}
+
+
+/**
+ * @brief Read the next record of a run into its buffer.
+ * @return int : '1' if a record was read, '0' at the end of the run, or '-1' on failure.
+ */
+static int run_next(sort_run *run)
+{
+    if (fread(&run->head, sizeof(rec_head), 1, run->fp) != 1) {
+        return ferror(run->fp) ? -1 : 0;
+    }
+
+    size_t len = rec_text_len(&run->head);
+    if (len > run->size) {
+        unsigned char *grown = realloc(run->data, len);
+        if (grown == NULL) {
+            return -1;
+        }
+        run->data = grown;
+        run->size = len;
+    }
+    return (fread(run->data, 1, len, run->fp) == len) ? 1 : -1;
+}
+
+
+/** @note is the current record of run 'a' ahead of that of run 'b' */
+static inline bool run_before(const sort_run *runs, int a, int b)
+{
+    return compare_records(&runs[a].head, runs[a].data, &runs[b].head, runs[b].data) < 0;
+}
+
+
+/** @note move the heap entry at 'i' down until neither of its children is ahead of it */
+static void heap_down(const sort_run *runs, int *heap, int nheap, int i)
+{
+    while (1) {
+        int least = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < nheap && run_before(runs, heap[left], heap[least])) {
+            least = left;
+        }
+        if (right < nheap && run_before(runs, heap[right], heap[least])) {
+            least = right;
+        }
+        if (least == i) {
+            return;
+        }
+        int tmp = heap[i];
+        heap[i] = heap[least];
+        heap[least] = tmp;
+        i = least;
+    }
+}
+
+
+/**
+ * @brief Merge the sorted runs in 'runs', passing each record to 'emit' in order, then close the runs.
+ * @return bool : success status for functions execution.
+ * @note A binary heap of the runs, ordered by their current record, gives the next record in 'log(nruns)' steps.
+ */
+static bool merge_runs(sort_run *runs, int nruns, emit_fn emit, void *ctx)
+{
+    int heap[AMT_EXPORT_MAX_RUNS];
+    int nheap = 0;
+    bool result = true;
+
+    for (int r = 0; r < nruns && result; r++) {
+        result = (fflush(runs[r].fp) == 0 && fseek(runs[r].fp, 0, SEEK_SET) == 0);
+        int got = result ? run_next(&runs[r]) : -1;
+        if (got < 0) {
+            result = false;
+        } else if (got > 0) {
+            heap[nheap++] = r;
+        }
+    }
+    for (int i = nheap / 2 - 1; i >= 0; i--) {
+        heap_down(runs, heap, nheap, i);
+    }
+
+    while (result && nheap > 0) {
+        sort_run *run = &runs[heap[0]];
+        result = emit(&run->head, run->data, ctx);
+
+        int got = result ? run_next(run) : 0;
+        if (got < 0) {
+            result = false;
+        } else if (got == 0) {
+            heap[0] = heap[--nheap];
+        }
+        heap_down(runs, heap, nheap, 0);
+    }
+
+    for (int r = 0; r < nruns; r++) {
+        fclose(runs[r].fp);
+        free(runs[r].data);
+        runs[r] = (sort_run){NULL, {0, {0}}, NULL, 0};
+    }
+
+    if (!result) {
+        fprintf(stderr, "ERROR: unable to merge the spill files of the sorted export.\n");
+    }
+    return result;
+}
+
+
+/**
+ * @brief Sort the records gathered in memory, and write them to a new spill file as a sorted run.
+ * @return bool : success status for functions execution.
+ * @note When 'AMT_EXPORT_MAX_RUNS' runs exist they are first merged into one, so the number of open spill files
+ * stays bounded for an export of any size.
+ */
+static bool spill_run(sort_state *st)
+{
+    if (st->nruns == AMT_EXPORT_MAX_RUNS) {
+        FILE *fp = open_spill();
+        if (fp == NULL || !merge_runs(st->runs, st->nruns, emit_spill, fp)) {
+            if (fp != NULL) {
+                fclose(fp);
+            }
+            return false;
+        }
+        st->runs[0].fp = fp;
+        st->nruns = 1;
+    }
+
+    FILE *fp = open_spill();
+    if (fp == NULL) {
+        return false;
+    }
+
+    qsort(st->recs, st->nrecs, sizeof(rec_head *), compare_in_memory);
+    for (size_t i = 0; i < st->nrecs; i++) {
+        if (!emit_spill(st->recs[i], rec_data(st->recs[i]), fp)) {
+            perror("\nERROR: unable to write to a spill file to sort the export");
+            fclose(fp);
+            return false;
+        }
+    }
+
+    st->runs[st->nruns++].fp = fp;
+    st->spilled++;
+    st->arena_used = 0;
+    st->nrecs = 0;
+    return true;
+}
+
+
+/**
+ * @brief Copy the current row of the export statement into memory, spilling a sorted run first if it does not fit.
+ * @return bool : success status for functions execution.
+ */
+static bool gather_record(sort_state *st, sqlite3_stmt *stmt)
+{
+    rec_head head;
+    const unsigned char *text[AMT_OUTPUT_FIELDS];
+
+    head.id = sqlite3_column_int64(stmt, 0);
+    for (int f = 0; f < AMT_OUTPUT_FIELDS; f++) {
+        text[f] = sqlite3_column_text(stmt, f + 1);
+        head.len[f] = (text[f] != NULL) ? (uint32_t)sqlite3_column_bytes(stmt, f + 1) : 0;
+    }
+
+    /** @note records are kept 8 byte aligned, so each header can be read in place */
+    size_t need = (sizeof(rec_head) + rec_text_len(&head) + 7) & ~(size_t)7;
+
+    if (st->nrecs > 0 && st->arena_used + need + (st->nrecs + 1) * sizeof(rec_head *) > st->budget) {
+        if (!spill_run(st)) {
+            return false;
+        }
+    }
+
+    /* a single record larger than the whole memory area is given room of its own */
+    if (need > st->arena_size) {
+        unsigned char *grown = realloc(st->arena, need);
+        if (grown == NULL) {
+            perror("\nERROR: unable to allocate memory to sort the export");
+            return false;
+        }
+        st->arena = grown;
+        st->arena_size = need;
+    }
+
+    if (st->nrecs == st->size) {
+        size_t newsize = st->size ? st->size * 2 : 1024;
+        rec_head **grown = realloc(st->recs, newsize * sizeof(rec_head *));
+        if (grown == NULL) {
+            perror("\nERROR: unable to allocate memory to sort the export");
+            return false;
+        }
+        st->recs = grown;
+        st->size = newsize;
+    }
+
+    rec_head *dest = (rec_head *)(st->arena + st->arena_used);
+    *dest = head;
+    unsigned char *data = (unsigned char *)(dest + 1);
+    for (int f = 0; f < AMT_OUTPUT_FIELDS; f++) {
+        memcpy(data, text[f], head.len[f]);
+        data += head.len[f];
+    }
+    st->recs[st->nrecs++] = dest;
+    st->arena_used += need;
+    return true;
+}
+
+
+/**
+ * @brief Output every record in the database, in the format chosen with '--format', optionally sorted by acronym.
+ * @param export_sort sort : the order to output the records in.
+ * @param size_t sort_mb : megabytes of memory to use to sort the records before spilling them to a file.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return int : the number of records output, or '-1' on failure.
+ * @note The records are read in one table scan, which needs no index and no SQLite sort. Uses the following SQL:
+ * @code select rowid,ifnull(Acronym,''), ifnull(Definition,''), ifnull(Source,''), ifnull(Description,''),
+ * ifnull(Changed,'') from ACRONYMS;
+ */
+int do_export(export_sort sort, size_t sort_mb, amtdb_struct *amtdb)
+{
+    sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_EXPORT);
+    if (stmt == NULL) {
+        return -1;
+    }
+
+    int count = 0;
+    int rc = SQLITE_DONE;
+
+    if (sort == EXPORT_SORT_NONE) {
+        while ((rc = step_stmt(amtdb, AMT_STMT_EXPORT)) == SQLITE_ROW) {
+            outbuf_record(stmt);
+            count++;
+        }
+        outbuf_flush();
+        release_stmt(amtdb, AMT_STMT_EXPORT);
+
+        if (rc != SQLITE_DONE) {
+            fprintf(stderr, "SQL step error: %s\n", sqlite3_errmsg(amtdb->db));
+            return -1;
+        }
+        return count;
+    }
+
+    sort_state *st = calloc(1, sizeof(sort_state));
+    if (st == NULL) {
+        perror("\nERROR: unable to allocate memory to sort the export");
+        release_stmt(amtdb, AMT_STMT_EXPORT);
+        return -1;
+    }
+    st->budget = ((sort_mb > 0) ? sort_mb : AMT_EXPORT_SORT_MB) << 20;
+    st->arena_size = st->budget;
+    st->arena = malloc(st->arena_size);
+
+    bool result = (st->arena != NULL);
+    if (!result) {
+        perror("\nERROR: unable to allocate memory to sort the export");
+    }
+
+    while (result && (rc = step_stmt(amtdb, AMT_STMT_EXPORT)) == SQLITE_ROW) {
+        result = gather_record(st, stmt);
+        count++;
+    }
+    if (result && rc != SQLITE_DONE) {
+        fprintf(stderr, "SQL step error: %s\n", sqlite3_errmsg(amtdb->db));
+        result = false;
+    }
+    release_stmt(amtdb, AMT_STMT_EXPORT);
+
+    if (result && st->nruns == 0) {
+        /** @note everything fitted in memory: no spill files are needed */
+        qsort(st->recs, st->nrecs, sizeof(rec_head *), compare_in_memory);
+        for (size_t i = 0; i < st->nrecs; i++) {
+            emit_output(st->recs[i], rec_data(st->recs[i]), NULL);
+        }
+    } else if (result) {
+        if (st->nrecs > 0) {
+            result = spill_run(st);
+        }
+        /* the memory area is not needed for the merge */
+        free(st->arena);
+        free(st->recs);
+        st->arena = NULL;
+        st->recs = NULL;
+        if (result) {
+            result = merge_runs(st->runs, st->nruns, emit_output, NULL);
+        }
+    }
+    outbuf_flush();
+
+    for (int r = 0; r < st->nruns; r++) {
+        if (st->runs[r].fp != NULL) {
+            fclose(st->runs[r].fp);
+        }
+        free(st->runs[r].data);
+    }
+
+#if DEBUG
+    fprintf(stderr, "DEBUG: sorted export of '%d' records used '%d' spill files\n", count, st->spilled);
+#endif
+
+    free(st->arena);
+    free(st->recs);
+    free(st);
+
+    return result ? count : -1;
+}
@@ -0,0 +1,30 @@
+/**
+ * @file amt-export.h
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ *
+ * @author     simon rowe <simon@wiremoons.com>
+ * @license    open-source released under "MIT License"
+ * @source     https://github.com/wiremoons/acroman
+ *
+ */
+
+#ifndef AMT_AMT_EXPORT_H /* Include guard */
+#define AMT_AMT_EXPORT_H
+
+#include "types.h"      /** @note Programs own structure to manage SQLite database information */
+#include "sqlite3.h"    /** @note SQLite database C amalgamation header */
+#include <stdbool.h>    /** @note use of true / false booleans for declarations below*/
+#include <stddef.h>     /** @note size_t */
+
+#define AMT_EXPORT_SORT_MB 64        /** @note default memory used to sort records before spilling to a file */
+#define AMT_EXPORT_MAX_RUNS 256      /** @note most spill files merged at once */
+
+/** @note the order records are exported in */
+typedef enum AmtExport_Sort {
+    EXPORT_SORT_NONE,    /* as stored, which is record ID order */
+    EXPORT_SORT_ACRONYM  /* by acronym ignoring case, then source, then record ID */
+} export_sort;
+
+int do_export(export_sort sort, size_t sort_mb, amtdb_struct *amtdb); /* output every record in the database */
+
+#endif // AMT_AMT_EXPORT_H
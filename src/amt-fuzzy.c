@@ -0,0 +1,423 @@
+/**
+ * @file amt-fuzzy.c
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ * @details Program to managed SQLite database containing acronyms. This source code manages the 'did you mean'
+ * fuzzy acronym suggestions offered when a search finds no matches.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note The suggestions use a symmetric delete index (as used by SymSpell) held in the 'ACRONYMS_FUZZY' table of
+ * the same database. Every acronym is stored against each string made by deleting up to 'AMT_FUZZY_MAX_DIST'
+ * characters from its lower case form. Any two strings within that edit distance share at least one such deletion,
+ * so a lookup only needs to generate the deletions of the search term and read them from the table's primary key.
+ * The candidates found are then checked with a real edit distance calculation.
+ */
+
+#include "amt-fuzzy.h"
+#include "amt-db-funcs.h"
+
+/* added to enable compile on macOS */
+#ifndef __clang__
+#include <malloc.h> /* free for use with strdup and malloc */
+#endif
+
+#include <ctype.h>  /* tolower */
+#include <stdio.h>  /* printf */
+#include <stdlib.h> /* qsort */
+#include <string.h> /* strlen strdup */
+
+/** @note callback run for each deletion variant of a word. Return false to stop generating further variants */
+typedef bool (*variant_fn)(const char *variant, void *ctx);
+
+/** @note context used when adding or removing an acronym's variants from the index */
+typedef struct {
+    amtdb_struct *amtdb;
+    amt_stmt_id id;
+    const char *acronym;
+} fuzzy_update_ctx;
+
+/** @note a possible suggestion and its edit distance from the search term */
+typedef struct {
+    char *acronym;
+    int distance;
+} fuzzy_candidate;
+
+/** @note context used to collect candidates during a lookup */
+typedef struct {
+    amtdb_struct *amtdb;
+    fuzzy_candidate *cands;
+    size_t count;
+    size_t size;
+    bool ok;
+} fuzzy_lookup_ctx;
+
+
+/**
+ * @brief Copy a word into 'buf' folded to lower case, as the index is case insensitive.
+ * @return size_t : the length of the word, or 0 if it is empty or too long to be indexed.
+ */
+static size_t fold_word(const char *word, char *buf)
+{
+    size_t len = strlen(word);
+    if (len == 0 || len > AMT_FUZZY_MAX_LEN) {
+        return 0;
+    }
+    for (size_t i = 0; i <= len; i++) {
+        buf[i] = (char)tolower((unsigned char)word[i]);
+    }
+    return len;
+}
+
+
+/**
+ * @brief Run 'fn' for the word and every string made by deleting up to 'depth' characters from it.
+ * @note Deletions are only made at or after 'start', so each set of deleted positions is generated once. The
+ * empty string is skipped, as it would match every short acronym.
+ */
+static bool for_each_variant(const char *word, size_t len, size_t start, int depth, variant_fn fn, void *ctx)
+{
+    if (len > 0 && !fn(word, ctx)) {
+        return false;
+    }
+    if (depth == 0) {
+        return true;
+    }
+
+    char buf[AMT_FUZZY_MAX_LEN + 1];
+    for (size_t i = start; i < len; i++) {
+        memcpy(buf, word, i);
+        memcpy(buf + i, word + i + 1, len - i); /* includes the terminating '\0' */
+        if (!for_each_variant(buf, len - 1, i, depth - 1, fn, ctx)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief Calculate the edit distance between two words, counting a swap of adjacent characters as one edit.
+ * @note Words are limited to 'AMT_FUZZY_MAX_LEN' plus 'AMT_FUZZY_MAX_DIST' characters by the callers.
+ */
+static int edit_distance(const char *a, const char *b)
+{
+    enum { DIM = AMT_FUZZY_MAX_LEN + AMT_FUZZY_MAX_DIST + 1 };
+    int d[DIM][DIM];
+    size_t la = strlen(a);
+    size_t lb = strlen(b);
+
+    if (la >= DIM || lb >= DIM) {
+        return AMT_FUZZY_MAX_DIST + 1;
+    }
+
+    for (size_t i = 0; i <= la; i++) {
+        d[i][0] = (int)i;
+    }
+    for (size_t j = 0; j <= lb; j++) {
+        d[0][j] = (int)j;
+    }
+
+    for (size_t i = 1; i <= la; i++) {
+        for (size_t j = 1; j <= lb; j++) {
+            int cost = (a[i - 1] == b[j - 1]) ? 0 : 1;
+            int best = d[i - 1][j] + 1;
+            if (d[i][j - 1] + 1 < best) {
+                best = d[i][j - 1] + 1;
+            }
+            if (d[i - 1][j - 1] + cost < best) {
+                best = d[i - 1][j - 1] + cost;
+            }
+            if (i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1] && d[i - 2][j - 2] + 1 < best) {
+                best = d[i - 2][j - 2] + 1;
+            }
+            d[i][j] = best;
+        }
+    }
+
+    return d[la][lb];
+}
+
+
+/**
+ * @brief Variant callback: bind the variant and acronym to the insert or delete statement and run it.
+ */
+static bool update_variant(const char *variant, void *ctx)
+{
+    fuzzy_update_ctx *upd = ctx;
+    sqlite3_stmt *stmt = get_stmt(upd->amtdb, upd->id);
+    if (stmt == NULL) {
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, variant, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, upd->acronym, -1, SQLITE_STATIC);
+
+    int rc = step_stmt(upd->amtdb, upd->id);
+    release_stmt(upd->amtdb, upd->id);
+
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "SQL step error: %s\n", sqlite3_errmsg(upd->amtdb->db));
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Add or remove all the deletion variants for one acronym using the given registry statement.
+ */
+static bool update_acronym_variants(amtdb_struct *amtdb, amt_stmt_id id, const char *acronym)
+{
+    char folded[AMT_FUZZY_MAX_LEN + 1];
+    size_t len = fold_word(acronym, folded);
+    if (len == 0) {
+        return true;
+    }
+
+    fuzzy_update_ctx upd = {amtdb, id, acronym};
+    return for_each_variant(folded, len, 0, AMT_FUZZY_MAX_DIST, update_variant, &upd);
+}
+
+
+/**
+ * @brief Ensure the 'ACRONYMS_FUZZY' deletion index exists, building it from every acronym if it is missing.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : true if the index is available for use.
+ * @note Uses the following SQL to create the index table:
+ * @code CREATE TABLE ACRONYMS_FUZZY (variant TEXT NOT NULL, acronym TEXT NOT NULL,
+ * PRIMARY KEY (variant, acronym)) WITHOUT ROWID;
+ */
+bool ensure_fuzzy_index(amtdb_struct *amtdb)
+{
+    if (db_object_exists(amtdb, "table", "ACRONYMS_FUZZY")) {
+        return true;
+    }
+    /** @note a search opens the database read only, so it is reopened read write only now it has to be written */
+    if (amtdb->read_only && !reopen_read_write(amtdb)) {
+        return false;
+    }
+
+#if DEBUG
+    fprintf(stderr, "DEBUG: creating the fuzzy search index 'ACRONYMS_FUZZY'\n");
+#endif
+
+    printf("\nBuilding the fuzzy search index (one off task)...\n");
+
+    int rc = sqlite3_exec(amtdb->db,
+                          "BEGIN IMMEDIATE;"
+                          "CREATE TABLE IF NOT EXISTS ACRONYMS_FUZZY ("
+                          "variant TEXT NOT NULL, acronym TEXT NOT NULL, "
+                          "PRIMARY KEY (variant, acronym)) WITHOUT ROWID;",
+                          NULL, NULL, NULL);
+    if (rc != SQLITE_OK) {
+#if DEBUG
+        fprintf(stderr, "DEBUG: unable to create the fuzzy search index: %s\n", sqlite3_errmsg(amtdb->db));
+#endif
+        sqlite3_exec(amtdb->db, "ROLLBACK;", NULL, NULL, NULL);
+        return false;
+    }
+
+    sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_DISTINCT_ACRONYMS);
+    bool result = (stmt != NULL);
+
+    while (result && step_stmt(amtdb, AMT_STMT_DISTINCT_ACRONYMS) == SQLITE_ROW) {
+        result = update_acronym_variants(amtdb, AMT_STMT_FUZZY_INSERT, (const char *)sqlite3_column_text(stmt, 0));
+    }
+    release_stmt(amtdb, AMT_STMT_DISTINCT_ACRONYMS);
+
+    if (!result || sqlite3_exec(amtdb->db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+        fprintf(stderr, "ERROR: unable to build the fuzzy search index: %s\n", sqlite3_errmsg(amtdb->db));
+        sqlite3_exec(amtdb->db, "ROLLBACK;", NULL, NULL, NULL);
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Add a new or changed acronym to the fuzzy index. Does nothing if the index has not been built yet.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @param const char *acronym : the acronym as stored in the database.
+ * @return bool : success status for functions execution.
+ */
+bool fuzzy_index_add(amtdb_struct *amtdb, const char *acronym)
+{
+    if (acronym == NULL || !db_object_exists(amtdb, "table", "ACRONYMS_FUZZY")) {
+        return true;
+    }
+
+    sqlite3_exec(amtdb->db, "SAVEPOINT fuzzy_add;", NULL, NULL, NULL);
+    bool result = update_acronym_variants(amtdb, AMT_STMT_FUZZY_INSERT, acronym);
+    if (!result) {
+        sqlite3_exec(amtdb->db, "ROLLBACK TO fuzzy_add;", NULL, NULL, NULL);
+    }
+    sqlite3_exec(amtdb->db, "RELEASE fuzzy_add;", NULL, NULL, NULL);
+
+    return result;
+}
+
+
+/**
+ * @brief Remove a deleted or changed acronym from the fuzzy index, unless another record still uses it.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @param const char *acronym : the acronym as it was stored in the database.
+ * @return bool : success status for functions execution.
+ * @note Uses the following SQL to check if the acronym is still in use:
+ * @code select 1 from ACRONYMS where Acronym = ?1 COLLATE NOCASE and Acronym = ?1 limit 1;
+ */
+bool fuzzy_index_remove(amtdb_struct *amtdb, const char *acronym)
+{
+    if (acronym == NULL || !db_object_exists(amtdb, "table", "ACRONYMS_FUZZY")) {
+        return true;
+    }
+
+    /** @note the index holds each spelling of an acronym, so only an exact match keeps its entries */
+    sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_ACRONYM_EXISTS);
+    if (stmt == NULL) {
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, acronym, -1, SQLITE_STATIC);
+    bool in_use = (step_stmt(amtdb, AMT_STMT_ACRONYM_EXISTS) == SQLITE_ROW);
+    release_stmt(amtdb, AMT_STMT_ACRONYM_EXISTS);
+
+    if (in_use) {
+        return true;
+    }
+
+    sqlite3_exec(amtdb->db, "SAVEPOINT fuzzy_remove;", NULL, NULL, NULL);
+    bool result = update_acronym_variants(amtdb, AMT_STMT_FUZZY_DELETE, acronym);
+    if (!result) {
+        sqlite3_exec(amtdb->db, "ROLLBACK TO fuzzy_remove;", NULL, NULL, NULL);
+    }
+    sqlite3_exec(amtdb->db, "RELEASE fuzzy_remove;", NULL, NULL, NULL);
+
+    return result;
+}
+
+
+/**
+ * @brief Variant callback: read the acronyms stored against the variant, and collect any not already found.
+ */
+static bool lookup_variant(const char *variant, void *ctx)
+{
+    fuzzy_lookup_ctx *look = ctx;
+    sqlite3_stmt *stmt = get_stmt(look->amtdb, AMT_STMT_FUZZY_LOOKUP);
+    if (stmt == NULL) {
+        look->ok = false;
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, variant, -1, SQLITE_STATIC);
+
+    while (step_stmt(look->amtdb, AMT_STMT_FUZZY_LOOKUP) == SQLITE_ROW) {
+        const char *acronym = (const char *)sqlite3_column_text(stmt, 0);
+
+        bool seen = false;
+        for (size_t i = 0; i < look->count && !seen; i++) {
+            seen = (strcmp(look->cands[i].acronym, acronym) == 0);
+        }
+        if (seen) {
+            continue;
+        }
+
+        if (look->count == look->size) {
+            size_t newsize = look->size ? look->size * 2 : 16;
+            fuzzy_candidate *grown = realloc(look->cands, newsize * sizeof(fuzzy_candidate));
+            if (grown == NULL) {
+                perror("\nERROR: unable to allocate memory for fuzzy search candidates\n");
+                look->ok = false;
+                break;
+            }
+            look->cands = grown;
+            look->size = newsize;
+        }
+        look->cands[look->count].acronym = strdup(acronym);
+        look->cands[look->count].distance = 0;
+        look->count++;
+    }
+
+    release_stmt(look->amtdb, AMT_STMT_FUZZY_LOOKUP);
+    return look->ok;
+}
+
+
+/**
+ * @brief qsort comparison: closest suggestions first, then in alphabetical order.
+ */
+static int compare_candidates(const void *a, const void *b)
+{
+    const fuzzy_candidate *ca = a;
+    const fuzzy_candidate *cb = b;
+    if (ca->distance != cb->distance) {
+        return ca->distance - cb->distance;
+    }
+    return strcmp(ca->acronym, cb->acronym);
+}
+
+
+/**
+ * @brief Display the acronyms within a small edit distance of a search term that found no matches.
+ * @param const char *findme : Pointer to a string containing the acronym that was searched for.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return int : the number of suggestions displayed, or '-1' on failure.
+ * @note If the fuzzy search index is missing and can not be built, such as when the database is read only, a note
+ * saying no suggestions can be offered is displayed instead. Search terms containing wildcards are not checked. Terms of three characters or less only offer
+ * suggestions one edit away, as nearly every short acronym is within two edits of them.
+ */
+int do_fuzzy_suggest(const char *findme, amtdb_struct *amtdb)
+{
+    if (strpbrk(findme, "%_") != NULL) {
+        return 0;
+    }
+
+    char folded[AMT_FUZZY_MAX_LEN + 1];
+    size_t len = fold_word(findme, folded);
+    if (len == 0) {
+        return 0;
+    }
+
+    if (!ensure_fuzzy_index(amtdb)) {
+        printf("\nNo suggestions can be offered: the fuzzy search index %s.\n",
+               amtdb->read_only ? "is not built and the database is read only" : "could not be built");
+        return -1;
+    }
+
+    const int max_dist = (len <= 3) ? 1 : AMT_FUZZY_MAX_DIST;
+    fuzzy_lookup_ctx look = {amtdb, NULL, 0, 0, true};
+    for_each_variant(folded, len, 0, max_dist, lookup_variant, &look);
+
+    /** @note keep only the candidates that are really within range; the rest share deletions by chance */
+    size_t keep = 0;
+    for (size_t i = 0; i < look.count; i++) {
+        char cand[AMT_FUZZY_MAX_LEN + 1];
+        fold_word(look.cands[i].acronym, cand);
+        int distance = edit_distance(folded, cand);
+        if (distance <= max_dist) {
+            look.cands[i].distance = distance;
+            look.cands[keep++] = look.cands[i];
+        } else {
+            free(look.cands[i].acronym);
+        }
+    }
+
+    qsort(look.cands, keep, sizeof(fuzzy_candidate), compare_candidates);
+
+    int shown = 0;
+    for (size_t i = 0; i < keep; i++) {
+        if (shown < AMT_FUZZY_MAX_SUGGEST) {
+            if (shown == 0) {
+                printf("\nDid you mean:\n");
+            }
+            printf("  '%s'  (%d %s)\n", look.cands[i].acronym, look.cands[i].distance,
+                   look.cands[i].distance == 1 ? "edit" : "edits");
+            shown++;
+        }
+        free(look.cands[i].acronym);
+    }
+
+    free(look.cands);
+
+    return look.ok ? shown : -1;
+}
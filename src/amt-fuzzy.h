@@ -0,0 +1,27 @@
+/**
+ * @file amt-fuzzy.h
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ *
+ * @author     simon rowe <simon@wiremoons.com>
+ * @license    open-source released under "MIT License"
+ * @source     https://github.com/wiremoons/acroman
+ *
+ */
+
+#ifndef AMT_AMT_FUZZY_H /* Include guard */
+#define AMT_AMT_FUZZY_H
+
+#include "types.h"      /** @note Programs own structure to manage SQLite database information */
+#include "sqlite3.h"    /** @note SQLite database C amalgamation header */
+#include <stdbool.h>    /** @note use of true / false booleans for declarations below*/
+
+#define AMT_FUZZY_MAX_DIST 2     /** @note largest edit distance offered as a 'did you mean' suggestion */
+#define AMT_FUZZY_MAX_LEN 32     /** @note acronyms longer than this are not held in the fuzzy index */
+#define AMT_FUZZY_MAX_SUGGEST 10 /** @note maximum number of suggestions to display */
+
+bool ensure_fuzzy_index(amtdb_struct *amtdb);                        /* build the fuzzy deletion index if missing */
+bool fuzzy_index_add(amtdb_struct *amtdb, const char *acronym);      /* add an acronym to the fuzzy index */
+bool fuzzy_index_remove(amtdb_struct *amtdb, const char *acronym);   /* remove an unused acronym from the index */
+int do_fuzzy_suggest(const char *findme, amtdb_struct *amtdb);       /* show acronyms close to 'findme' */
+
+#endif // AMT_AMT_FUZZY_H
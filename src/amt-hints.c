@@ -0,0 +1,585 @@
+/**
+ * @file amt-hints.c
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ * @details Program to managed SQLite database containing acronyms. This source code manages the hints shown after
+ * the cursor as an acronym is typed, giving the first matching acronym and its definition, and the tab completion
+ * of acronyms.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note Every acronym is read from the database once, into a prefix trie held in memory, so no query is run as each
+ * key is pressed. Each trie node holds the first acronym, ignoring case, that starts with the letters on the path to
+ * it. Finding the hint for what has been typed is one step down the trie per letter, whatever the database size.
+ * The acronyms are also kept in a sorted array for tab completion, where a binary search finds the first acronym
+ * starting with what has been typed, and those following it are the rest.
+ */
+
+#include "amt-hints.h"
+#include "amt-db-funcs.h"
+
+/* added to enable compile on macOS */
+#ifndef __clang__
+#include <malloc.h> /* free for use with realloc */
+#endif
+
+#include <stdint.h>  /* int32_t */
+#include <stdio.h>   /* snprintf */
+#include <stdlib.h>  /* realloc free */
+#include <string.h>  /* strlen strcmp memcpy memmove */
+#include <strings.h> /* strcasecmp strncasecmp */
+
+/** @note a node in the trie. Children are held as a linked list of siblings, apart from the root node's which are
+ * held in the 'root' table of 'hint_trie' for speed. */
+typedef struct {
+    int32_t child;    /* first child node, or -1 */
+    int32_t sibling;  /* next sibling node, or -1 */
+    int32_t top;      /* first acronym, ignoring case, at or below this node, or -1 */
+    int32_t out;      /* acronym ending at this node, or -1 */
+    unsigned char ch; /* byte on the edge from the parent node, folded to lower case */
+} hint_node;
+
+/** @note the trie, and each acronym and its definition held in 'text' as two nul terminated strings */
+typedef struct {
+    hint_node *nodes;
+    int32_t nnodes;
+    int32_t size;
+    int32_t root[256];
+    size_t *entries; /* offset in 'text' of each acronym */
+    int32_t nentries;
+    int32_t maxentries;
+    char *text;
+    size_t textused;
+    size_t textsize;
+    int32_t *sorted; /* each different spelling, in the order 'hint_first()' chooses, for tab completion */
+    int32_t nsorted;
+    int32_t maxsorted;
+    bool loaded;
+} hint_trie;
+
+static hint_trie trie;
+
+/** @note set when the trie could not be grown, so hints are no longer complete and are not shown */
+static bool hints_failed = false;
+
+
+/**
+ * @brief Fold an ASCII letter to lower case, as SQLite's 'NOCASE' collation does.
+ */
+static inline unsigned char hint_fold(unsigned char ch)
+{
+    return (ch >= 'A' && ch <= 'Z') ? (unsigned char)(ch + ('a' - 'A')) : ch;
+}
+
+
+static inline const char *entry_acronym(int32_t entry)
+{
+    return trie.text + trie.entries[entry];
+}
+
+
+/**
+ * @brief Choose which of two acronyms is shown as the hint: the first ignoring case, then the first by case.
+ * @return int32_t : the chosen entry. Either may be '-1' for none.
+ */
+static int32_t hint_first(int32_t a, int32_t b)
+{
+    if (a == -1 || b == -1) {
+        return (a == -1) ? b : a;
+    }
+    int cmp = strcasecmp(entry_acronym(a), entry_acronym(b));
+    if (cmp == 0) {
+        cmp = strcmp(entry_acronym(a), entry_acronym(b));
+    }
+    return (cmp <= 0) ? a : b;
+}
+
+
+/**
+ * @brief Add a new node to the trie.
+ * @return int32_t : the new node index, or -1 if memory could not be allocated.
+ */
+static int32_t hint_new_node(unsigned char ch)
+{
+    if (trie.nnodes == trie.size) {
+        int32_t newsize = trie.size ? trie.size * 2 : 4096;
+        hint_node *grown = realloc(trie.nodes, (size_t)newsize * sizeof(hint_node));
+        if (grown == NULL) {
+            return -1;
+        }
+        trie.nodes = grown;
+        trie.size = newsize;
+    }
+
+    hint_node *node = &trie.nodes[trie.nnodes];
+    node->child = -1;
+    node->sibling = -1;
+    node->top = -1;
+    node->out = -1;
+    node->ch = ch;
+    return trie.nnodes++;
+}
+
+
+/**
+ * @brief Find the child of 'node' on the edge for the folded byte 'ch', where a 'node' of -1 is the root.
+ * @return int32_t : the child node index, or -1 if there is none.
+ */
+static inline int32_t hint_child(int32_t node, unsigned char ch)
+{
+    if (node == -1) {
+        return trie.root[ch];
+    }
+    for (int32_t c = trie.nodes[node].child; c != -1; c = trie.nodes[c].sibling) {
+        if (trie.nodes[c].ch == ch) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+
+/**
+ * @brief Keep a copy of an acronym and its definition for the trie to refer to.
+ * @return int32_t : the new entry, or -1 if memory could not be allocated.
+ */
+static int32_t hint_new_entry(const char *acronym, size_t len, const char *definition)
+{
+    const size_t deflen = strlen(definition);
+
+    if (trie.textused + len + deflen + 2 > trie.textsize) {
+        size_t newsize = trie.textsize ? trie.textsize * 2 : 1 << 20;
+        while (trie.textused + len + deflen + 2 > newsize) {
+            newsize *= 2;
+        }
+        char *grown = realloc(trie.text, newsize);
+        if (grown == NULL) {
+            return -1;
+        }
+        trie.text = grown;
+        trie.textsize = newsize;
+    }
+    if (trie.nentries == trie.maxentries) {
+        int32_t newmax = trie.maxentries ? trie.maxentries * 2 : 4096;
+        size_t *grown = realloc(trie.entries, (size_t)newmax * sizeof(size_t));
+        if (grown == NULL) {
+            return -1;
+        }
+        trie.entries = grown;
+        trie.maxentries = newmax;
+    }
+
+    trie.entries[trie.nentries] = trie.textused;
+    memcpy(trie.text + trie.textused, acronym, len + 1);
+    trie.textused += len + 1;
+    memcpy(trie.text + trie.textused, definition, deflen + 1);
+    trie.textused += deflen + 1;
+    return trie.nentries++;
+}
+
+
+/**
+ * @brief Link an entry into the trie, updating the hint held by each node on its path.
+ * @param int32_t entry : the entry to link.
+ * @param bool in_order : true if every entry already linked comes before this one, as when loading.
+ * @return bool : false if memory could not be allocated.
+ * @note An acronym already held with the same spelling keeps its first definition, and the new entry is left
+ * unused.
+ */
+static bool hint_link(int32_t entry, bool in_order)
+{
+    const char *acronym = entry_acronym(entry);
+    const size_t len = strlen(acronym);
+
+    /** @note find or create the node for each letter, remembering the path to update once the entry is linked */
+    int32_t path[AMT_HINTS_MAX_LEN];
+    int32_t node = -1;
+    for (size_t i = 0; i < len; i++) {
+        const unsigned char ch = hint_fold((unsigned char)acronym[i]);
+        int32_t next = hint_child(node, ch);
+        if (next == -1) {
+            next = hint_new_node(ch);
+            if (next == -1) {
+                return false;
+            }
+            if (node == -1) {
+                trie.root[ch] = next;
+            } else {
+                trie.nodes[next].sibling = trie.nodes[node].child;
+                trie.nodes[node].child = next;
+            }
+        }
+        path[i] = next;
+        node = next;
+    }
+
+    /** @note when in order, any acronym already at a node comes first, so no acronyms need to be compared */
+    const int32_t out = trie.nodes[node].out;
+    if (out != -1 && (in_order || strcmp(entry_acronym(out), acronym) == 0)) {
+        return true;
+    }
+
+    /** @note a node's hint comes first of all those below it, so once the new entry is not first at one node it is
+     * not first at any node above either, and the walk back up the path can stop
+     */
+    trie.nodes[node].out = in_order ? entry : hint_first(out, entry);
+    for (size_t i = len; i-- > 0;) {
+        const int32_t top = trie.nodes[path[i]].top;
+        if (top != -1 && (in_order || hint_first(top, entry) != entry)) {
+            break;
+        }
+        trie.nodes[path[i]].top = entry;
+    }
+    return true;
+}
+
+
+/** @note an entry to be sorted, with the first bytes of its acronym folded to lower case and packed into 'key' so
+ * most comparisons need not read the acronyms themselves */
+typedef struct {
+    uint64_t key;
+    int32_t entry;
+} hint_sort;
+
+
+static uint64_t hint_key(const char *acronym)
+{
+    uint64_t key = 0;
+    bool ended = false;
+
+    for (size_t i = 0; i < sizeof(key); i++) {
+        ended = ended || acronym[i] == '\0';
+        key = (key << 8) | (ended ? 0 : hint_fold((unsigned char)acronym[i]));
+    }
+    return key;
+}
+
+
+/**
+ * @brief qsort comparison of two entries, in the order 'hint_first()' chooses between them. Equal spellings keep the
+ * order they were read in, so the first definition read is the one kept.
+ */
+static int compare_entries(const void *a, const void *b)
+{
+    const hint_sort *sa = a;
+    const hint_sort *sb = b;
+
+    if (sa->key != sb->key) {
+        return (sa->key < sb->key) ? -1 : 1;
+    }
+    int cmp = strcasecmp(entry_acronym(sa->entry), entry_acronym(sb->entry));
+    if (cmp == 0) {
+        cmp = strcmp(entry_acronym(sa->entry), entry_acronym(sb->entry));
+    }
+    if (cmp == 0) {
+        cmp = (sa->entry > sb->entry) - (sa->entry < sb->entry);
+    }
+    return cmp;
+}
+
+
+/**
+ * @brief Find where an acronym is, or would be, in the sorted array.
+ * @return int32_t : the index of the first acronym that does not come before 'acronym'.
+ */
+static int32_t sorted_position(const char *acronym)
+{
+    int32_t low = 0;
+    int32_t high = trie.nsorted;
+
+    while (low < high) {
+        const int32_t mid = low + (high - low) / 2;
+        int cmp = strcasecmp(entry_acronym(trie.sorted[mid]), acronym);
+        if (cmp == 0) {
+            cmp = strcmp(entry_acronym(trie.sorted[mid]), acronym);
+        }
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+
+/**
+ * @brief Add an entry to the sorted array, unless its spelling is already there.
+ * @return bool : false if memory could not be allocated.
+ */
+static bool sorted_insert(int32_t entry)
+{
+    const int32_t pos = sorted_position(entry_acronym(entry));
+    if (pos < trie.nsorted && strcmp(entry_acronym(trie.sorted[pos]), entry_acronym(entry)) == 0) {
+        return true;
+    }
+
+    if (trie.nsorted == trie.maxsorted) {
+        int32_t newmax = trie.maxsorted ? trie.maxsorted * 2 : 4096;
+        int32_t *grown = realloc(trie.sorted, (size_t)newmax * sizeof(int32_t));
+        if (grown == NULL) {
+            return false;
+        }
+        trie.sorted = grown;
+        trie.maxsorted = newmax;
+    }
+    memmove(&trie.sorted[pos + 1], &trie.sorted[pos], (size_t)(trie.nsorted - pos) * sizeof(int32_t));
+    trie.sorted[pos] = entry;
+    trie.nsorted++;
+    return true;
+}
+
+
+/**
+ * @brief Load every acronym in the database into the prefix trie, if it is not already loaded.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : success status for functions execution.
+ * @note Rows are read in the order stored, which is much quicker than reading them through the acronym index, and
+ * then sorted in memory. Linking them into the trie in order means the child node wanted at each step is nearly
+ * always the one last added, at the head of its sibling list. Uses the following SQL:
+ * @code select ifnull(Acronym,''), ifnull(Definition,'') from ACRONYMS;
+ */
+bool hints_load(amtdb_struct *amtdb)
+{
+    if (trie.loaded) {
+        return !hints_failed;
+    }
+    for (int c = 0; c < 256; c++) {
+        trie.root[c] = -1;
+    }
+
+    sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_HINTS);
+    if (stmt == NULL) {
+        return false;
+    }
+
+    bool result = true;
+    while (result && step_stmt(amtdb, AMT_STMT_HINTS) == SQLITE_ROW) {
+        const char *acronym = (const char *)sqlite3_column_text(stmt, 0);
+        const size_t len = (size_t)sqlite3_column_bytes(stmt, 0);
+        if (len > 0 && len <= AMT_HINTS_MAX_LEN) {
+            result = hint_new_entry(acronym, len, (const char *)sqlite3_column_text(stmt, 1)) != -1;
+        }
+    }
+    release_stmt(amtdb, AMT_STMT_HINTS);
+
+    hint_sort *order = result ? malloc((size_t)trie.nentries * sizeof(hint_sort) + 1) : NULL;
+    trie.sorted = result ? malloc((size_t)trie.nentries * sizeof(int32_t) + 1) : NULL;
+    trie.maxsorted = trie.nentries;
+    if (order != NULL && trie.sorted != NULL) {
+        for (int32_t i = 0; i < trie.nentries; i++) {
+            order[i].key = hint_key(entry_acronym(i));
+            order[i].entry = i;
+        }
+        qsort(order, (size_t)trie.nentries, sizeof(hint_sort), compare_entries);
+        for (int32_t i = 0; result && i < trie.nentries; i++) {
+            result = hint_link(order[i].entry, true);
+            if (i == 0 || strcmp(entry_acronym(order[i - 1].entry), entry_acronym(order[i].entry)) != 0) {
+                trie.sorted[trie.nsorted++] = order[i].entry;
+            }
+        }
+    } else {
+        result = false;
+    }
+    free(order);
+
+    if (!result) {
+        fprintf(stderr, "WARNING: unable to allocate memory for the acronym hints. Hints are off.\n");
+        hints_free();
+    }
+    trie.loaded = true;
+    hints_failed = !result;
+    return result;
+}
+
+
+/**
+ * @brief Find the hint for an acronym being typed: the rest of the first acronym starting with it, and its
+ * definition.
+ * @param const char *prefix : the text typed so far. Case is ignored.
+ * @param char *hint : set to the hint text.
+ * @param size_t size : the size of 'hint' in bytes.
+ * @return const char* : 'hint', or NULL if no acronym starts with 'prefix'.
+ */
+const char *hints_find(const char *prefix, char *hint, size_t size)
+{
+    if (!trie.loaded || hints_failed || prefix[0] == '\0') {
+        return NULL;
+    }
+
+    size_t len = 0;
+    int32_t node = -1;
+    for (; prefix[len] != '\0'; len++) {
+        if (len == AMT_HINTS_MAX_LEN) {
+            return NULL;
+        }
+        node = hint_child(node, hint_fold((unsigned char)prefix[len]));
+        if (node == -1) {
+            return NULL;
+        }
+    }
+    const int32_t top = trie.nodes[node].top;
+    if (top == -1) {
+        return NULL;
+    }
+
+    const char *acronym = entry_acronym(top);
+    const char *definition = acronym + strlen(acronym) + 1;
+    snprintf(hint, size, "%s  %s", acronym + len, definition);
+    return hint;
+}
+
+
+/**
+ * @brief linenoise hints callback for a prompt where an acronym is typed.
+ * @return char* : the hint to show after the cursor, or NULL for none. It is held in a static buffer.
+ */
+char *acronym_hint(const char *buf, int *color, int *bold)
+{
+    static char hint[AMT_HINTS_MAX_TEXT];
+
+    *color = AMT_HINTS_COLOUR;
+    *bold = 0;
+    return (char *)hints_find(buf, hint, sizeof(hint));
+}
+
+
+/**
+ * @brief Find the acronyms starting with what has been typed, for tab completion.
+ * @param const char *prefix : the text typed so far. Case is ignored.
+ * @param const char **found : set to the acronyms found, in order.
+ * @param size_t max : the most acronyms to return.
+ * @return size_t : the number of acronyms found.
+ */
+size_t hints_complete(const char *prefix, const char **found, size_t max)
+{
+    if (!trie.loaded || hints_failed || prefix[0] == '\0') {
+        return 0;
+    }
+
+    /** @note the acronyms starting with 'prefix' are together in the array, from the first not before 'prefix' */
+    const size_t len = strlen(prefix);
+    size_t count = 0;
+    for (int32_t i = sorted_position(prefix); i < trie.nsorted && count < max; i++) {
+        const char *acronym = entry_acronym(trie.sorted[i]);
+        if (strncasecmp(acronym, prefix, len) != 0) {
+            break;
+        }
+        found[count++] = acronym;
+    }
+    return count;
+}
+
+
+/**
+ * @brief linenoise completion callback for a prompt where an acronym is typed. Each press of 'tab' shows the next
+ * acronym starting with what has been typed.
+ */
+void acronym_completion(const char *buf, linenoiseCompletions *lc)
+{
+    const char *found[AMT_HINTS_MAX_COMPLETE];
+    const size_t count = hints_complete(buf, found, AMT_HINTS_MAX_COMPLETE);
+
+    for (size_t i = 0; i < count; i++) {
+        linenoiseAddCompletion(lc, found[i]);
+    }
+}
+
+
+/**
+ * @brief Add a new or changed acronym to the trie, so it is offered as a hint without reloading.
+ * @param const char *acronym : the acronym as it is stored in the database.
+ * @param const char *definition : the acronyms definition.
+ * @note Does nothing if the trie has not been loaded.
+ */
+void hints_add(const char *acronym, const char *definition)
+{
+    if (!trie.loaded || hints_failed || acronym == NULL) {
+        return;
+    }
+    const size_t len = strlen(acronym);
+    if (len == 0 || len > AMT_HINTS_MAX_LEN) {
+        return;
+    }
+    const int32_t entry = hint_new_entry(acronym, len, definition != NULL ? definition : "");
+    if (entry == -1 || !hint_link(entry, false) || !sorted_insert(entry)) {
+        fprintf(stderr, "WARNING: unable to allocate memory for the acronym hints. Hints are off.\n");
+        hints_failed = true;
+    }
+}
+
+
+/**
+ * @brief Remove a deleted or changed acronym from the trie, unless another record still uses it.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @param const char *acronym : the acronym as it was stored in the database.
+ * @note The nodes on the acronyms path are kept, and their hints worked out again from the bottom up. Uses the
+ * following SQL to check if the acronym is still in use:
+ * @code select 1 from ACRONYMS where Acronym = ?1 COLLATE NOCASE and Acronym = ?1 limit 1;
+ */
+void hints_remove(amtdb_struct *amtdb, const char *acronym)
+{
+    if (!trie.loaded || hints_failed || acronym == NULL) {
+        return;
+    }
+    const size_t len = strlen(acronym);
+    if (len == 0 || len > AMT_HINTS_MAX_LEN) {
+        return;
+    }
+
+    int32_t path[AMT_HINTS_MAX_LEN];
+    int32_t node = -1;
+    for (size_t i = 0; i < len; i++) {
+        node = hint_child(node, hint_fold((unsigned char)acronym[i]));
+        if (node == -1) {
+            return;
+        }
+        path[i] = node;
+    }
+    sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_ACRONYM_EXISTS);
+    if (stmt == NULL) {
+        return;
+    }
+    sqlite3_bind_text(stmt, 1, acronym, -1, SQLITE_STATIC);
+    const bool in_use = (step_stmt(amtdb, AMT_STMT_ACRONYM_EXISTS) == SQLITE_ROW);
+    release_stmt(amtdb, AMT_STMT_ACRONYM_EXISTS);
+    if (in_use) {
+        return;
+    }
+
+    const int32_t pos = sorted_position(acronym);
+    if (pos < trie.nsorted && strcmp(entry_acronym(trie.sorted[pos]), acronym) == 0) {
+        memmove(&trie.sorted[pos], &trie.sorted[pos + 1], (size_t)(trie.nsorted - pos - 1) * sizeof(int32_t));
+        trie.nsorted--;
+    }
+
+    /** @note another spelling of the acronym, differing in case, may be the one held at its node */
+    const int32_t out = trie.nodes[node].out;
+    if (out == -1 || strcmp(entry_acronym(out), acronym) != 0) {
+        return;
+    }
+
+    /** @note the entry's text stays in 'text' unused, which is only a few bytes for each record removed */
+    trie.nodes[node].out = -1;
+    for (size_t i = len; i-- > 0;) {
+        hint_node *n = &trie.nodes[path[i]];
+        n->top = n->out;
+        for (int32_t c = n->child; c != -1; c = trie.nodes[c].sibling) {
+            n->top = hint_first(n->top, trie.nodes[c].top);
+        }
+    }
+}
+
+
+/**
+ * @brief Release the memory held by the trie. It is loaded again by the next call to 'hints_load()'.
+ */
+void hints_free(void)
+{
+    free(trie.nodes);
+    free(trie.entries);
+    free(trie.text);
+    free(trie.sorted);
+    memset(&trie, 0, sizeof(trie));
+    hints_failed = false;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file amt-hints.h
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ *
+ * @author     simon rowe <simon@wiremoons.com>
+ * @license    open-source released under "MIT License"
+ * @source     https://github.com/wiremoons/acroman
+ *
+ */
+
+#ifndef AMT_AMT_HINTS_H /* Include guard */
+#define AMT_AMT_HINTS_H
+
+#include "types.h"      /** @note Programs own structure to manage SQLite database information */
+#include "sqlite3.h"    /** @note SQLite database C amalgamation header */
+#include <stdbool.h>    /** @note use of true / false booleans for declarations below*/
+#include <stddef.h>     /** @note size_t */
+#include "linenoise.h"  /** @note Linenoise library: readline replacement */
+
+#define AMT_HINTS_MAX_LEN 64       /** @note acronyms longer than this are not offered as hints */
+#define AMT_HINTS_MAX_TEXT 256     /** @note longest hint shown after the cursor */
+#define AMT_HINTS_COLOUR 90        /** @note ANSI colour of the hint text: bright black, so it reads as grey */
+#define AMT_HINTS_MAX_COMPLETE 100 /** @note most acronyms offered in turn by pressing 'tab' */
+
+bool hints_load(amtdb_struct *amtdb);                           /* load every acronym into the prefix trie once */
+const char *hints_find(const char *prefix, char *hint, size_t size); /* rest of the first acronym and definition */
+char *acronym_hint(const char *buf, int *color, int *bold);     /* linenoise hints callback for acronym prompts */
+size_t hints_complete(const char *prefix, const char **found, size_t max); /* acronyms starting with 'prefix' */
+void acronym_completion(const char *buf, linenoiseCompletions *lc); /* linenoise tab completion of acronyms */
+void hints_add(const char *acronym, const char *definition);    /* add a new or changed acronym to the trie */
+void hints_remove(amtdb_struct *amtdb, const char *acronym);    /* remove an acronym no longer in the database */
+void hints_free(void);                                          /* release the memory held by the trie */
+
+#endif // AMT_AMT_HINTS_H
@@ -0,0 +1,475 @@
+/**
+ * @file amt-import.c
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ * @details Program to managed SQLite database containing acronyms. This source code manages the import of acronym
+ * records from a CSV or TSV file.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note The file is read in blocks and parsed one record at a time, so memory use does not depend on its size. Each
+ * record's fields are bound to the one registry 'insert' statement, and records are committed in transactions of
+ * 'AMT_IMPORT_BATCH_ROWS', rather than SQLite committing - and syncing to disk - after every record. The files
+ * written by '--format csv' and '--format tsv' can be read back in, using the same quoting and escape rules.
+ */
+
+#include "amt-import.h"
+#include "amt-db-funcs.h"
+
+/* added to enable compile on macOS */
+#ifndef __clang__
+#include <malloc.h> /* free for use with malloc */
+#endif
+
+#include <errno.h>   /* errno */
+#include <stdio.h>   /* fopen fread printf */
+#include <stdlib.h>  /* realloc */
+#include <string.h>  /* strcmp strrchr */
+#include <strings.h> /* strcasecmp strncasecmp */
+#include <time.h>    /* clock_gettime */
+
+/** @note the 'insert' statement parameter each field is bound to. Fields such as 'id' and 'changed' are ignored */
+enum { PARAM_NONE, PARAM_ACRONYM, PARAM_DEFINITION, PARAM_DESCRIPTION, PARAM_SOURCE };
+
+/** @note header names understood, and the parameter each is bound to. As written by 'outbuf_header()' */
+static const struct {
+    const char *name;
+    int param;
+} import_fields[] = {
+    {"id", PARAM_NONE},
+    {"acronym", PARAM_ACRONYM},
+    {"definition", PARAM_DEFINITION},
+    {"source", PARAM_SOURCE},
+    {"description", PARAM_DESCRIPTION},
+    {"changed", PARAM_NONE},
+};
+#define IMPORT_FIELD_COUNT (sizeof(import_fields) / sizeof(import_fields[0]))
+
+/** @note the file being read, and the fields of the record last read from it */
+typedef struct {
+    FILE *fp;
+    output_format format;
+    char data[AMT_IMPORT_READ_SIZE];
+    size_t pos;
+    size_t len;
+    char *text;                          /* field text of the record, one field after another */
+    size_t used;
+    size_t size;
+    size_t start[AMT_IMPORT_MAX_FIELDS]; /* offset of each field in 'text' */
+    size_t flen[AMT_IMPORT_MAX_FIELDS];  /* length of each field */
+    int nfields;                         /* fields in the record, which may be more than are kept */
+    long line;                           /* line the next record starts on, counting from one */
+} import_reader;
+
+
+/**
+ * @brief Get the next byte of the file, reading another block when the last is used up.
+ * @return int : the byte, or EOF at the end of the file.
+ */
+static inline int reader_getc(import_reader *rd)
+{
+    if (rd->pos == rd->len) {
+        rd->len = fread(rd->data, 1, sizeof(rd->data), rd->fp);
+        rd->pos = 0;
+        if (rd->len == 0) {
+            return EOF;
+        }
+    }
+    return (unsigned char)rd->data[rd->pos++];
+}
+
+
+/**
+ * @brief Add a byte to the text of the current field.
+ * @return bool : false if memory could not be allocated.
+ */
+static inline bool reader_append(import_reader *rd, char c)
+{
+    if (rd->used == rd->size) {
+        size_t newsize = rd->size ? rd->size * 2 : 4096;
+        char *grown = realloc(rd->text, newsize);
+        if (grown == NULL) {
+            return false;
+        }
+        rd->text = grown;
+        rd->size = newsize;
+    }
+    rd->text[rd->used++] = c;
+    return true;
+}
+
+
+/**
+ * @brief End the current field, which began at offset 'from' of the record text.
+ */
+static inline void reader_end_field(import_reader *rd, size_t from)
+{
+    if (rd->nfields < AMT_IMPORT_MAX_FIELDS) {
+        rd->start[rd->nfields] = from;
+        rd->flen[rd->nfields] = rd->used - from;
+    }
+    rd->nfields++;
+}
+
+
+/**
+ * @brief Read one CSV field, with any RFC 4180 quoting removed, starting with the byte 'c'.
+ * @return int : the byte that ended the field: ',' '\n' or EOF. '-2' if memory could not be allocated.
+ * @note A quoted field may hold line breaks. A '\r' before the end of a line is dropped.
+ */
+static int read_csv_field(import_reader *rd, int c)
+{
+    size_t raw = rd->used; /* where text outside of any quotes starts */
+
+    if (c == '"') {
+        while ((c = reader_getc(rd)) != EOF) {
+            if (c == '"') {
+                c = reader_getc(rd);
+                if (c != '"') {
+                    break;
+                }
+            } else if (c == '\n') {
+                rd->line++;
+            }
+            if (!reader_append(rd, (char)c)) {
+                return -2;
+            }
+        }
+        raw = rd->used;
+    }
+
+    /** @note anything after a closing quote is kept as it is, as most programs do */
+    while (c != EOF && c != ',' && c != '\n') {
+        if (!reader_append(rd, (char)c)) {
+            return -2;
+        }
+        c = reader_getc(rd);
+    }
+    if (c != ',' && rd->used > raw && rd->text[rd->used - 1] == '\r') {
+        rd->used--;
+    }
+    return c;
+}
+
+
+/**
+ * @brief Read one TSV field starting with the byte 'c'. The escapes '\t', '\n', '\r' and '\\' are replaced by the
+ * bytes they stand for; a backslash before any other byte is kept.
+ * @return int : the byte that ended the field: '\t' '\n' or EOF. '-2' if memory could not be allocated.
+ */
+static int read_tsv_field(import_reader *rd, int c)
+{
+    size_t raw = rd->used;
+
+    while (c != EOF && c != '\t' && c != '\n') {
+        if (c == '\\') {
+            int next = reader_getc(rd);
+            char out = (next == 't') ? '\t' : (next == 'n') ? '\n' : (next == 'r') ? '\r' : (next == '\\') ? '\\' : 0;
+            if (out != 0) {
+                if (!reader_append(rd, out)) {
+                    return -2;
+                }
+                raw = rd->used;
+                c = reader_getc(rd);
+                continue;
+            }
+            if (!reader_append(rd, '\\')) {
+                return -2;
+            }
+            c = next;
+            continue;
+        }
+        if (!reader_append(rd, (char)c)) {
+            return -2;
+        }
+        c = reader_getc(rd);
+    }
+    if (c != '\t' && rd->used > raw && rd->text[rd->used - 1] == '\r') {
+        rd->used--;
+    }
+    return c;
+}
+
+
+/**
+ * @brief Read the next record from the file into 'rd'.
+ * @return int : '1' if a record was read, '0' at the end of the file, or '-1' if memory could not be allocated.
+ */
+static int read_record(import_reader *rd)
+{
+    const int delim = (rd->format == OUTPUT_TSV) ? '\t' : ',';
+
+    rd->used = 0;
+    rd->nfields = 0;
+
+    int c = reader_getc(rd);
+    if (c == EOF) {
+        return 0;
+    }
+
+    while (1) {
+        size_t from = rd->used;
+        c = (rd->format == OUTPUT_TSV) ? read_tsv_field(rd, c) : read_csv_field(rd, c);
+        if (c == -2) {
+            return -1;
+        }
+        reader_end_field(rd, from);
+        if (c != delim) {
+            break;
+        }
+        c = reader_getc(rd);
+    }
+
+    if (c == '\n') {
+        rd->line++;
+    }
+    return 1;
+}
+
+
+/**
+ * @brief Work out which 'insert' parameter each field is bound to, from the header line if the file has one.
+ * @return bool : true if the record read was a header line, false if it holds data.
+ * @note A header line is one where every field is a known name, such as that written by '--format csv'. Without
+ * one the fields are taken to be: acronym, definition, source, description.
+ */
+static bool map_fields(const import_reader *rd, int *params, int *nparams)
+{
+    bool header = (rd->nfields <= AMT_IMPORT_MAX_FIELDS);
+    bool has_acronym = false;
+
+    for (int f = 0; f < rd->nfields && header; f++) {
+        header = false;
+        for (size_t i = 0; i < IMPORT_FIELD_COUNT; i++) {
+            if (rd->flen[f] == strlen(import_fields[i].name) &&
+                strncasecmp(rd->text + rd->start[f], import_fields[i].name, rd->flen[f]) == 0) {
+                params[f] = import_fields[i].param;
+                has_acronym = has_acronym || (params[f] == PARAM_ACRONYM);
+                header = true;
+                break;
+            }
+        }
+    }
+
+    if (header && has_acronym) {
+        *nparams = rd->nfields;
+        return true;
+    }
+
+    params[0] = PARAM_ACRONYM;
+    params[1] = PARAM_DEFINITION;
+    params[2] = PARAM_SOURCE;
+    params[3] = PARAM_DESCRIPTION;
+    *nparams = 4;
+    return false;
+}
+
+
+/**
+ * @brief Report a record that could not be imported. Only the first 'AMT_IMPORT_MAX_REPORT' are shown.
+ */
+static void reject_record(long line, const char *reason, long *rejected)
+{
+    if (*rejected < AMT_IMPORT_MAX_REPORT) {
+        fprintf(stderr, "REJECTED:    line '%ld': %s\n", line, reason);
+    } else if (*rejected == AMT_IMPORT_MAX_REPORT) {
+        fprintf(stderr, "REJECTED:    ... further rejected records are counted but not shown.\n");
+    }
+    (*rejected)++;
+}
+
+
+static double now_secs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+
+/**
+ * @brief Bind the fields of a record to the 'insert' statement and run it.
+ * @return int : the SQLite result code from the insert.
+ */
+static int insert_record(amtdb_struct *amtdb, const import_reader *rd, const int *params)
+{
+    sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_INSERT);
+    if (stmt == NULL) {
+        return SQLITE_ERROR;
+    }
+
+    /** @note the field text stays in place until the next record is read, so it is not copied by SQLite */
+    int rc = SQLITE_OK;
+    for (int f = 0; f < rd->nfields && rc == SQLITE_OK; f++) {
+        if (params[f] != PARAM_NONE) {
+            rc = sqlite3_bind_text(stmt, params[f], rd->text + rd->start[f], (int)rd->flen[f], SQLITE_STATIC);
+        }
+    }
+    if (rc == SQLITE_OK) {
+        rc = step_stmt(amtdb, AMT_STMT_INSERT);
+    }
+    release_stmt(amtdb, AMT_STMT_INSERT);
+    return rc;
+}
+
+
+/**
+ * @brief Add the acronym records held in a CSV or TSV file to the database.
+ * @param const char *filename : the file to import, or '-' to read from stdin.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : false if the import could not be completed. Records in batches already committed are kept.
+ * @note The format is 'amtdb->format' if that is CSV or TSV, otherwise TSV for a file ending '.tsv' or '.tab' and
+ * CSV for any other. Records missing an acronym, or with the wrong number of fields, are rejected and reported; the
+ * rest of the file is still imported. Uses the following SQL for each record:
+ * @code insert into ACRONYMS(Acronym, Definition, Description, Source) values(?,?,?,?);
+ */
+bool do_import(const char *filename, amtdb_struct *amtdb)
+{
+    import_reader *rd = calloc(1, sizeof(import_reader));
+    if (rd == NULL) {
+        perror("\nERROR: unable to allocate memory to read the import file\n");
+        return false;
+    }
+
+    rd->format = amtdb->format;
+    if (rd->format != OUTPUT_CSV && rd->format != OUTPUT_TSV) {
+        const char *ext = strrchr(filename, '.');
+        rd->format = (ext != NULL && (strcasecmp(ext, ".tsv") == 0 || strcasecmp(ext, ".tab") == 0)) ? OUTPUT_TSV
+                                                                                                      : OUTPUT_CSV;
+    }
+    rd->line = 1;
+
+    rd->fp = (strcmp(filename, "-") == 0) ? stdin : fopen(filename, "rb");
+    if (rd->fp == NULL) {
+        fprintf(stderr, "ERROR: unable to open the import file '%s': %s\n", filename, strerror(errno));
+        free(rd);
+        return false;
+    }
+
+    /** @note skip any UTF-8 byte order mark, as added by some spreadsheet programs */
+    rd->len = fread(rd->data, 1, sizeof(rd->data), rd->fp);
+    if (rd->len >= 3 && memcmp(rd->data, "\xEF\xBB\xBF", 3) == 0) {
+        rd->pos = 3;
+    }
+
+    set_record_count(amtdb);
+
+    printf("\nImporting records from '%s' as %s...\n", filename, (rd->format == OUTPUT_TSV) ? "TSV" : "CSV");
+
+    const double started = now_secs();
+    long imported = 0;
+    long rejected = 0;
+    long batch = 0;
+    int params[AMT_IMPORT_MAX_FIELDS] = {PARAM_NONE};
+    int nparams = 0;
+    bool first = true;
+    bool result = true;
+
+    /** @note a larger page cache keeps more of the indexes in memory as they are added to in random order */
+    char pragma[64];
+    snprintf(pragma, sizeof(pragma), "PRAGMA cache_size = -%d;", AMT_IMPORT_CACHE_KB);
+    sqlite3_exec(amtdb->db, pragma, NULL, NULL, NULL);
+
+    if (sqlite3_exec(amtdb->db, "BEGIN IMMEDIATE;", NULL, NULL, NULL) != SQLITE_OK) {
+        fprintf(stderr, "ERROR: unable to start the import transaction: %s\n", sqlite3_errmsg(amtdb->db));
+        result = false;
+    }
+
+    /** @note the 'did you mean' index is dropped, rather than updated for every record, and is rebuilt when next
+     * needed. Done in the first batch so it can never be left out of step with records already committed.
+     */
+    if (result && db_object_exists(amtdb, "table", "ACRONYMS_FUZZY")) {
+        sqlite3_exec(amtdb->db, "DROP TABLE ACRONYMS_FUZZY;", NULL, NULL, NULL);
+    }
+
+    while (result) {
+        const long line = rd->line;
+        int got = read_record(rd);
+        if (got == 0) {
+            break;
+        }
+        if (got < 0) {
+            perror("\nERROR: unable to allocate memory for an import record\n");
+            result = false;
+            break;
+        }
+
+        if (first) {
+            first = false;
+            if (map_fields(rd, params, &nparams)) {
+                continue;
+            }
+        }
+
+        /* skip blank lines */
+        if (rd->nfields == 1 && rd->flen[0] == 0) {
+            continue;
+        }
+
+        if (rd->nfields != nparams) {
+            char reason[80];
+            snprintf(reason, sizeof(reason), "has '%d' fields but '%d' were expected", rd->nfields, nparams);
+            reject_record(line, reason, &rejected);
+            continue;
+        }
+
+        bool has_acronym = false;
+        for (int f = 0; f < rd->nfields; f++) {
+            has_acronym = has_acronym || (params[f] == PARAM_ACRONYM && rd->flen[f] > 0);
+        }
+        if (!has_acronym) {
+            reject_record(line, "no acronym is given", &rejected);
+            continue;
+        }
+
+        int rc = insert_record(amtdb, rd, params);
+        if ((rc & 0xff) == SQLITE_CONSTRAINT) {
+            reject_record(line, sqlite3_errmsg(amtdb->db), &rejected);
+            continue;
+        }
+        if (rc != SQLITE_DONE) {
+            fprintf(stderr, "SQL step error: %s\n", sqlite3_errmsg(amtdb->db));
+            result = false;
+            break;
+        }
+        imported++;
+
+        if (++batch == AMT_IMPORT_BATCH_ROWS) {
+            if (sqlite3_exec(amtdb->db, "COMMIT; BEGIN IMMEDIATE;", NULL, NULL, NULL) != SQLITE_OK) {
+                fprintf(stderr, "ERROR: unable to commit the imported records: %s\n", sqlite3_errmsg(amtdb->db));
+                result = false;
+                break;
+            }
+            batch = 0;
+        }
+    }
+
+    if (result && ferror(rd->fp)) {
+        fprintf(stderr, "ERROR: unable to read the import file '%s'\n", filename);
+        result = false;
+    }
+
+    if (result && sqlite3_exec(amtdb->db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+        fprintf(stderr, "ERROR: unable to commit the imported records: %s\n", sqlite3_errmsg(amtdb->db));
+        result = false;
+    }
+    if (!result && !sqlite3_get_autocommit(amtdb->db)) {
+        sqlite3_exec(amtdb->db, "ROLLBACK;", NULL, NULL, NULL);
+        imported -= batch;
+    }
+
+    const double secs = now_secs() - started;
+
+    if (rd->fp != stdin) {
+        fclose(rd->fp);
+    }
+    free(rd->text);
+    free(rd);
+
+    set_record_count(amtdb);
+    printf("Imported '%'ld' records in %.2f seconds ('%'.0f' records/sec). Rejected '%'ld' records.\n", imported,
+           secs, (secs > 0) ? (double)imported / secs : 0.0, rejected);
+    printf("Total database record count is now %'d (was %'d).\n", amtdb->totalrec, amtdb->prevtotalrec);
+
+    return result;
+}
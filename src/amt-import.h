@@ -0,0 +1,26 @@
+/**
+ * @file amt-import.h
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ *
+ * @author     simon rowe <simon@wiremoons.com>
+ * @license    open-source released under "MIT License"
+ * @source     https://github.com/wiremoons/acroman
+ *
+ */
+
+#ifndef AMT_AMT_IMPORT_H /* Include guard */
+#define AMT_AMT_IMPORT_H
+
+#include "types.h"      /** @note Programs own structure to manage SQLite database information */
+#include "sqlite3.h"    /** @note SQLite database C amalgamation header */
+#include <stdbool.h>    /** @note use of true / false booleans for declarations below*/
+
+#define AMT_IMPORT_BATCH_ROWS 50000      /** @note records inserted in each transaction */
+#define AMT_IMPORT_CACHE_KB (64 * 1024)  /** @note SQLite page cache size used while importing */
+#define AMT_IMPORT_READ_SIZE (64 * 1024) /** @note bytes read from the file at a time */
+#define AMT_IMPORT_MAX_FIELDS 16         /** @note most fields a record may have */
+#define AMT_IMPORT_MAX_REPORT 10         /** @note rejected records reported individually */
+
+bool do_import(const char *filename, amtdb_struct *amtdb); /* add the records from a CSV or TSV file */
+
+#endif // AMT_AMT_IMPORT_H
@@ -0,0 +1,150 @@
+/**
+ * @file amt-memstats.c
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ * @details Program to managed SQLite database containing acronyms. This source code shows the memory used by SQLite
+ * and by the program as a whole, for '--mem-stats', the shell 'memory' command and the server 'm' request.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note SQLite keeps its own counters of the memory it has allocated, so these show what the library itself holds
+ * and the most it has held at once. Its page cache and lookaside counters show whether the memory given to them is
+ * sized well: pages or allocations that did not fit fall back to the heap. The process resident set size shows the
+ * rest of the program too, including the acronyms loaded for hints and the output buffers.
+ */
+
+#include "amt-memstats.h"
+#include "amt-alloc.h"
+
+#include <stdio.h>        /* fprintf fopen sscanf */
+#include <sys/resource.h> /* getrusage */
+
+
+/**
+ * @brief Get the resident set size of the program now, and the most it has been.
+ * @param long long *rss : set to the bytes resident now, or -1 if that is not known.
+ * @param long long *peak : set to the most bytes resident at once, or -1 if that is not known.
+ * @note Linux gives both in '/proc/self/status'. Elsewhere only the peak is known, from 'getrusage()', which gives
+ * kilobytes on Linux but bytes on macOS.
+ */
+static void process_memory(long long *rss, long long *peak)
+{
+    *rss = -1;
+    *peak = -1;
+
+    FILE *status = fopen(AMT_MEMSTATS_PROC_STATUS, "r");
+    if (status != NULL) {
+        char line[256];
+        long long kb;
+        while (fgets(line, sizeof(line), status) != NULL) {
+            if (sscanf(line, "VmRSS: %lld kB", &kb) == 1) {
+                *rss = kb * 1024;
+            } else if (sscanf(line, "VmHWM: %lld kB", &kb) == 1) {
+                *peak = kb * 1024;
+            }
+        }
+        fclose(status);
+    }
+
+    struct rusage usage;
+    if (*peak < 0 && getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        *peak = (long long)usage.ru_maxrss;
+#else
+        *peak = (long long)usage.ru_maxrss * 1024;
+#endif
+    }
+}
+
+
+/**
+ * @brief Get one of the SQLite library wide memory counters.
+ * @note the current and highest values are zero if the counter is not available.
+ */
+static void library_status(int op, sqlite3_int64 *current, sqlite3_int64 *highest)
+{
+    if (sqlite3_status64(op, current, highest, 0) != SQLITE_OK) {
+        *current = 0;
+        *highest = 0;
+    }
+}
+
+
+/**
+ * @brief Get one of the SQLite database connection memory counters.
+ * @note the current and highest values are zero if the counter is not available, or no database is open.
+ */
+static void connection_status(sqlite3 *db, int op, int *current, int *highest)
+{
+    *current = 0;
+    *highest = 0;
+    if (db != NULL && sqlite3_db_status(db, op, current, highest, 0) != SQLITE_OK) {
+        *current = 0;
+        *highest = 0;
+    }
+}
+
+
+/**
+ * @brief Output the memory used by SQLite and the program, now and at most.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @param FILE *out : where to write the report. Stderr after a command, so records written to stdout for another
+ * program are not changed, or stdout in the shell and server.
+ * @note The counters are read and not reset, so the highest values are for the whole time the program has run.
+ * The database connection counters are only shown while the database is open.
+ */
+void output_mem_stats(amtdb_struct *amtdb, FILE *out)
+{
+    sqlite3_int64 heap, heap_max, mallocs, mallocs_max, largest, largest_max;
+    sqlite3_int64 pcache, pcache_max, overflow, overflow_max, pcache_size, pcache_size_max;
+    library_status(SQLITE_STATUS_MEMORY_USED, &heap, &heap_max);
+    library_status(SQLITE_STATUS_MALLOC_COUNT, &mallocs, &mallocs_max);
+    library_status(SQLITE_STATUS_MALLOC_SIZE, &largest, &largest_max);
+    library_status(SQLITE_STATUS_PAGECACHE_USED, &pcache, &pcache_max);
+    library_status(SQLITE_STATUS_PAGECACHE_OVERFLOW, &overflow, &overflow_max);
+    library_status(SQLITE_STATUS_PAGECACHE_SIZE, &pcache_size, &pcache_size_max);
+
+    long long rss, rss_max;
+    process_memory(&rss, &rss_max);
+
+    fprintf(out, "\nMemory use                now / highest\n");
+    fprintf(out, "SQLite heap:          '%'lld' / '%'lld' bytes in '%'lld' / '%'lld' allocations\n",
+            (long long)heap, (long long)heap_max, (long long)mallocs, (long long)mallocs_max);
+    fprintf(out, "Largest allocation:   '%'lld' bytes\n", (long long)largest_max);
+    if (alloc_heap_bytes() > 0) {
+        fprintf(out, "SQLite arena:         '%'zu' bytes, '%.1f%%' used at most\n", alloc_heap_bytes(),
+                100.0 * (double)heap_max / (double)alloc_heap_bytes());
+    }
+    fprintf(out, "Page cache buffer:    '%'lld' / '%'lld' pages of up to '%'lld' bytes\n", (long long)pcache,
+            (long long)pcache_max, (long long)pcache_size_max);
+    fprintf(out, "Pages outside buffer: '%'lld' / '%'lld' bytes\n", (long long)overflow, (long long)overflow_max);
+
+    sqlite3 *db = amtdb->db_OK ? amtdb->db : NULL;
+    if (db != NULL) {
+        int cur, max, hits, misses, unused;
+        connection_status(db, SQLITE_DBSTATUS_CACHE_USED, &cur, &unused);
+        connection_status(db, SQLITE_DBSTATUS_CACHE_HIT, &hits, &unused);
+        connection_status(db, SQLITE_DBSTATUS_CACHE_MISS, &misses, &unused);
+        fprintf(out, "Connection cache:     '%'d' bytes, '%'d' page hits, '%'d' page misses\n", cur, hits, misses);
+
+        /** @note the lookaside hit and miss counts are only given as the highest value */
+        int miss_size, miss_full;
+        connection_status(db, SQLITE_DBSTATUS_LOOKASIDE_USED, &cur, &max);
+        connection_status(db, SQLITE_DBSTATUS_LOOKASIDE_HIT, &unused, &hits);
+        connection_status(db, SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE, &unused, &miss_size);
+        connection_status(db, SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL, &unused, &miss_full);
+        fprintf(out, "Lookaside:            '%'d' / '%'d' slots, '%'d' hits, '%'d' too large, '%'d' when full\n",
+                cur, max, hits, miss_size, miss_full);
+
+        connection_status(db, SQLITE_DBSTATUS_SCHEMA_USED, &cur, &unused);
+        fprintf(out, "Schema:               '%'d' bytes\n", cur);
+        connection_status(db, SQLITE_DBSTATUS_STMT_USED, &cur, &unused);
+        fprintf(out, "Prepared statements:  '%'d' bytes\n", cur);
+    }
+
+    if (rss >= 0) {
+        fprintf(out, "Process resident:     '%'lld' / '%'lld' bytes\n\n", rss, rss_max);
+    } else if (rss_max >= 0) {
+        fprintf(out, "Process resident:     '%'lld' bytes at most\n\n", rss_max);
+    }
+}
@@ -0,0 +1,22 @@
+/**
+ * @file amt-memstats.h
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ *
+ * @author     simon rowe <simon@wiremoons.com>
+ * @license    open-source released under "MIT License"
+ * @source     https://github.com/wiremoons/acroman
+ *
+ */
+
+#ifndef AMT_AMT_MEMSTATS_H /* Include guard */
+#define AMT_AMT_MEMSTATS_H
+
+#include "types.h"      /** @note Programs own structure to manage SQLite database information */
+#include "sqlite3.h"    /** @note SQLite database C amalgamation header */
+#include <stdio.h>      /** @note FILE for declarations below */
+
+#define AMT_MEMSTATS_PROC_STATUS "/proc/self/status" /** @note Linux file giving the process resident memory */
+
+void output_mem_stats(amtdb_struct *amtdb, FILE *out); /* show the memory used by SQLite and the process */
+
+#endif // AMT_AMT_MEMSTATS_H
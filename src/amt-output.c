@@ -0,0 +1,504 @@
+/**
+ * @file amt-output.c
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ * @details Buffered output of acronym records. The record blocks shown by searches, 'latest', delete and update are
+ * assembled in one reusable buffer directly from each result column's text and byte length, and sent to stdout with
+ * a small number of large 'write()' calls rather than several 'printf()' calls for every record. Records can also be
+ * written as NDJSON, CSV, TSV or SQL for use by other programs. These are escaped as they are copied from the column text,
+ * so output of any number of records uses the same fixed amount of memory.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ */
+
+#include "amt-output.h"
+
+#include <errno.h>             /* errno and EINTR */
+#include <stdio.h>             /* fflush and perror */
+#include <string.h>            /* memcpy strlen */
+#include <strings.h>           /* strcasecmp */
+#include <unistd.h>            /* write */
+
+/** @note output waiting to be written to stdout, and the number of bytes of it used */
+static char outbuf[AMT_OUTBUF_SIZE];
+static size_t outbuf_used = 0;
+static bool outbuf_held = false;
+static output_format outbuf_format = OUTPUT_TEXT;
+
+/** @note '--format' names, and the field names used for the columns of a record in each format */
+static const char *const format_names[] = {
+    [OUTPUT_TEXT] = "text",
+    [OUTPUT_NDJSON] = "ndjson",
+    [OUTPUT_CSV] = "csv",
+    [OUTPUT_TSV] = "tsv",
+    [OUTPUT_SQL] = "sql",
+};
+static const char *const field_names[] = {"id", "acronym", "definition", "source", "description", "changed"};
+#define FIELD_COUNT (sizeof(field_names) / sizeof(field_names[0]))
+
+/**
+ * @brief Write all the buffered output to stdout now, whether held or not.
+ * @note Anything already printed with stdio is flushed first, so output appears in the order it was produced.
+ */
+static void outbuf_drain(const char *text, size_t len)
+{
+    fflush(stdout);
+
+    while (len > 0) {
+        ssize_t done = write(STDOUT_FILENO, text, len);
+        if (done < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("\nERROR: unable to write output");
+            return;
+        }
+        text += done;
+        len -= (size_t)done;
+    }
+}
+
+/**
+ * @brief Add text to the output buffer, writing the buffer to stdout first if the text does not fit.
+ * @param const char *text : the text to add. It does not need to be nul terminated.
+ * @param size_t len : the number of bytes of 'text' to add.
+ * @return none
+ */
+void outbuf_write(const char *text, size_t len)
+{
+    if (len > sizeof(outbuf) - outbuf_used) {
+        outbuf_drain(outbuf, outbuf_used);
+        outbuf_used = 0;
+        /* text too large to ever fit in the buffer is written directly */
+        if (len > sizeof(outbuf)) {
+            outbuf_drain(text, len);
+            return;
+        }
+    }
+    memcpy(outbuf + outbuf_used, text, len);
+    outbuf_used += len;
+}
+
+/**
+ * @brief Add a nul terminated string to the output buffer.
+ * @param const char *text : the string to add.
+ * @return none
+ */
+void outbuf_puts(const char *text)
+{
+    outbuf_write(text, strlen(text));
+}
+
+/**
+ * @brief Add a number to the output buffer as decimal text, without the locale grouping 'printf()' would apply.
+ * @param long long value : the number to add.
+ * @return none
+ */
+void outbuf_int(long long value)
+{
+    char digits[24];
+    char *p = digits + sizeof(digits);
+    unsigned long long n = (value < 0) ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+
+    do {
+        *--p = (char)('0' + (n % 10));
+        n /= 10;
+    } while (n > 0);
+    if (value < 0) {
+        *--p = '-';
+    }
+    outbuf_write(p, (size_t)(digits + sizeof(digits) - p));
+}
+
+/**
+ * @brief Add the text of a result column to the output buffer.
+ * @param sqlite3_stmt *stmt : the statement positioned on a result row.
+ * @param int col : the column number, counting from zero.
+ * @return none
+ * @note The length comes from 'sqlite3_column_bytes()', called after 'sqlite3_column_text()' as the SQLite
+ * documentation advises, so the text never needs to be scanned for its length. A NULL column adds nothing.
+ */
+void outbuf_column(sqlite3_stmt *stmt, int col)
+{
+    const unsigned char *text = sqlite3_column_text(stmt, col);
+    if (text != NULL) {
+        outbuf_write((const char *)text, (size_t)sqlite3_column_bytes(stmt, col));
+    }
+}
+
+/** @note add a string literal without the cost of 'strlen()' */
+#define OUTBUF_LITERAL(s) outbuf_write((s), sizeof(s) - 1)
+
+/**
+ * @brief Look up the output format for a '--format' name.
+ * @param const char *name : the name given by the user, such as 'ndjson', 'csv' or 'tsv'.
+ * @param output_format *format : set to the format found.
+ * @return bool : true if the name is a known format.
+ */
+bool outbuf_parse_format(const char *name, output_format *format)
+{
+    for (size_t i = 0; i < sizeof(format_names) / sizeof(format_names[0]); i++) {
+        if (strcasecmp(name, format_names[i]) == 0) {
+            *format = (output_format)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Get the '--format' name of an output format.
+ * @param output_format format : the format to name.
+ * @return const char* : the name, such as 'csv'.
+ */
+const char *outbuf_format_name(output_format format)
+{
+    return format_names[format];
+}
+
+/**
+ * @brief Set the format records are written in by 'outbuf_record()'.
+ * @param output_format format : the format to use.
+ * @return none
+ */
+void outbuf_set_format(output_format format)
+{
+    outbuf_format = format;
+}
+
+/**
+ * @brief Add the line naming each field to the output buffer, when the output format is CSV or TSV. For SQL output
+ * add the statements that start the transaction the records are inserted in.
+ * @return none
+ */
+void outbuf_header(void)
+{
+    if (outbuf_format == OUTPUT_SQL) {
+        OUTBUF_LITERAL("BEGIN TRANSACTION;\n"
+                       "CREATE TABLE IF NOT EXISTS ACRONYMS(Acronym, Definition, Description, Source, Changed);\n");
+        return;
+    }
+    if (outbuf_format != OUTPUT_CSV && outbuf_format != OUTPUT_TSV) {
+        return;
+    }
+    for (size_t i = 0; i < FIELD_COUNT; i++) {
+        if (i > 0) {
+            outbuf_write((outbuf_format == OUTPUT_CSV) ? "," : "\t", 1);
+        }
+        outbuf_puts(field_names[i]);
+    }
+    outbuf_write("\n", 1);
+}
+
+/**
+ * @brief Add the statement that ends the transaction started by 'outbuf_header()', when the output format is SQL.
+ * @return none
+ */
+void outbuf_footer(void)
+{
+    if (outbuf_format == OUTPUT_SQL) {
+        OUTBUF_LITERAL("COMMIT;\n");
+        outbuf_flush();
+    }
+}
+
+/**
+ * @brief Get the length of the well formed UTF-8 character, of two or more bytes, at the start of 'text'.
+ * @return size_t : the bytes in the character, or zero if it is not well formed as RFC 3629 sets out: a lead byte
+ * of 0xC2 to 0xF4, followed by the right number of continuation bytes, with no over long form, surrogate, or code
+ * point above U+10FFFF.
+ */
+static size_t utf8_char_len(const unsigned char *text, size_t avail)
+{
+    const unsigned char c = text[0];
+    size_t need;
+    unsigned char low = 0x80, high = 0xBF; /* the range allowed for the second byte */
+
+    if (c >= 0xC2 && c <= 0xDF) {
+        need = 2;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        need = 3;
+        low = (c == 0xE0) ? 0xA0 : 0x80;
+        high = (c == 0xED) ? 0x9F : 0xBF;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        need = 4;
+        low = (c == 0xF0) ? 0x90 : 0x80;
+        high = (c == 0xF4) ? 0x8F : 0xBF;
+    } else {
+        return 0;
+    }
+    if (avail < need || text[1] < low || text[1] > high) {
+        return 0;
+    }
+    for (size_t i = 2; i < need; i++) {
+        if ((text[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return need;
+}
+
+/**
+ * @brief Add text to the output buffer as the contents of a JSON string, escaping it as RFC 8259 requires.
+ * @note Runs of text needing no escapes are copied in one go. Well formed UTF-8 text is copied unchanged, and each
+ * byte that is not part of a well formed character is written as '\ufffd', the replacement character, so the
+ * output is always valid JSON whatever was stored in the database.
+ */
+static void outbuf_json_text(const unsigned char *text, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t run = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        const unsigned char c = text[i];
+        if (c >= 0x20 && c < 0x80 && c != '"' && c != '\\') {
+            continue;
+        }
+        if (c >= 0x80) {
+            const size_t clen = utf8_char_len(text + i, len - i);
+            if (clen > 0) {
+                i += clen - 1;
+                continue;
+            }
+        }
+        outbuf_write((const char *)text + run, i - run);
+        run = i + 1;
+        if (c >= 0x80) {
+            OUTBUF_LITERAL("\\ufffd");
+            continue;
+        }
+        switch (c) {
+        case '"':
+            OUTBUF_LITERAL("\\\"");
+            break;
+        case '\\':
+            OUTBUF_LITERAL("\\\\");
+            break;
+        case '\n':
+            OUTBUF_LITERAL("\\n");
+            break;
+        case '\r':
+            OUTBUF_LITERAL("\\r");
+            break;
+        case '\t':
+            OUTBUF_LITERAL("\\t");
+            break;
+        default: {
+            const char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0f]};
+            outbuf_write(esc, sizeof(esc));
+            break;
+        }
+        }
+    }
+    outbuf_write((const char *)text + run, len - run);
+}
+
+/**
+ * @brief Add text to the output buffer as a CSV field. A field holding a comma, quote or line break is quoted,
+ * with any quotes in it doubled, as set out in RFC 4180.
+ */
+static void outbuf_csv_text(const unsigned char *text, size_t len)
+{
+    bool quote = false;
+    for (size_t i = 0; i < len && !quote; i++) {
+        quote = (text[i] == ',' || text[i] == '"' || text[i] == '\n' || text[i] == '\r');
+    }
+    if (!quote) {
+        outbuf_write((const char *)text, len);
+        return;
+    }
+
+    outbuf_write("\"", 1);
+    size_t run = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '"') {
+            /* copy up to and including the quote, which is then added again to double it */
+            outbuf_write((const char *)text + run, i + 1 - run);
+            run = i;
+        }
+    }
+    outbuf_write((const char *)text + run, len - run);
+    outbuf_write("\"", 1);
+}
+
+/**
+ * @brief Add text to the output buffer as a TSV field. Tabs, line breaks and backslashes in the text are written as
+ * '\t', '\n', '\r' and '\\' so every record stays on one line.
+ */
+static void outbuf_tsv_text(const unsigned char *text, size_t len)
+{
+    size_t run = 0;
+    for (size_t i = 0; i < len; i++) {
+        const unsigned char c = text[i];
+        if (c != '\t' && c != '\n' && c != '\r' && c != '\\') {
+            continue;
+        }
+        outbuf_write((const char *)text + run, i - run);
+        run = i + 1;
+        const char esc[2] = {'\\', (c == '\t') ? 't' : (c == '\n') ? 'n' : (c == '\r') ? 'r' : '\\'};
+        outbuf_write(esc, sizeof(esc));
+    }
+    outbuf_write((const char *)text + run, len - run);
+}
+
+/**
+ * @brief Add text to the output buffer as an SQL string literal, with any single quotes in it doubled.
+ */
+static void outbuf_sql_text(const unsigned char *text, size_t len)
+{
+    outbuf_write("'", 1);
+    size_t run = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '\'') {
+            /* copy up to and including the quote, which is then added again to double it */
+            outbuf_write((const char *)text + run, i + 1 - run);
+            run = i;
+        }
+    }
+    outbuf_write((const char *)text + run, len - run);
+    outbuf_write("'", 1);
+}
+
+/**
+ * @brief Add a record to the output buffer in one of the NDJSON, CSV, TSV or SQL formats.
+ * @note The record ID is written as a number. Every other field is written as text.
+ */
+static void outbuf_record_fields(long long id, const unsigned char *const *text, const size_t *len)
+{
+    if (outbuf_format == OUTPUT_NDJSON) {
+        OUTBUF_LITERAL("{\"id\":");
+    } else if (outbuf_format == OUTPUT_SQL) {
+        OUTBUF_LITERAL("INSERT INTO ACRONYMS(rowid,Acronym,Definition,Source,Description,Changed) VALUES(");
+    }
+    outbuf_int(id);
+
+    for (size_t f = 0; f < AMT_OUTPUT_FIELDS; f++) {
+        switch (outbuf_format) {
+        case OUTPUT_NDJSON:
+            OUTBUF_LITERAL(",\"");
+            outbuf_puts(field_names[f + 1]);
+            OUTBUF_LITERAL("\":\"");
+            outbuf_json_text(text[f], len[f]);
+            OUTBUF_LITERAL("\"");
+            break;
+        case OUTPUT_CSV:
+            OUTBUF_LITERAL(",");
+            outbuf_csv_text(text[f], len[f]);
+            break;
+        case OUTPUT_SQL:
+            OUTBUF_LITERAL(",");
+            outbuf_sql_text(text[f], len[f]);
+            break;
+        default:
+            OUTBUF_LITERAL("\t");
+            outbuf_tsv_text(text[f], len[f]);
+            break;
+        }
+    }
+    if (outbuf_format == OUTPUT_NDJSON) {
+        OUTBUF_LITERAL("}");
+    } else if (outbuf_format == OUTPUT_SQL) {
+        OUTBUF_LITERAL(");");
+    }
+    OUTBUF_LITERAL("\n");
+}
+
+/**
+ * @brief Add a record held as field values to the output buffer, in the format set by 'outbuf_set_format()'.
+ * @param long long id : the record ID.
+ * @param const unsigned char *const *text : the 'AMT_OUTPUT_FIELDS' field values in the order: Acronym,
+ * Definition, Source, Description, Changed. They do not need to be nul terminated.
+ * @param const size_t *len : the length in bytes of each field value.
+ * @return none
+ */
+void outbuf_record_values(long long id, const unsigned char *const *text, const size_t *len)
+{
+    if (outbuf_format != OUTPUT_TEXT) {
+        outbuf_record_fields(id, text, len);
+        return;
+    }
+
+    OUTBUF_LITERAL("\nID:          ");
+    outbuf_int(id);
+    OUTBUF_LITERAL("\nACRONYM:     '");
+    outbuf_write((const char *)text[0], len[0]);
+    OUTBUF_LITERAL("' is: '");
+    outbuf_write((const char *)text[1], len[1]);
+    OUTBUF_LITERAL("'.\nSOURCE:      '");
+    outbuf_write((const char *)text[2], len[2]);
+    OUTBUF_LITERAL("'\nLAST UPDATE: ");
+    outbuf_write((const char *)text[4], len[4]);
+    OUTBUF_LITERAL("\nDESCRIPTION: ");
+    outbuf_write((const char *)text[3], len[3]);
+    OUTBUF_LITERAL("\n");
+}
+
+/**
+ * @brief Add a search or 'latest' result record to the output buffer, in the format set by 'outbuf_set_format()'.
+ * @param sqlite3_stmt *stmt : statement positioned on a row with the columns: rowid, Acronym, Definition, Source,
+ * Description, Changed.
+ * @return none
+ * @note The record ID is added from its integer value, which saves SQLite converting it to text first.
+ */
+void outbuf_record(sqlite3_stmt *stmt)
+{
+    const unsigned char *text[AMT_OUTPUT_FIELDS];
+    size_t len[AMT_OUTPUT_FIELDS];
+
+    for (int f = 0; f < AMT_OUTPUT_FIELDS; f++) {
+        text[f] = sqlite3_column_text(stmt, f + 1);
+        len[f] = (text[f] != NULL) ? (size_t)sqlite3_column_bytes(stmt, f + 1) : 0;
+    }
+    outbuf_record_values(sqlite3_column_int64(stmt, 0), text, len);
+}
+
+/**
+ * @brief Add the record block displayed before a record is deleted or updated to the output buffer.
+ * @param sqlite3_stmt *stmt : statement positioned on a row with the columns: rowid, Acronym, Definition,
+ * Description, Source.
+ * @return none
+ */
+void outbuf_record_detail(sqlite3_stmt *stmt)
+{
+    OUTBUF_LITERAL("ID:          ");
+    outbuf_int(sqlite3_column_int64(stmt, 0));
+    OUTBUF_LITERAL("\nACRONYM:     '");
+    outbuf_column(stmt, 1);
+    OUTBUF_LITERAL("' is: ");
+    outbuf_column(stmt, 2);
+    OUTBUF_LITERAL(".\nDESCRIPTION: ");
+    outbuf_column(stmt, 3);
+    OUTBUF_LITERAL("\nSOURCE: ");
+    outbuf_column(stmt, 4);
+    OUTBUF_LITERAL("\n");
+}
+
+/**
+ * @brief Hold output in the buffer across calls to 'outbuf_flush()', such as for all the searches of a batch.
+ * @param bool hold : true to start holding output. false to stop, and write out anything held.
+ * @return none
+ * @note While held the buffer is still written out whenever it fills. Nothing may be printed with stdio until
+ * holding stops, or it would appear ahead of the held output.
+ */
+void outbuf_hold(bool hold)
+{
+    outbuf_held = hold;
+    if (!hold) {
+        outbuf_flush();
+    }
+}
+
+/**
+ * @brief Write any buffered output to stdout, unless output is being held.
+ * @return none
+ * @note Must be called before returning to code that prints with stdio.
+ */
+void outbuf_flush(void)
+{
+    if (outbuf_held || outbuf_used == 0) {
+        return;
+    }
+    outbuf_drain(outbuf, outbuf_used);
+    outbuf_used = 0;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file amt-output.h
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ *
+ * @author     simon rowe <simon@wiremoons.com>
+ * @license    open-source released under "MIT License"
+ * @source     https://github.com/wiremoons/acroman
+ *
+ */
+
+#ifndef AMT_AMT_OUTPUT_H /* Include guard */
+#define AMT_AMT_OUTPUT_H
+
+#include "types.h"      /** @note Programs own structure to manage SQLite database information */
+#include "sqlite3.h"    /** @note SQLite database C amalgamation header */
+#include <stdbool.h>    /** @note use of true / false booleans for declarations below*/
+#include <stddef.h>     /** @note size_t */
+
+#define AMT_OUTBUF_SIZE (64 * 1024) /** @note bytes of output gathered before each 'write()' to stdout */
+#define AMT_OUTPUT_FIELDS 5         /** @note fields of a record after its ID, as passed to 'outbuf_record_values()' */
+
+bool outbuf_parse_format(const char *name, output_format *format); /* look up a '--format' name */
+const char *outbuf_format_name(output_format format); /* the '--format' name of a format */
+void outbuf_set_format(output_format format);        /* set the format used by 'outbuf_record()' */
+void outbuf_header(void);                            /* add the header line for CSV and TSV output */
+void outbuf_footer(void);                            /* add the end of the transaction for SQL output */
+void outbuf_write(const char *text, size_t len);     /* add 'len' bytes of text to the output buffer */
+void outbuf_puts(const char *text);                  /* add a nul terminated string to the output buffer */
+void outbuf_int(long long value);                    /* add a number as text to the output buffer */
+void outbuf_column(sqlite3_stmt *stmt, int col);     /* add a result column's text to the output buffer */
+void outbuf_record(sqlite3_stmt *stmt);              /* add a search or latest result record */
+void outbuf_record_values(long long id, const unsigned char *const *text, const size_t *len); /* add a record */
+void outbuf_record_detail(sqlite3_stmt *stmt);       /* add a record block shown for delete and update */
+void outbuf_hold(bool hold);                         /* gather output across many calls to 'outbuf_flush()' */
+void outbuf_flush(void);                             /* write any buffered output to stdout */
+
+#endif // AMT_AMT_OUTPUT_H
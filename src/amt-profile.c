@@ -0,0 +1,127 @@
+/**
+ * @file amt-profile.c
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ * @details Program to managed SQLite database containing acronyms. This source code shows how long each SQL statement
+ * takes to run, and the work SQLite did for it, when '--profile' is given.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note SQLite calls 'profile_trace()' as each statement starts and finishes, and the wall time between the two is
+ * shown, to the microsecond, as SQLite only gives it to the millisecond on some systems. The statement status
+ * counters show why a statement took the time it did: a full table scan, a sort for an 'ORDER BY', an index built
+ * for a join, or simply many virtual machine steps. The counters are reset after each report, so statements kept
+ * in the prepared statement registry are reported for each run rather than as running totals.
+ */
+
+#include "amt-profile.h"
+#include "amt-db-funcs.h"
+
+#include <stdio.h>  /* fprintf */
+#include <string.h> /* strlen */
+#include <time.h>   /* clock_gettime */
+
+/** @note totals for every statement run, for 'profile_report()' */
+static long long profile_statements = 0;
+static sqlite3_int64 profile_nsecs = 0;
+static long long profile_scans = 0;
+static long long profile_sorts = 0;
+
+/** @note the statements that have started but not yet finished, with the time each started */
+static struct {
+    sqlite3_stmt *stmt;
+    struct timespec start;
+} profile_running[AMT_PROFILE_MAX_RUNNING];
+static int profile_nrunning = 0;
+
+
+/**
+ * @brief SQLite trace callback: note the time a statement starts, and when it finishes show it with its run time and
+ * status counters.
+ * @param unsigned mask : the trace event: 'SQLITE_TRACE_STMT' as a statement starts or 'SQLITE_TRACE_PROFILE' as it
+ * finishes.
+ * @param void *ctx : not used.
+ * @param void *p : the statement.
+ * @param void *x : for 'SQLITE_TRACE_PROFILE' the run time SQLite measured in nanoseconds, as an 'sqlite3_int64'.
+ * @return int : always zero, as SQLite requires.
+ */
+static int profile_trace(unsigned mask, void *ctx, void *p, void *x)
+{
+    (void)ctx;
+    sqlite3_stmt *stmt = p;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    /** @note a statement already running is a trigger starting inside it, so is timed as part of it */
+    int found = profile_nrunning - 1;
+    while (found >= 0 && profile_running[found].stmt != stmt) {
+        found--;
+    }
+
+    if (mask == SQLITE_TRACE_STMT) {
+        if (found < 0 && profile_nrunning < AMT_PROFILE_MAX_RUNNING) {
+            profile_running[profile_nrunning].stmt = stmt;
+            profile_running[profile_nrunning].start = now;
+            profile_nrunning++;
+        }
+        return 0;
+    }
+
+    sqlite3_int64 nsecs = *(const sqlite3_int64 *)x;
+    if (found >= 0) {
+        nsecs = (sqlite3_int64)(now.tv_sec - profile_running[found].start.tv_sec) * 1000000000 +
+                (now.tv_nsec - profile_running[found].start.tv_nsec);
+        profile_running[found] = profile_running[--profile_nrunning];
+    }
+    const int scan = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1);
+    const int sort = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 1);
+    const int autoindex = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_AUTOINDEX, 1);
+    const int vm = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 1);
+
+    profile_statements++;
+    profile_nsecs += nsecs;
+    profile_scans += scan;
+    profile_sorts += sort;
+
+    /** @note the SQL with its values bound, so a slow search can be run again by hand */
+    char *sql = sqlite3_expanded_sql(stmt);
+    const char *text = (sql != NULL) ? sql : sqlite3_sql(stmt);
+    const int len = (int)strlen(text);
+
+    fprintf(stderr, "PROFILE: %10.3f ms  vm %9d  scan %9d  sort %3d  autoindex %3d  %.*s%s\n", (double)nsecs / 1e6,
+            vm, scan, sort, autoindex, (len > AMT_PROFILE_MAX_SQL) ? AMT_PROFILE_MAX_SQL : len, text,
+            (len > AMT_PROFILE_MAX_SQL) ? "..." : "");
+    sqlite3_free(sql);
+    return 0;
+}
+
+
+/**
+ * @brief Start showing each SQL statement run on the database connection, as it finishes.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : success status for functions execution.
+ * @note Called by 'initialise_database()' straight after the database is opened when 'amtdb->profile' is set, so
+ * the statements used to set up the connection are shown too. The output is to stderr, so records written to stdout
+ * for another program are not changed.
+ */
+bool profile_start(amtdb_struct *amtdb)
+{
+    if (sqlite3_trace_v2(amtdb->db, SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE, profile_trace, NULL) != SQLITE_OK) {
+        fprintf(stderr, "ERROR: unable to profile the database statements: %s\n", sqlite3_errmsg(amtdb->db));
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Show the totals for every statement run, and how often each registry statement was prepared and stepped.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @note Called on exit. Must be called before the registry statements are finalized.
+ */
+void profile_report(amtdb_struct *amtdb)
+{
+    fprintf(stderr, "\nPROFILE: '%lld' statements ran in %.3f ms, with '%lld' full scan steps and '%lld' sorts.\n",
+            profile_statements, (double)profile_nsecs / 1e6, profile_scans, profile_sorts);
+    output_stmt_stats(amtdb);
+}
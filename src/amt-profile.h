@@ -0,0 +1,24 @@
+/**
+ * @file amt-profile.h
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ *
+ * @author     simon rowe <simon@wiremoons.com>
+ * @license    open-source released under "MIT License"
+ * @source     https://github.com/wiremoons/acroman
+ *
+ */
+
+#ifndef AMT_AMT_PROFILE_H /* Include guard */
+#define AMT_AMT_PROFILE_H
+
+#include "types.h"      /** @note Programs own structure to manage SQLite database information */
+#include "sqlite3.h"    /** @note SQLite database C amalgamation header */
+#include <stdbool.h>    /** @note use of true / false booleans for declarations below*/
+
+#define AMT_PROFILE_MAX_SQL 160    /** @note longest SQL shown for each statement run, with its values bound */
+#define AMT_PROFILE_MAX_RUNNING 16 /** @note most statements timed at once, such as one stepped while another runs */
+
+bool profile_start(amtdb_struct *amtdb);  /* show each SQL statement run, with its time and work done */
+void profile_report(amtdb_struct *amtdb); /* show the totals for every statement run */
+
+#endif // AMT_AMT_PROFILE_H
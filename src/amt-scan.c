@@ -0,0 +1,644 @@
+/**
+ * @file amt-scan.c
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ * @details Program to managed SQLite database containing acronyms. This source code manages the scanning of a
+ * document for every acronym known to the database.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note Every acronym is loaded into an Aho-Corasick automaton, so a file is read just once however many acronyms
+ * the database holds. The file is memory mapped and split into chunks that are scanned by separate threads. A
+ * thread starts its scan early enough to see any acronym that ends inside its chunk, and only reports those, so
+ * each match is found exactly once. A match is only reported when it is a whole word - 'AT' is not found inside
+ * 'NATO' - and the case must match exactly.
+ */
+
+#include "amt-scan.h"
+#include "amt-db-funcs.h"
+
+/* added to enable compile on macOS */
+#ifndef __clang__
+#include <malloc.h> /* free for use with strdup and malloc */
+#endif
+
+#include <ctype.h>     /* isalnum */
+#include <fcntl.h>     /* open */
+#include <pthread.h>   /* pthread_create pthread_join */
+#include <stdint.h>    /* int32_t */
+#include <stdio.h>     /* printf */
+#include <stdlib.h>    /* malloc qsort */
+#include <string.h>    /* strlen strndup memchr */
+#include <sys/mman.h>  /* mmap munmap madvise */
+#include <sys/stat.h>  /* fstat */
+#include <unistd.h>    /* close sysconf */
+
+/** @note a node in the automaton. Children are held as a linked list of siblings, apart from the root node's which
+ * are held in the 'root' table of 'ac_automaton' for speed. */
+typedef struct {
+    int32_t child;    /* first child node, or -1 */
+    int32_t sibling;  /* next sibling node, or -1 */
+    int32_t fail;     /* longest proper suffix of this node that is also in the automaton */
+    int32_t dict;     /* nearest node on the fail chain that completes an acronym, or -1 */
+    int32_t out;      /* acronym completed at this node, or -1 */
+    unsigned char ch; /* byte on the edge from the parent node */
+} ac_node;
+
+/** @note the Aho-Corasick automaton and the acronyms it was built from */
+typedef struct {
+    ac_node *nodes;
+    int32_t nnodes;
+    int32_t size;
+    int32_t root[256];
+    char **acronyms;
+    size_t *lens;
+    int32_t nacronyms;
+    size_t maxlen;
+} ac_automaton;
+
+/** @note one acronym found in the file */
+typedef struct {
+    int32_t id;
+    size_t offset;
+} scan_match;
+
+/** @note work for one scanning thread, and the matches it found */
+typedef struct {
+    const ac_automaton *ac;
+    const unsigned char *data;
+    size_t filesize;
+    size_t start;
+    size_t end;
+    scan_match *matches;
+    size_t count;
+    size_t size;
+    bool ok;
+} scan_job;
+
+/** @note a match position to be displayed, with its line and column numbers counting from one */
+typedef struct {
+    size_t offset;
+    size_t line;
+    size_t col;
+} scan_pos;
+
+/** @note totals for one acronym found in the file */
+typedef struct {
+    int32_t id;
+    size_t count;
+    size_t first; /* index of the acronyms first match in the merged match list */
+} scan_found;
+
+
+/**
+ * @brief Add a new node to the automaton.
+ * @return int32_t : the new node index, or -1 if memory could not be allocated.
+ */
+static int32_t ac_new_node(ac_automaton *ac, unsigned char ch)
+{
+    if (ac->nnodes == ac->size) {
+        int32_t newsize = ac->size ? ac->size * 2 : 1024;
+        ac_node *grown = realloc(ac->nodes, (size_t)newsize * sizeof(ac_node));
+        if (grown == NULL) {
+            return -1;
+        }
+        ac->nodes = grown;
+        ac->size = newsize;
+    }
+
+    ac_node *node = &ac->nodes[ac->nnodes];
+    node->child = -1;
+    node->sibling = -1;
+    node->fail = 0;
+    node->dict = -1;
+    node->out = -1;
+    node->ch = ch;
+    return ac->nnodes++;
+}
+
+
+/**
+ * @brief Find the child of 'state' on the edge for byte 'ch'.
+ * @return int32_t : the child node index, or -1 if there is none.
+ */
+static inline int32_t ac_child(const ac_automaton *ac, int32_t state, unsigned char ch)
+{
+    if (state == 0) {
+        return ac->root[ch];
+    }
+    for (int32_t c = ac->nodes[state].child; c != -1; c = ac->nodes[c].sibling) {
+        if (ac->nodes[c].ch == ch) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+
+/**
+ * @brief Add one acronym to the automaton's trie.
+ */
+static bool ac_add(ac_automaton *ac, int32_t id)
+{
+    const unsigned char *word = (const unsigned char *)ac->acronyms[id];
+    int32_t state = 0;
+
+    for (size_t i = 0; i < ac->lens[id]; i++) {
+        int32_t next = ac_child(ac, state, word[i]);
+        if (next == -1) {
+            next = ac_new_node(ac, word[i]);
+            if (next == -1) {
+                return false;
+            }
+            if (state == 0) {
+                ac->root[word[i]] = next;
+            } else {
+                ac->nodes[next].sibling = ac->nodes[state].child;
+                ac->nodes[state].child = next;
+            }
+        }
+        state = next;
+    }
+
+    ac->nodes[state].out = id;
+    return true;
+}
+
+
+/**
+ * @brief Set the fail and dictionary links for every node, working down the trie one level at a time.
+ */
+static bool ac_link(ac_automaton *ac)
+{
+    int32_t *queue = malloc((size_t)ac->nnodes * sizeof(int32_t));
+    if (queue == NULL) {
+        return false;
+    }
+    int32_t head = 0;
+    int32_t tail = 0;
+
+    for (int c = 0; c < 256; c++) {
+        if (ac->root[c] != -1) {
+            ac->nodes[ac->root[c]].fail = 0;
+            queue[tail++] = ac->root[c];
+        }
+    }
+
+    while (head < tail) {
+        int32_t node = queue[head++];
+        for (int32_t c = ac->nodes[node].child; c != -1; c = ac->nodes[c].sibling) {
+            int32_t f = ac->nodes[node].fail;
+            int32_t target = ac_child(ac, f, ac->nodes[c].ch);
+            while (target == -1 && f != 0) {
+                f = ac->nodes[f].fail;
+                target = ac_child(ac, f, ac->nodes[c].ch);
+            }
+            ac->nodes[c].fail = (target == -1) ? 0 : target;
+
+            int32_t fail = ac->nodes[c].fail;
+            ac->nodes[c].dict = (ac->nodes[fail].out != -1) ? fail : ac->nodes[fail].dict;
+            queue[tail++] = c;
+        }
+    }
+
+    free(queue);
+    return true;
+}
+
+
+/**
+ * @brief Release all memory held by the automaton.
+ */
+static void ac_free(ac_automaton *ac)
+{
+    for (int32_t i = 0; i < ac->nacronyms; i++) {
+        free(ac->acronyms[i]);
+    }
+    free(ac->acronyms);
+    free(ac->lens);
+    free(ac->nodes);
+}
+
+
+/**
+ * @brief Load every distinct acronym from the database and build the automaton from them.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @param ac_automaton *ac : the automaton to build.
+ * @return bool : success status for functions execution.
+ * @note Uses the following SQL:
+ * @code select distinct Acronym from ACRONYMS where Acronym is not null;
+ */
+static bool ac_build(amtdb_struct *amtdb, ac_automaton *ac)
+{
+    memset(ac, 0, sizeof(*ac));
+    memset(ac->root, -1, sizeof(ac->root));
+
+    sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_DISTINCT_ACRONYMS);
+    if (stmt == NULL || ac_new_node(ac, 0) != 0) {
+        return false;
+    }
+
+    int32_t size = 0;
+    bool result = true;
+    while (result && step_stmt(amtdb, AMT_STMT_DISTINCT_ACRONYMS) == SQLITE_ROW) {
+        size_t len = (size_t)sqlite3_column_bytes(stmt, 0);
+        if (len == 0) {
+            continue;
+        }
+        if (ac->nacronyms == size) {
+            size = size ? size * 2 : 1024;
+            char **grown = realloc(ac->acronyms, (size_t)size * sizeof(char *));
+            size_t *grownlens = realloc(ac->lens, (size_t)size * sizeof(size_t));
+            if (grown != NULL) {
+                ac->acronyms = grown;
+            }
+            if (grownlens != NULL) {
+                ac->lens = grownlens;
+            }
+            if (grown == NULL || grownlens == NULL) {
+                result = false;
+                break;
+            }
+        }
+        ac->acronyms[ac->nacronyms] = strndup((const char *)sqlite3_column_text(stmt, 0), len);
+        ac->lens[ac->nacronyms] = len;
+        if (ac->acronyms[ac->nacronyms] == NULL) {
+            result = false;
+            break;
+        }
+        if (len > ac->maxlen) {
+            ac->maxlen = len;
+        }
+        result = ac_add(ac, ac->nacronyms);
+        ac->nacronyms++;
+    }
+    release_stmt(amtdb, AMT_STMT_DISTINCT_ACRONYMS);
+
+    if (result) {
+        result = ac_link(ac);
+    }
+    if (!result) {
+        perror("\nERROR: unable to allocate memory for the acronym scanner\n");
+    }
+    return result;
+}
+
+
+/**
+ * @brief Check the bytes either side of a match, so only acronyms that are whole words are reported.
+ */
+static inline bool is_whole_word(const scan_job *job, size_t start, size_t len)
+{
+    const unsigned char *word = job->data + start;
+    if (start > 0 && isalnum(word[0]) && isalnum(word[-1])) {
+        return false;
+    }
+    if (start + len < job->filesize && isalnum(word[len - 1]) && isalnum(word[len])) {
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Thread entry point: run the automaton over one chunk of the file, collecting the matches ending in it.
+ */
+static void *scan_chunk(void *arg)
+{
+    scan_job *job = arg;
+    const ac_automaton *ac = job->ac;
+    const ac_node *nodes = ac->nodes;
+
+    /** @note begin far enough back to see the start of the longest acronym that could end in this chunk */
+    size_t pos = (job->start > ac->maxlen) ? job->start - (ac->maxlen - 1) : 0;
+    int32_t state = 0;
+
+    for (; pos < job->end; pos++) {
+        unsigned char ch = job->data[pos];
+        int32_t next = ac_child(ac, state, ch);
+        while (next == -1 && state != 0) {
+            state = nodes[state].fail;
+            next = ac_child(ac, state, ch);
+        }
+        state = (next == -1) ? 0 : next;
+
+        if (pos < job->start) {
+            continue;
+        }
+
+        int32_t hit = (nodes[state].out != -1) ? state : nodes[state].dict;
+        for (; hit != -1; hit = nodes[hit].dict) {
+            int32_t id = nodes[hit].out;
+            size_t start = pos + 1 - ac->lens[id];
+            if (!is_whole_word(job, start, ac->lens[id])) {
+                continue;
+            }
+            if (job->count == job->size) {
+                size_t newsize = job->size ? job->size * 2 : 4096;
+                scan_match *grown = realloc(job->matches, newsize * sizeof(scan_match));
+                if (grown == NULL) {
+                    job->ok = false;
+                    return NULL;
+                }
+                job->matches = grown;
+                job->size = newsize;
+            }
+            job->matches[job->count].id = id;
+            job->matches[job->count].offset = start;
+            job->count++;
+        }
+    }
+
+    return NULL;
+}
+
+
+/**
+ * @brief qsort comparison: most frequently found acronyms first, then in the order they were first seen.
+ */
+static int compare_found(const void *a, const void *b)
+{
+    const scan_found *fa = a;
+    const scan_found *fb = b;
+    if (fa->count != fb->count) {
+        return (fa->count < fb->count) ? 1 : -1;
+    }
+    return (fa->first < fb->first) ? -1 : (fa->first > fb->first);
+}
+
+
+/**
+ * @brief qsort comparison: file positions in the order they appear in the file.
+ */
+static int compare_positions(const void *a, const void *b)
+{
+    const scan_pos *pa = *(scan_pos *const *)a;
+    const scan_pos *pb = *(scan_pos *const *)b;
+    return (pa->offset < pb->offset) ? -1 : (pa->offset > pb->offset);
+}
+
+
+/**
+ * @brief Convert the byte offsets of the positions to be displayed into line and column numbers.
+ * @note The positions are visited in file order, so the file is only read through once to count the lines
+ * however many acronyms were found.
+ */
+static bool set_line_numbers(const unsigned char *data, scan_pos *pos, size_t npos)
+{
+    scan_pos **order = malloc((npos ? npos : 1) * sizeof(scan_pos *));
+    if (order == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < npos; i++) {
+        order[i] = &pos[i];
+    }
+    qsort(order, npos, sizeof(scan_pos *), compare_positions);
+
+    size_t line = 1;
+    size_t line_offset = 0;
+    for (size_t i = 0; i < npos; i++) {
+        const unsigned char *p = data + line_offset;
+        const unsigned char *end = data + order[i]->offset;
+        while ((p = memchr(p, '\n', (size_t)(end - p))) != NULL) {
+            line++;
+            p++;
+            line_offset = (size_t)(p - data);
+        }
+        order[i]->line = line;
+        order[i]->col = order[i]->offset - line_offset + 1;
+    }
+
+    free(order);
+    return true;
+}
+
+
+/**
+ * @brief Output each acronym found, with its definitions from the database, how often it was found, and where.
+ */
+static void output_scan_results(amtdb_struct *amtdb, const ac_automaton *ac, const unsigned char *data,
+                                scan_match *matches, size_t nmatches)
+{
+    /** @note group the matches by acronym with a counting sort; this keeps each acronym's matches in file order */
+    size_t *counts = calloc((size_t)ac->nacronyms + 1, sizeof(size_t));
+    scan_match *grouped = malloc((nmatches ? nmatches : 1) * sizeof(scan_match));
+    if (counts == NULL || grouped == NULL) {
+        perror("\nERROR: unable to allocate memory for the scan results\n");
+        free(counts);
+        free(grouped);
+        return;
+    }
+
+    for (size_t i = 0; i < nmatches; i++) {
+        counts[matches[i].id + 1]++;
+    }
+    size_t nfound = 0;
+    for (int32_t id = 0; id < ac->nacronyms; id++) {
+        if (counts[id + 1] > 0) {
+            nfound++;
+        }
+        counts[id + 1] += counts[id];
+    }
+
+    scan_found *found = malloc((nfound ? nfound : 1) * sizeof(scan_found));
+    if (found == NULL) {
+        perror("\nERROR: unable to allocate memory for the scan results\n");
+        free(counts);
+        free(grouped);
+        return;
+    }
+    nfound = 0;
+    for (int32_t id = 0; id < ac->nacronyms; id++) {
+        if (counts[id + 1] > counts[id]) {
+            found[nfound].id = id;
+            found[nfound].count = counts[id + 1] - counts[id];
+            found[nfound].first = counts[id];
+            nfound++;
+        }
+    }
+    for (size_t i = 0; i < nmatches; i++) {
+        grouped[counts[matches[i].id]++] = matches[i];
+    }
+
+    qsort(found, nfound, sizeof(scan_found), compare_found);
+
+    /** @note the first few positions of each acronym are displayed. Slots for acronym 'f' start at 'f * MAX' */
+    size_t npos = 0;
+    scan_pos *pos = malloc((nfound ? nfound : 1) * AMT_SCAN_MAX_POSITIONS * sizeof(scan_pos));
+    if (pos != NULL) {
+        for (size_t f = 0; f < nfound; f++) {
+            for (size_t i = 0; i < AMT_SCAN_MAX_POSITIONS; i++) {
+                pos[npos++].offset = (i < found[f].count) ? grouped[found[f].first + i].offset : 0;
+            }
+        }
+    }
+    if (pos == NULL || !set_line_numbers(data, pos, npos)) {
+        perror("\nERROR: unable to allocate memory for the scan results\n");
+        free(pos);
+        free(found);
+        free(grouped);
+        free(counts);
+        return;
+    }
+
+    for (size_t f = 0; f < nfound; f++) {
+        const char *acronym = ac->acronyms[found[f].id];
+        printf("\nACRONYM:     '%s' found '%'zu' times.\n", acronym, found[f].count);
+
+        sqlite3_stmt *stmt = get_stmt(amtdb, AMT_STMT_DEFINITIONS);
+        if (stmt != NULL) {
+            sqlite3_bind_text(stmt, 1, acronym, -1, SQLITE_STATIC);
+            while (step_stmt(amtdb, AMT_STMT_DEFINITIONS) == SQLITE_ROW) {
+                printf("DEFINITION:  '%s' (%s)\n", (const char *)sqlite3_column_text(stmt, 0),
+                       (const char *)sqlite3_column_text(stmt, 1));
+            }
+            release_stmt(amtdb, AMT_STMT_DEFINITIONS);
+        }
+
+        printf("POSITIONS:  ");
+        size_t shown = found[f].count < AMT_SCAN_MAX_POSITIONS ? found[f].count : AMT_SCAN_MAX_POSITIONS;
+        for (size_t i = 0; i < shown; i++) {
+            const scan_pos *at = &pos[f * AMT_SCAN_MAX_POSITIONS + i];
+            printf(" %zu:%zu", at->line, at->col);
+        }
+        if (found[f].count > shown) {
+            printf(" ... and '%'zu' more", found[f].count - shown);
+        }
+        printf("\n");
+    }
+
+    printf("\nScan found '%'zu' matches of '%'zu' different acronyms.\n", nmatches, nfound);
+
+    free(pos);
+    free(found);
+    free(grouped);
+    free(counts);
+}
+
+
+/**
+ * @brief Scan a file for every acronym held in the database, and report those found.
+ * @param const char *filename : the file to be scanned.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : success status for functions execution.
+ */
+bool do_document_scan(const char *filename, amtdb_struct *amtdb)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        perror("\nERROR: unable to open the file to be scanned");
+        return false;
+    }
+
+    struct stat sb;
+    if (fstat(fd, &sb) == -1) {
+        perror("\nERROR: call to 'fstat' for the file to be scanned failed");
+        close(fd);
+        return false;
+    }
+    size_t filesize = (size_t)sb.st_size;
+
+    if (filesize == 0) {
+        close(fd);
+        printf("\nScan of empty file '%s' found no acronyms.\n", filename);
+        return true;
+    }
+
+    const unsigned char *data = mmap(NULL, filesize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("\nERROR: unable to memory map the file to be scanned");
+        return false;
+    }
+    madvise((void *)data, filesize, MADV_SEQUENTIAL);
+
+    ac_automaton ac;
+    if (!ac_build(amtdb, &ac)) {
+        ac_free(&ac);
+        munmap((void *)data, filesize);
+        return false;
+    }
+
+    if (ac.nacronyms == 0) {
+        printf("\nThe database holds no acronyms to scan '%s' for.\n", filename);
+        ac_free(&ac);
+        munmap((void *)data, filesize);
+        return true;
+    }
+
+#if DEBUG
+    fprintf(stderr, "DEBUG: scanner built from '%d' acronyms using '%d' nodes\n", ac.nacronyms, ac.nnodes);
+#endif
+
+    /** @note one thread per processor, but only where each has a worthwhile amount of the file to scan */
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t nthreads = (ncpu > 0) ? (size_t)ncpu : 1;
+    if (nthreads > AMT_SCAN_MAX_THREADS) {
+        nthreads = AMT_SCAN_MAX_THREADS;
+    }
+    if (nthreads > filesize / AMT_SCAN_MIN_CHUNK) {
+        nthreads = filesize / AMT_SCAN_MIN_CHUNK;
+    }
+    if (nthreads == 0) {
+        nthreads = 1;
+    }
+
+    scan_job jobs[AMT_SCAN_MAX_THREADS];
+    pthread_t threads[AMT_SCAN_MAX_THREADS];
+    bool started[AMT_SCAN_MAX_THREADS] = {false};
+    size_t chunk = filesize / nthreads;
+
+    for (size_t t = 0; t < nthreads; t++) {
+        jobs[t] = (scan_job){&ac, data, filesize, t * chunk, (t == nthreads - 1) ? filesize : (t + 1) * chunk,
+                             NULL, 0, 0, true};
+        if (t > 0 && pthread_create(&threads[t], NULL, scan_chunk, &jobs[t]) == 0) {
+            started[t] = true;
+        }
+    }
+    /** @note this thread scans the first chunk itself, plus any chunk a thread could not be started for */
+    for (size_t t = 0; t < nthreads; t++) {
+        if (!started[t]) {
+            scan_chunk(&jobs[t]);
+        }
+    }
+
+    size_t nmatches = 0;
+    bool result = true;
+    for (size_t t = 0; t < nthreads; t++) {
+        if (started[t]) {
+            pthread_join(threads[t], NULL);
+        }
+        nmatches += jobs[t].count;
+        result = result && jobs[t].ok;
+    }
+
+    /** @note chunks are in file order, so joining their matches keeps every match in file order */
+    scan_match *matches = NULL;
+    if (result) {
+        matches = malloc((nmatches ? nmatches : 1) * sizeof(scan_match));
+        result = (matches != NULL);
+    }
+    if (result) {
+        size_t pos = 0;
+        for (size_t t = 0; t < nthreads; t++) {
+            memcpy(matches + pos, jobs[t].matches, jobs[t].count * sizeof(scan_match));
+            pos += jobs[t].count;
+        }
+    }
+    for (size_t t = 0; t < nthreads; t++) {
+        free(jobs[t].matches);
+    }
+
+    if (result) {
+        output_scan_results(amtdb, &ac, data, matches, nmatches);
+        printf("Scan of '%s' ('%'zu' bytes) for '%'d' known acronyms used '%zu' threads.\n", filename, filesize,
+               ac.nacronyms, nthreads);
+    } else {
+        perror("\nERROR: unable to allocate memory for the scan matches\n");
+    }
+
+    free(matches);
+    ac_free(&ac);
+    munmap((void *)data, filesize);
+    return result;
+}
@@ -0,0 +1,24 @@
+/**
+ * @file amt-scan.h
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ *
+ * @author     simon rowe <simon@wiremoons.com>
+ * @license    open-source released under "MIT License"
+ * @source     https://github.com/wiremoons/acroman
+ *
+ */
+
+#ifndef AMT_AMT_SCAN_H /* Include guard */
+#define AMT_AMT_SCAN_H
+
+#include "types.h"      /** @note Programs own structure to manage SQLite database information */
+#include "sqlite3.h"    /** @note SQLite database C amalgamation header */
+#include <stdbool.h>    /** @note use of true / false booleans for declarations below*/
+
+#define AMT_SCAN_MAX_THREADS 16          /** @note upper limit on threads used to scan a file */
+#define AMT_SCAN_MIN_CHUNK (4 << 20)     /** @note smallest part of a file worth giving its own thread */
+#define AMT_SCAN_MAX_POSITIONS 10        /** @note positions displayed for each acronym found */
+
+bool do_document_scan(const char *filename, amtdb_struct *amtdb); /* report every known acronym in a file */
+
+#endif // AMT_AMT_SCAN_H
@@ -0,0 +1,629 @@
+/**
+ * @file amt-server.c
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ * @details Program to managed SQLite database containing acronyms. This source code manages the resident server
+ * that answers searches sent to a UNIX domain socket, and the client side that sends them.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note The server opens the database once, so its page cache and prepared statements stay warm between searches.
+ * A client sends one request line per connection, of tab separated fields:
+ * @code <database>  <format>  <command>  <argument> ...
+ * The database is the full path of the file the client would open, found by the client in the same way as when a
+ * command is run directly, so the server only answers for the file it has open.
+ * The server runs the command first, with its stdout a temporary file, so the existing search and output functions
+ * are used unchanged. It then replies 'OK <bytes>' and exactly that many bytes of the same output the command gives
+ * when run directly, or 'ERR <reason>' if it can not answer, in which case the client runs the command itself. The
+ * client only writes the output once all of it has arrived, so a server that stops part way through a reply is
+ * seen, and the command run directly instead, without any of the output shown twice.
+ */
+
+#define _GNU_SOURCE /* struct ucred for SO_PEERCRED on glibc */
+
+#include "amt-server.h"
+#include "amt-db-funcs.h"
+#include "amt-fuzzy.h"
+#include "amt-memstats.h"
+#include "amt-output.h"
+
+/* added to enable compile on macOS */
+#ifndef __clang__
+#include <malloc.h> /* free for use with realpath */
+#endif
+
+#include <errno.h>      /* errno */
+#include <limits.h>     /* PATH_MAX */
+#include <signal.h>     /* sigaction */
+#include <stdio.h>      /* printf snprintf */
+#include <stdlib.h>     /* getenv realpath malloc strtoll */
+#include <string.h>     /* strcmp strchr */
+#include <sys/socket.h> /* socket bind listen accept */
+#include <sys/stat.h>   /* chmod lstat */
+#include <sys/time.h>   /* struct timeval */
+#include <sys/types.h>  /* off_t */
+#include <sys/un.h>     /* struct sockaddr_un */
+#include <unistd.h>     /* read write dup2 getuid ftruncate lseek pread */
+
+/** @note set by SIGINT or SIGTERM to stop the server */
+static volatile sig_atomic_t serve_stop = 0;
+
+/** @note the commands a client may send */
+static const char *const serve_commands[] = {"s", "t", "l", "m"};
+
+
+static void serve_signal(int sig)
+{
+    (void)sig;
+    serve_stop = 1;
+}
+
+
+/**
+ * @brief Get the socket path used by '--serve' when none is given: '$XDG_RUNTIME_DIR/amt.sock' if that is set, or
+ * else '/tmp/amt-<uid>.sock'.
+ * @param char *path : set to the socket path.
+ * @param size_t size : the size of 'path' in bytes.
+ * @return bool : false if the path is too long.
+ */
+bool default_socket_path(char *path, size_t size)
+{
+    const char *dir = getenv("XDG_RUNTIME_DIR");
+    int len;
+
+    if (dir != NULL && dir[0] != '\0') {
+        len = snprintf(path, size, "%s/%s", dir, AMT_SERVE_SOCKET_NAME);
+    } else {
+        len = snprintf(path, size, "/tmp/amt-%ld.sock", (long)getuid());
+    }
+    return len > 0 && (size_t)len < size;
+}
+
+
+/**
+ * @brief Fill in a UNIX socket address for 'path'.
+ * @return bool : false if the path is too long for a socket address.
+ */
+static bool socket_address(const char *path, struct sockaddr_un *addr)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        return false;
+    }
+    strcpy(addr->sun_path, path);
+    return true;
+}
+
+
+/**
+ * @brief Limit how long a read or write on a connection may wait, so a stalled peer can not hold up the other.
+ */
+static void set_socket_timeout(int fd)
+{
+    struct timeval tv = {AMT_SERVE_TIMEOUT_SECS, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+
+/**
+ * @brief Write all of 'len' bytes to a file descriptor.
+ * @return bool : false if the write failed.
+ */
+static bool write_all(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t done = write(fd, data, len);
+        if (done < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += done;
+        len -= (size_t)done;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Run the command of a request, with its output going to stdout.
+ * @return bool : false if the command failed, so its output is not to be sent.
+ * @note The output matches that of the same command run directly - see 'main()'.
+ */
+static bool serve_command(const char *command, char **args, int nargs, amtdb_struct *amtdb)
+{
+    /** @note the servers own memory use, for watching a long running server. Not records, so not formatted */
+    if (strcmp(command, "m") == 0) {
+        output_mem_stats(amtdb, stdout);
+        return true;
+    }
+
+    outbuf_header();
+
+    if (strcmp(command, "s") == 0) {
+        if (nargs > 1) {
+            if (do_batch_search(NULL, args, nargs, amtdb) < 0) {
+                return false;
+            }
+        } else {
+            const int rec_match = do_acronym_search(args[0], amtdb);
+            if (rec_match < 0) {
+                return false;
+            }
+            if (amtdb->format == OUTPUT_TEXT) {
+                printf("\nSearch of '%'d' records for '%s' found '%d' matches.\n\n", amtdb->totalrec, args[0],
+                       rec_match);
+                if (rec_match == 0) {
+                    do_fuzzy_suggest(args[0], amtdb);
+                }
+            }
+        }
+    } else if (strcmp(command, "t") == 0) {
+        const int rec_match = do_text_search(args[0], amtdb);
+        if (rec_match < 0) {
+            return false;
+        }
+        if (amtdb->format == OUTPUT_TEXT) {
+            printf("\nText search of '%'d' records for '%s' found '%d' matches.\n\n", amtdb->totalrec, args[0],
+                   rec_match);
+        }
+    } else if (strcmp(command, "l") == 0) {
+        if (!latest_acronym(amtdb)) {
+            return false;
+        }
+        if (amtdb->format == OUTPUT_TEXT) {
+            printf("\nLATEST DONE\n");
+        }
+    }
+
+    outbuf_footer();
+    return true;
+}
+
+
+/**
+ * @brief Send all of the output held in the reply file to the client, after the 'OK <bytes>' line.
+ * @return bool : false if it could not all be sent.
+ */
+static bool send_reply(int client, int reply)
+{
+    const off_t size = lseek(reply, 0, SEEK_END);
+    char buf[64 * 1024];
+    int len = snprintf(buf, sizeof(buf), "OK %lld\n", (long long)size);
+    if (size < 0 || !write_all(client, buf, (size_t)len)) {
+        return false;
+    }
+
+    for (off_t pos = 0; pos < size;) {
+        ssize_t got = pread(reply, buf, sizeof(buf), pos);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0 || !write_all(client, buf, (size_t)got)) {
+            return false;
+        }
+        pos += got;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Read a request from a client connection, and send the reply.
+ * @param int client : the client connection.
+ * @param const char *served_db : the real path of the database being served.
+ * @param int reply : a temporary file the output of the command is written to, before it is sent.
+ * @param int saved_stdout : a copy of the server's own stdout, restored after the command has run.
+ * @return bool : true if the request was answered.
+ */
+static bool serve_client(int client, const char *served_db, int reply, int saved_stdout, amtdb_struct *amtdb)
+{
+    char request[AMT_SERVE_MAX_REQUEST + 1];
+    size_t used = 0;
+    char *end = NULL;
+
+    while (end == NULL && used < AMT_SERVE_MAX_REQUEST) {
+        ssize_t got = read(client, request + used, AMT_SERVE_MAX_REQUEST - used);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        request[used + (size_t)got] = '\0';
+        end = strchr(request + used, '\n');
+        used += (size_t)got;
+    }
+    if (end == NULL) {
+        write_all(client, "ERR request too long\n", 21);
+        return false;
+    }
+    *end = '\0';
+
+    /** @note fields: database, format, command, then the command's arguments */
+    char *fields[AMT_SERVE_MAX_REQUEST / 2];
+    int nfields = 0;
+    for (char *pos = request; pos != NULL && nfields < (int)(sizeof(fields) / sizeof(fields[0]));) {
+        fields[nfields++] = pos;
+        pos = strchr(pos, '\t');
+        if (pos != NULL) {
+            *pos++ = '\0';
+        }
+    }
+
+    /** @note only answer for the same database the client would open, or it would get the wrong results. The
+     * client sends the full path, as a relative one would be found from the server's working directory
+     */
+    const bool same_db = (nfields >= 3 && strcmp(fields[0], served_db) == 0);
+
+    output_format format = OUTPUT_TEXT;
+    bool known = false;
+    for (size_t i = 0; nfields >= 3 && i < sizeof(serve_commands) / sizeof(serve_commands[0]); i++) {
+        known = known || strcmp(fields[2], serve_commands[i]) == 0;
+    }
+    const int nargs = nfields - 3;
+
+    const char *error = NULL;
+    if (!same_db) {
+        error = "ERR not serving that database\n";
+    } else if (!outbuf_parse_format(fields[1], &format)) {
+        error = "ERR unknown format\n";
+    } else if (!known || (strcmp(fields[2], "l") != 0 && strcmp(fields[2], "m") != 0 && nargs < 1)) {
+        error = "ERR unknown request\n";
+    }
+    if (error != NULL) {
+        write_all(client, error, strlen(error));
+        return false;
+    }
+
+    /** @note other programs may have changed the database since the last request */
+    if (!amtdb->meta_OK || !read_db_meta(amtdb)) {
+        set_record_count(amtdb);
+    }
+
+    /** @note the whole output is gathered first, so a failed command is answered 'ERR' and none of it is sent */
+    if (ftruncate(reply, 0) != 0 || lseek(reply, 0, SEEK_SET) != 0) {
+        write_all(client, "ERR server unable to hold the output\n", 37);
+        return false;
+    }
+    fflush(stdout);
+    dup2(reply, STDOUT_FILENO);
+    amtdb->format = format;
+    outbuf_set_format(format);
+
+    const bool done = serve_command(fields[2], &fields[3], nargs, amtdb);
+
+    fflush(stdout);
+    outbuf_flush();
+    dup2(saved_stdout, STDOUT_FILENO);
+
+    if (!done) {
+        write_all(client, "ERR command failed\n", 19);
+        return false;
+    }
+    return send_reply(client, reply);
+}
+
+
+/**
+ * @brief Answer search requests sent to a UNIX domain socket until stopped with SIGINT or SIGTERM.
+ * @param const char *path : the socket to listen on, or NULL for the one given by 'default_socket_path()'.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : false if the server could not be started.
+ * @note Requests are answered one at a time, each in a few milliseconds or less, so a single thread is used. A
+ * stale socket file left by a server that has stopped is replaced. The socket is created readable and writable by
+ * the owner only; use 'chmod' to let others use it.
+ */
+bool do_serve(const char *path, amtdb_struct *amtdb)
+{
+    char default_path[PATH_MAX];
+    struct sockaddr_un addr;
+
+    if (path == NULL) {
+        if (!default_socket_path(default_path, sizeof(default_path))) {
+            fprintf(stderr, "ERROR: the default socket path is too long.\n");
+            return false;
+        }
+        path = default_path;
+    }
+    if (!socket_address(path, &addr)) {
+        fprintf(stderr, "ERROR: the socket path '%s' is too long.\n", path);
+        return false;
+    }
+
+    char *served_db = realpath(amtdb->dbfile, NULL);
+    if (served_db == NULL) {
+        fprintf(stderr, "ERROR: unable to find the full path of '%s': %s\n", amtdb->dbfile, strerror(errno));
+        return false;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        perror("ERROR: unable to create the server socket");
+        free(served_db);
+        return false;
+    }
+
+    int rc = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    if (rc == -1 && errno == EADDRINUSE) {
+        /** @note the socket file exists: replace it only if no server is answering on it */
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool live = (probe != -1 && connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+        if (probe != -1) {
+            close(probe);
+        }
+        if (live) {
+            fprintf(stderr, "ERROR: a server is already running on '%s'.\n", path);
+            close(fd);
+            free(served_db);
+            return false;
+        }
+        unlink(path);
+        rc = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    }
+    if (rc == -1 || chmod(path, S_IRUSR | S_IWUSR) == -1 || listen(fd, SOMAXCONN) == -1) {
+        fprintf(stderr, "ERROR: unable to listen on '%s': %s\n", path, strerror(errno));
+        close(fd);
+        free(served_db);
+        return false;
+    }
+
+    /** @note no 'SA_RESTART', so a signal interrupts 'accept()' and the loop can end */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = serve_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    /* a client that goes away early must not stop the server */
+    signal(SIGPIPE, SIG_IGN);
+
+    /** @note do any one off index creation now, rather than during a client's first search where it could take
+     * longer than the client waits for
+     */
+    ensure_search_index(amtdb);
+    ensure_fts_index(amtdb);
+    ensure_fuzzy_index(amtdb);
+
+    printf("\nServing '%s' on '%s'. Press 'Ctrl + c' to stop.\n", served_db, path);
+    fflush(stdout);
+
+    int saved_stdout = dup(STDOUT_FILENO);
+    FILE *reply = tmpfile();
+    if (reply == NULL) {
+        fprintf(stderr, "ERROR: unable to create a temporary file for replies: %s\n", strerror(errno));
+        close(fd);
+        unlink(path);
+        close(saved_stdout);
+        free(served_db);
+        return false;
+    }
+    long served = 0;
+
+    while (!serve_stop) {
+        int client = accept(fd, NULL, NULL);
+        if (client == -1) {
+            if (errno != EINTR) {
+                perror("WARNING: unable to accept a connection");
+            }
+            continue;
+        }
+        set_socket_timeout(client);
+        if (serve_client(client, served_db, fileno(reply), saved_stdout, amtdb)) {
+            served++;
+        }
+        close(client);
+    }
+
+    close(fd);
+    unlink(path);
+    close(saved_stdout);
+    fclose(reply);
+    free(served_db);
+
+    printf("\nServer stopped after answering '%'ld' requests.\n", served);
+    return true;
+}
+
+
+/**
+ * @brief Get the user id of the process at the other end of a UNIX domain socket connection.
+ * @return bool : false if it can not be found.
+ */
+static bool peer_uid(int fd, uid_t *uid)
+{
+#if defined(__linux__)
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) {
+        return false;
+    }
+    *uid = cred.uid;
+    return true;
+#else
+    gid_t gid;
+    return getpeereid(fd, uid, &gid) == 0;
+#endif
+}
+
+
+/**
+ * @brief Check a server socket, and the server answering on it, can be trusted to give the users own results.
+ * @param const char *path : the socket path, which must be a socket owned by the user, or by root if 'allow_root'.
+ * @param int fd : the connection to the server, which must be run by the same user, or by root if 'allow_root'.
+ * @param bool allow_root : true only for the system wide socket, '/run/amt.sock'.
+ * @return bool : true if both belong to the user, or root where allowed.
+ */
+static bool server_trusted(const char *path, int fd, bool allow_root)
+{
+    const uid_t me = getuid();
+    struct stat sb;
+    uid_t server;
+
+    if (lstat(path, &sb) != 0 || !S_ISSOCK(sb.st_mode) || (sb.st_uid != me && !(allow_root && sb.st_uid == 0))) {
+        return false;
+    }
+    if (!peer_uid(fd, &server) || (server != me && !(allow_root && server == 0))) {
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * @brief Connect to a running server on the first socket found of: '$AMT_SOCKET', the default socket, or
+ * '/run/amt.sock'. Setting 'AMT_SOCKET' to an empty value turns off the use of a server.
+ * @return int : the connected socket, or '-1' if no server is running.
+ * @note Any user can create a socket in '/tmp' or '/run' before a server does, and answer with made up results.
+ * So a socket, and the server answering on it, must belong to the user, or to root for '/run/amt.sock' only.
+ */
+static int connect_server(void)
+{
+    char default_path[PATH_MAX];
+    const char *paths[3];
+    int npaths = 0;
+
+    const char *env = getenv("AMT_SOCKET");
+    if (env != NULL) {
+        if (env[0] == '\0') {
+            return -1;
+        }
+        paths[npaths++] = env;
+    }
+    if (default_socket_path(default_path, sizeof(default_path))) {
+        paths[npaths++] = default_path;
+    }
+    paths[npaths++] = AMT_SERVE_SYSTEM_SOCKET;
+
+    for (int i = 0; i < npaths; i++) {
+        struct sockaddr_un addr;
+        if (!socket_address(paths[i], &addr)) {
+            continue;
+        }
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd == -1) {
+            return -1;
+        }
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            if (server_trusted(paths[i], fd, strcmp(paths[i], AMT_SERVE_SYSTEM_SOCKET) == 0)) {
+                set_socket_timeout(fd);
+                return fd;
+            }
+            fprintf(stderr, "WARNING: not using the server on '%s' as it is not run by you.\n", paths[i]);
+        }
+        close(fd);
+    }
+    return -1;
+}
+
+
+/**
+ * @brief Send a command to a running server, and copy its output to stdout.
+ * @param const char *command : 's' to search for acronyms, 't' for a text search, or 'l' for the latest records.
+ * @param char **args : the arguments of the command.
+ * @param int nargs : the number of arguments.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information, giving the
+ * output format wanted and the program name used to find the database.
+ * @return bool : true if the server answered in full. When false nothing has been output, and the command should
+ * be run directly instead.
+ * @note This avoids opening the database at all, so a search is answered in well under a millisecond. If the server
+ * stops part way through its reply a warning is shown, and the command run directly gives its output.
+ */
+bool serve_forward(const char *command, char **args, int nargs, amtdb_struct *amtdb)
+{
+    /** @note the server is sent the full path of the database, so it can tell if it is the one it has open */
+    char *dbpath = find_db_path(amtdb->prog_name);
+    if (dbpath == NULL) {
+        return false;
+    }
+    int fd = connect_server();
+    if (fd == -1) {
+        free(dbpath);
+        return false;
+    }
+
+    /** @note build the request, leaving the search to be run directly if it can not be sent as one line */
+    char request[AMT_SERVE_MAX_REQUEST];
+    int len = snprintf(request, sizeof(request), "%s\t%s\t%s", dbpath, outbuf_format_name(amtdb->format), command);
+    const bool bad_path = (strpbrk(dbpath, "\t\n") != NULL);
+    free(dbpath);
+    for (int i = 0; i < nargs && len > 0 && (size_t)len < sizeof(request); i++) {
+        if (strpbrk(args[i], "\t\n") != NULL) {
+            len = -1;
+            break;
+        }
+        len += snprintf(request + len, sizeof(request) - (size_t)len, "\t%s", args[i]);
+    }
+    if (len < 0 || (size_t)len + 1 >= sizeof(request) || bad_path) {
+        close(fd);
+        return false;
+    }
+    request[len++] = '\n';
+
+    if (!write_all(fd, request, (size_t)len)) {
+        close(fd);
+        return false;
+    }
+
+    /** @note the reply starts 'OK <bytes>' or 'ERR'. Anything read after the 'OK' line is the start of the output */
+    char reply[64 * 1024];
+    size_t used = 0;
+    char *eol = NULL;
+    while (eol == NULL && used < sizeof(reply)) {
+        ssize_t got = read(fd, reply + used, sizeof(reply) - used);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            break;
+        }
+        eol = memchr(reply + used, '\n', (size_t)got);
+        used += (size_t)got;
+    }
+    char *end = NULL;
+    const long long size = (eol != NULL && strncmp(reply, "OK ", 3) == 0) ? strtoll(reply + 3, &end, 10) : -1;
+    if (size < 0 || end != eol) {
+#if DEBUG
+        fprintf(stderr, "DEBUG: server did not answer the request: '%.*s'\n", (int)used, reply);
+#endif
+        close(fd);
+        return false;
+    }
+
+    /** @note all the output is read before any is written, so if the server stops part way the command can still
+     * be run directly without repeating any output
+     */
+    const size_t start = (size_t)(eol + 1 - reply);
+    const size_t total = (size_t)size;
+    char *output = malloc(total + 1);
+    size_t have = (used - start < total) ? used - start : total;
+    if (output != NULL) {
+        memcpy(output, reply + start, have);
+    }
+    while (output != NULL && have < total) {
+        ssize_t got = read(fd, output + have, total - have);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        /** @note an early end, a read error or a timeout means the output is not complete */
+        if (got <= 0) {
+            break;
+        }
+        have += (size_t)got;
+    }
+    close(fd);
+
+    if (output == NULL || have < total) {
+        fprintf(stderr, "\nWARNING: the server did not send all of its reply. Running the command directly.\n");
+        free(output);
+        return false;
+    }
+
+    fflush(stdout);
+    write_all(STDOUT_FILENO, output, total);
+    free(output);
+    return true;
+}
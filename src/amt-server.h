@@ -0,0 +1,28 @@
+/**
+ * @file amt-server.h
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ *
+ * @author     simon rowe <simon@wiremoons.com>
+ * @license    open-source released under "MIT License"
+ * @source     https://github.com/wiremoons/acroman
+ *
+ */
+
+#ifndef AMT_AMT_SERVER_H /* Include guard */
+#define AMT_AMT_SERVER_H
+
+#include "types.h"      /** @note Programs own structure to manage SQLite database information */
+#include "sqlite3.h"    /** @note SQLite database C amalgamation header */
+#include <stdbool.h>    /** @note use of true / false booleans for declarations below*/
+#include <stddef.h>     /** @note size_t */
+
+#define AMT_SERVE_SOCKET_NAME "amt.sock"          /** @note socket file name used in '$XDG_RUNTIME_DIR' */
+#define AMT_SERVE_SYSTEM_SOCKET "/run/amt.sock" /** @note system wide socket, which may be run by root */
+#define AMT_SERVE_MAX_REQUEST 4096                /** @note longest request line a client may send */
+#define AMT_SERVE_TIMEOUT_SECS 5                  /** @note time allowed for a client to send or accept data */
+
+bool default_socket_path(char *path, size_t size);                /* socket used when none is given */
+bool do_serve(const char *path, amtdb_struct *amtdb);             /* answer searches sent to a UNIX socket */
+bool serve_forward(const char *command, char **args, int nargs, amtdb_struct *amtdb); /* ask a running server */
+
+#endif // AMT_AMT_SERVER_H
@@ -0,0 +1,439 @@
+/**
+ * @file amt-shell.c
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ * @details Program to managed SQLite database containing acronyms. This source code manages the interactive shell,
+ * where the user runs many commands against the database in one session.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note The database is opened and checked once when the shell starts, and the prepared statements are kept between
+ * commands, so each command only costs the time taken to run its own queries. Commands are read with linenoise, and
+ * are saved to a history file in the users home directory so they can be recalled in later sessions. The linenoise
+ * history is a circular buffer, so a history of many thousands of commands costs nothing extra to add to.
+ */
+
+#include "amt-shell.h"
+#include "amt-db-funcs.h"
+#include "amt-fuzzy.h"
+#include "amt-hints.h"
+#include "amt-memstats.h"
+#include "amt-output.h"
+#include "linenoise.h"
+
+/* added to enable compile on macOS */
+#ifndef __clang__
+#include <malloc.h> /* free for use with linenoise */
+#endif
+
+#include <limits.h>  /* PATH_MAX */
+#include <stdio.h>   /* printf snprintf */
+#include <stdlib.h>  /* getenv strtol */
+#include <string.h>  /* strcmp strspn strcspn strrchr */
+
+/** @note the parts of a command line typed by the user */
+typedef struct {
+    char *argv[AMT_SHELL_MAX_ARGS]; /* the command name followed by its arguments */
+    int argc;                       /* number of entries in 'argv' */
+    const char *rest;               /* the text following the command name, as typed */
+} shell_line;
+
+/** @note a command the shell understands */
+typedef struct {
+    const char *name;                                        /* full name of the command */
+    const char *alias;                                       /* short name, matching the command line option */
+    const char *usage;                                       /* arguments and description shown by 'help' */
+    bool (*run)(const shell_line *line, amtdb_struct *amtdb); /* returns false when the shell should end */
+} shell_command;
+
+/** @note path of the command history file, or empty if there is no home directory to keep it in */
+static char history_path[PATH_MAX] = "";
+
+
+/** @note the command history, held here while the record prompts of a command use a history of their own */
+static linenoiseHistoryState parked_history;
+
+
+/**
+ * @brief Keep the shell's command history out of the way while a command prompts for record fields.
+ * @note The record prompts fill the linenoise history with their own entries for the user to recall, so the
+ * command history is swapped out in memory, and swapped back by 'shell_history_restore()' afterwards.
+ */
+static void shell_history_park(void)
+{
+    linenoiseHistorySwap(&parked_history);
+}
+
+
+/**
+ * @brief Put back the command history saved by 'shell_history_park()', dropping the record prompt entries.
+ */
+static void shell_history_restore(void)
+{
+    linenoiseHistoryClear();
+    linenoiseHistorySwap(&parked_history);
+}
+
+
+/**
+ * @brief Get a record ID from the first argument of a command, checking it is in range.
+ * @return int : the record ID, or '0' if it is missing or not valid.
+ */
+static int shell_record_id(const shell_line *line, amtdb_struct *amtdb)
+{
+    if (line->argc < 2) {
+        fprintf(stderr, "ERROR: please provide the record ID for '%s'.\n", line->argv[0]);
+        return 0;
+    }
+
+    update_max_recid(amtdb);
+    const long record_ID = strtol(line->argv[1], NULL, 10);
+    if (record_ID <= 0 || record_ID > amtdb->maxrecid) {
+        fprintf(stderr, "ERROR: invalid record ID '%s' - out of range.\n", line->argv[1]);
+        return 0;
+    }
+    return (int)record_ID;
+}
+
+
+static bool shell_search(const shell_line *line, amtdb_struct *amtdb)
+{
+    if (line->argc < 2) {
+        fprintf(stderr, "ERROR: please provide an acronym to search for.\n");
+        return true;
+    }
+
+    set_record_count(amtdb);
+    outbuf_header();
+    if (line->argc > 2) {
+        do_batch_search(NULL, (char **)&line->argv[1], line->argc - 1, amtdb);
+    } else {
+        const int rec_match = do_acronym_search(line->argv[1], amtdb);
+        if (rec_match >= 0 && amtdb->format == OUTPUT_TEXT) {
+            printf("\nSearch of '%'d' records for '%s' found '%d' matches.\n\n", amtdb->totalrec, line->argv[1],
+                   rec_match);
+            if (rec_match == 0) {
+                do_fuzzy_suggest(line->argv[1], amtdb);
+            }
+        }
+    }
+    outbuf_footer();
+    return true;
+}
+
+
+static bool shell_text(const shell_line *line, amtdb_struct *amtdb)
+{
+    if (line->rest[0] == '\0') {
+        fprintf(stderr, "ERROR: please provide the words to search for.\n");
+        return true;
+    }
+
+    /** @note the words are searched for as typed, so quotes and spacing are kept for the FTS query */
+    char *words = strdup(line->rest);
+    if (words == NULL) {
+        fprintf(stderr, "ERROR: unable to allocate memory for the text search.\n");
+        return true;
+    }
+
+    set_record_count(amtdb);
+    outbuf_header();
+    const int rec_match = do_text_search(words, amtdb);
+    if (rec_match >= 0 && amtdb->format == OUTPUT_TEXT) {
+        printf("\nText search of '%'d' records for '%s' found '%d' matches.\n\n", amtdb->totalrec, words,
+               rec_match);
+    }
+    outbuf_footer();
+    free(words);
+    return true;
+}
+
+
+static bool shell_latest(const shell_line *line, amtdb_struct *amtdb)
+{
+    (void)line;
+    outbuf_header();
+    latest_acronym(amtdb);
+    outbuf_footer();
+    return true;
+}
+
+
+static bool shell_new(const shell_line *line, amtdb_struct *amtdb)
+{
+    (void)line;
+    shell_history_park();
+    if (!new_acronym(amtdb)) {
+        fprintf(stderr, "ERROR: failed to complete adding new record.\n");
+    }
+    shell_history_restore();
+    return true;
+}
+
+
+static bool shell_update(const shell_line *line, amtdb_struct *amtdb)
+{
+    const int record_ID = shell_record_id(line, amtdb);
+    if (record_ID > 0) {
+        shell_history_park();
+        if (!update_acronym_record(record_ID, amtdb)) {
+            fprintf(stderr, "ERROR: failed to complete updating the record.\n");
+        }
+        shell_history_restore();
+    }
+    return true;
+}
+
+
+static bool shell_delete(const shell_line *line, amtdb_struct *amtdb)
+{
+    const int record_ID = shell_record_id(line, amtdb);
+    if (record_ID > 0) {
+        shell_history_park();
+        if (!delete_acronym_record(record_ID, amtdb)) {
+            fprintf(stderr, "ERROR: failed to complete deleting the record.\n");
+        }
+        shell_history_restore();
+    }
+    return true;
+}
+
+
+static bool shell_memory(const shell_line *line, amtdb_struct *amtdb)
+{
+    (void)line;
+    output_mem_stats(amtdb, stdout);
+    return true;
+}
+
+
+static bool shell_help(const shell_line *line, amtdb_struct *amtdb);
+
+
+static bool shell_quit(const shell_line *line, amtdb_struct *amtdb)
+{
+    (void)line;
+    (void)amtdb;
+    return false;
+}
+
+
+/** @note every command the shell understands, in the order shown by 'help' */
+static const shell_command shell_commands[] = {
+    {"search", "s", "<acronym> ...  search for one or more acronyms.", shell_search},
+    {"text", "t", "<words>         search the definitions and descriptions.", shell_text},
+    {"latest", "l", "                list the five newest acronyms.", shell_latest},
+    {"new", "n", "                add a new acronym record.", shell_new},
+    {"update", "u", "<record_ID>     update an acronym record.", shell_update},
+    {"delete", "d", "<record_ID>     delete an acronym record.", shell_delete},
+    {"memory", "m", "                show the memory used by SQLite and amt.", shell_memory},
+    {"help", "h", "                show this help.", shell_help},
+    {"quit", "q", "                leave the shell. 'Ctrl + d' also works.", shell_quit},
+};
+
+#define SHELL_COMMAND_COUNT (sizeof(shell_commands) / sizeof(shell_commands[0]))
+
+
+static bool shell_help(const shell_line *line, amtdb_struct *amtdb)
+{
+    (void)line;
+    (void)amtdb;
+    printf("\nCommands:\n\n");
+    for (size_t i = 0; i < SHELL_COMMAND_COUNT; i++) {
+        printf("    %-8s %s  %s\n", shell_commands[i].name, shell_commands[i].alias, shell_commands[i].usage);
+    }
+    printf("\nA line that is not a command is searched for as an acronym.\n\n");
+    return true;
+}
+
+
+/**
+ * @brief Find the command with the given name or alias.
+ * @return const shell_command* : the command, or NULL if 'name' is not a command.
+ */
+static const shell_command *find_shell_command(const char *name, size_t len)
+{
+    for (size_t i = 0; i < SHELL_COMMAND_COUNT; i++) {
+        if ((strlen(shell_commands[i].name) == len && strncmp(name, shell_commands[i].name, len) == 0) ||
+            (strlen(shell_commands[i].alias) == len && strncmp(name, shell_commands[i].alias, len) == 0)) {
+            return &shell_commands[i];
+        }
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief linenoise hints callback for the shell prompt. Shows the first acronym matching the word being typed, when
+ * it is for a search.
+ * @return char* : the hint to show after the cursor, or NULL for none.
+ */
+static char *shell_hint(const char *buf, int *color, int *bold)
+{
+    const size_t first = strcspn(buf, " \t");
+    const char *word = strrchr(buf, ' ');
+    word = (word != NULL) ? word + 1 : buf;
+
+    /** @note a word after the command name is only an acronym for 'search', and a command name is not one */
+    if (buf[first] != '\0') {
+        const shell_command *command = find_shell_command(buf, first);
+        if (command == NULL || command->run != shell_search) {
+            return NULL;
+        }
+    } else if (find_shell_command(buf, first) != NULL) {
+        return NULL;
+    }
+    return acronym_hint(word, color, bold);
+}
+
+
+/**
+ * @brief linenoise completion callback for the shell prompt. Completes the command name, and acronyms being
+ * searched for. Each press of 'tab' shows the next match.
+ */
+static void shell_completion(const char *buf, linenoiseCompletions *lc)
+{
+    const char *found[AMT_HINTS_MAX_COMPLETE];
+    const size_t first = strcspn(buf, " \t");
+    const char *word = strrchr(buf, ' ');
+    word = (word != NULL) ? word + 1 : buf;
+
+    if (buf[first] == '\0') {
+        /** @note the first word may be a command, or an acronym to search for */
+        for (size_t i = 0; i < SHELL_COMMAND_COUNT; i++) {
+            if (first > 0 && strncmp(shell_commands[i].name, buf, first) == 0) {
+                linenoiseAddCompletion(lc, shell_commands[i].name);
+            }
+        }
+    } else {
+        const shell_command *command = find_shell_command(buf, first);
+        if (command == NULL || command->run != shell_search) {
+            return;
+        }
+    }
+
+    /** @note a completion replaces the whole line, so each acronym is added to the words before it */
+    char line[AMT_SHELL_MAX_LINE];
+    const int keep = (int)(word - buf);
+    const size_t count = hints_complete(word, found, AMT_HINTS_MAX_COMPLETE);
+    for (size_t i = 0; i < count; i++) {
+        const int len = snprintf(line, sizeof(line), "%.*s%s", keep, buf, found[i]);
+        if (len > 0 && (size_t)len < sizeof(line)) {
+            linenoiseAddCompletion(lc, line);
+        }
+    }
+}
+
+
+/**
+ * @brief Split a command line into its words, in place.
+ * @param char *text : the line typed by the user. Spaces after each word are replaced by nul characters.
+ * @param shell_line *line : set to the words found, and the text following the first word.
+ * @return bool : false if the line has too many words.
+ */
+static bool split_shell_line(char *text, shell_line *line)
+{
+    const char *const blanks = " \t";
+
+    line->argc = 0;
+    line->rest = "";
+
+    char *pos = text + strspn(text, blanks);
+    while (*pos != '\0') {
+        if (line->argc == AMT_SHELL_MAX_ARGS) {
+            return false;
+        }
+        line->argv[line->argc++] = pos;
+        pos += strcspn(pos, blanks);
+        if (*pos != '\0') {
+            *pos++ = '\0';
+            pos += strspn(pos, blanks);
+        }
+        /** @note keep the text after the command name before any more of it is split */
+        if (line->argc == 1) {
+            line->rest = pos;
+            if (strcmp(line->argv[0], "text") == 0 || strcmp(line->argv[0], "t") == 0) {
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief Run commands typed by the user against the open database, until they quit.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : success status for functions execution.
+ * @note Any line that is not a command is searched for as an acronym, as it is on the command line.
+ */
+bool do_shell(amtdb_struct *amtdb)
+{
+    const char *home = getenv("HOME");
+    if (home != NULL && home[0] != '\0') {
+        const int len = snprintf(history_path, sizeof(history_path), "%s/%s", home, AMT_SHELL_HISTORY_FILE);
+        if (len < 0 || (size_t)len >= sizeof(history_path)) {
+            history_path[0] = '\0';
+        }
+    }
+
+    linenoise_initialise();
+    if (history_path[0] != '\0') {
+        linenoiseHistoryLoad(history_path);
+    }
+
+    /** @note build any missing indexes now, so the first search is as quick as the rest */
+    ensure_search_index(amtdb);
+    ensure_fuzzy_index(amtdb);
+    hints_load(amtdb);
+    set_record_count(amtdb);
+
+    printf("\nShell for '%'d' records in '%s'. Type 'help' for the commands, or 'quit' to leave.\n\n",
+           amtdb->totalrec, amtdb->dbfile);
+
+    bool running = true;
+    char *text = NULL;
+    while (running) {
+        /** @note set each time, as the record prompts of the commands change them */
+        linenoiseSetHintsCallback(shell_hint);
+        linenoiseSetCompletionCallback(shell_completion);
+        if ((text = linenoise(AMT_SHELL_PROMPT)) == NULL) {
+            break;
+        }
+        shell_line line;
+        char *first = text + strspn(text, " \t");
+
+        if (*first != '\0') {
+            linenoiseHistoryAdd(text);
+        }
+
+        const shell_command *command = find_shell_command(first, strcspn(first, " \t"));
+        if (*first == '\0') {
+            /** @note nothing typed */
+        } else if (command == NULL) {
+            /** @note not a command, so search for the whole line as one acronym, as 'amt -s "<line>"' does */
+            size_t len = strlen(first);
+            while (len > 0 && (first[len - 1] == ' ' || first[len - 1] == '\t')) {
+                first[--len] = '\0';
+            }
+            line.argv[0] = "search";
+            line.argv[1] = first;
+            line.argc = 2;
+            line.rest = first;
+            running = shell_search(&line, amtdb);
+        } else if (!split_shell_line(text, &line)) {
+            fprintf(stderr, "ERROR: too many words - at most '%d' are allowed.\n", AMT_SHELL_MAX_ARGS);
+        } else {
+            running = command->run(&line, amtdb);
+        }
+
+        fflush(stdout);
+        linenoiseFree(text);
+    }
+
+    if (history_path[0] != '\0' && linenoiseHistorySave(history_path) != 0) {
+        fprintf(stderr, "WARNING: unable to save the command history to '%s'.\n", history_path);
+    }
+
+    return true;
+}
@@ -0,0 +1,25 @@
+/**
+ * @file amt-shell.h
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ *
+ * @author     simon rowe <simon@wiremoons.com>
+ * @license    open-source released under "MIT License"
+ * @source     https://github.com/wiremoons/acroman
+ *
+ */
+
+#ifndef AMT_AMT_SHELL_H /* Include guard */
+#define AMT_AMT_SHELL_H
+
+#include "types.h"      /** @note Programs own structure to manage SQLite database information */
+#include "sqlite3.h"    /** @note SQLite database C amalgamation header */
+#include <stdbool.h>    /** @note use of true / false booleans for declarations below*/
+
+#define AMT_SHELL_PROMPT "amt> "               /** @note prompt shown when waiting for a command */
+#define AMT_SHELL_HISTORY_FILE ".amt_history"  /** @note command history file kept in the users home directory */
+#define AMT_SHELL_MAX_ARGS 64                  /** @note most words a command may have */
+#define AMT_SHELL_MAX_LINE 4096                /** @note longest command line offered by tab completion */
+
+bool do_shell(amtdb_struct *amtdb); /* run commands typed by the user against the open database */
+
+#endif // AMT_AMT_SHELL_H
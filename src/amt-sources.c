@@ -0,0 +1,336 @@
+/**
+ * @file amt-sources.c
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ * @details Program to managed SQLite database containing acronyms. This source code manages the list of acronym
+ * sources offered when a record is entered.
+ * @See https://github.com/wiremoons/acroman
+ *
+ * @license MIT License
+ *
+ * @note Each distinct source and the number of records using it are kept in the 'ACRONYMS_SOURCES' table, which is
+ * maintained by triggers on 'ACRONYMS', so the list is read without scanning every record. It is held in memory in a
+ * sorted array. Pressing 'tab' at the source prompt finds the sources starting with what has been typed with a binary
+ * search, and offers them most used first, without a query for each key pressed.
+ */
+
+#include "amt-sources.h"
+#include "amt-db-funcs.h"
+
+/* added to enable compile on macOS */
+#ifndef __clang__
+#include <malloc.h> /* free for use with strdup and realloc */
+#endif
+
+#include <stdio.h>   /* fprintf */
+#include <stdlib.h>  /* realloc malloc free qsort */
+#include <string.h>  /* strcmp strdup */
+#include <strings.h> /* strcasecmp strncasecmp */
+
+/** @note a distinct source and the number of records that use it */
+typedef struct source_entry {
+    char *name;
+    int uses;
+    size_t rank; /* position when ordered most used first */
+} source_entry;
+
+/** @note the distinct sources ordered ignoring case, and the same sources ordered most used first */
+static source_entry *sources = NULL;
+static source_entry **ranked = NULL;
+static size_t nsources = 0;
+static size_t maxsources = 0;
+static bool sources_loaded = false;
+
+
+/**
+ * @brief Order two sources ignoring case, then by case.
+ */
+static int compare_source(const char *a, const char *b)
+{
+    int cmp = strcasecmp(a, b);
+    return (cmp != 0) ? cmp : strcmp(a, b);
+}
+
+
+static int compare_sources(const void *a, const void *b)
+{
+    return compare_source(((const source_entry *)a)->name, ((const source_entry *)b)->name);
+}
+
+
+/**
+ * @brief Order two sources most used first, then ignoring case.
+ */
+static int compare_uses(const void *a, const void *b)
+{
+    const source_entry *sa = *(source_entry *const *)a;
+    const source_entry *sb = *(source_entry *const *)b;
+
+    if (sa->uses != sb->uses) {
+        return (sa->uses > sb->uses) ? -1 : 1;
+    }
+    return compare_source(sa->name, sb->name);
+}
+
+
+/**
+ * @brief Find where a source is, or would be, in the sorted array.
+ * @return size_t : the index of the first source that does not come before 'source'.
+ */
+static size_t source_position(const char *source)
+{
+    size_t low = 0;
+    size_t high = nsources;
+
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (compare_source(sources[mid].name, source) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+
+/**
+ * @brief Make room for one more source.
+ * @return bool : false if memory could not be allocated.
+ */
+static bool sources_grow(void)
+{
+    if (nsources < maxsources) {
+        return true;
+    }
+    size_t newmax = maxsources ? maxsources * 2 : 64;
+    source_entry *grown = realloc(sources, newmax * sizeof(source_entry));
+    if (grown == NULL) {
+        return false;
+    }
+    sources = grown;
+    maxsources = newmax;
+    return true;
+}
+
+
+/**
+ * @brief Ensure the 'ACRONYMS_SOURCES' table and the triggers on 'ACRONYMS' that keep it up to date exist.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : true if the 'ACRONYMS_SOURCES' table is available for use.
+ * @note The table holds each distinct non empty source with the number of records using it, and a source is removed
+ * once no record uses it. It is seeded once with a full scan when first created; after that the triggers keep it
+ * current. Uses the following SQL to create the table:
+ * @code CREATE TABLE ACRONYMS_SOURCES (source TEXT PRIMARY KEY, uses INTEGER NOT NULL) WITHOUT ROWID;
+ */
+bool ensure_sources_table(amtdb_struct *amtdb)
+{
+    if (db_object_exists(amtdb, "table", "ACRONYMS_SOURCES")) {
+        return true;
+    }
+
+#if DEBUG
+    fprintf(stderr, "DEBUG: creating the 'ACRONYMS_SOURCES' table and its triggers\n");
+#endif
+
+    /** @note 'BEGIN IMMEDIATE' so two programs starting at once can not both seed the table */
+    int rc = sqlite3_exec(amtdb->db,
+                          "BEGIN IMMEDIATE;"
+                          "CREATE TABLE IF NOT EXISTS ACRONYMS_SOURCES ("
+                          "source TEXT PRIMARY KEY, uses INTEGER NOT NULL) WITHOUT ROWID;"
+                          "INSERT OR IGNORE INTO ACRONYMS_SOURCES(source, uses) "
+                          "SELECT Source, count(*) FROM ACRONYMS WHERE Source <> '' GROUP BY Source;"
+                          "CREATE TRIGGER IF NOT EXISTS amt_sources_ai AFTER INSERT ON ACRONYMS "
+                          "WHEN new.Source <> '' BEGIN "
+                          "INSERT OR IGNORE INTO ACRONYMS_SOURCES(source, uses) VALUES (new.Source, 0);"
+                          "UPDATE ACRONYMS_SOURCES SET uses = uses + 1 WHERE source = new.Source; END;"
+                          "CREATE TRIGGER IF NOT EXISTS amt_sources_ad AFTER DELETE ON ACRONYMS "
+                          "WHEN old.Source <> '' BEGIN "
+                          "UPDATE ACRONYMS_SOURCES SET uses = uses - 1 WHERE source = old.Source;"
+                          "DELETE FROM ACRONYMS_SOURCES WHERE source = old.Source AND uses <= 0; END;"
+                          "CREATE TRIGGER IF NOT EXISTS amt_sources_au AFTER UPDATE OF Source ON ACRONYMS "
+                          "WHEN old.Source IS NOT new.Source BEGIN "
+                          "UPDATE ACRONYMS_SOURCES SET uses = uses - 1 WHERE source = old.Source;"
+                          "DELETE FROM ACRONYMS_SOURCES WHERE source = old.Source AND uses <= 0;"
+                          "INSERT OR IGNORE INTO ACRONYMS_SOURCES(source, uses) "
+                          "SELECT new.Source, 0 WHERE new.Source <> '';"
+                          "UPDATE ACRONYMS_SOURCES SET uses = uses + 1 WHERE source = new.Source; END;"
+                          "COMMIT;",
+                          NULL, NULL, NULL);
+    if (rc != SQLITE_OK) {
+        /* not fatal - the sources can still be counted directly from the 'ACRONYMS' table */
+#if DEBUG
+        fprintf(stderr, "DEBUG: unable to create the 'ACRONYMS_SOURCES' table: %s\n", sqlite3_errmsg(amtdb->db));
+#endif
+        sqlite3_exec(amtdb->db, "ROLLBACK;", NULL, NULL, NULL);
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Load every distinct source in the database and how often each is used, if they are not already loaded.
+ * @param amtdb_struct *amtdb : Pointer to the structure to manage the apps SQLite database information.
+ * @return bool : success status for functions execution.
+ * @note Uses the following SQL, or 'select ifnull(Source,''), count(*) from ACRONYMS group by Source;' without
+ * 'ACRONYMS_SOURCES':
+ * @code select source, uses from ACRONYMS_SOURCES;
+ */
+bool sources_load(amtdb_struct *amtdb)
+{
+    if (sources_loaded) {
+        return true;
+    }
+
+    const amt_stmt_id id = ensure_sources_table(amtdb) ? AMT_STMT_SOURCE_LIST : AMT_STMT_SOURCE_COUNTS;
+    sqlite3_stmt *stmt = get_stmt(amtdb, id);
+    if (stmt == NULL) {
+        return false;
+    }
+
+    bool result = true;
+    while (result && step_stmt(amtdb, id) == SQLITE_ROW) {
+        const char *source = (const char *)sqlite3_column_text(stmt, 0);
+        if (source == NULL || source[0] == '\0') {
+            continue;
+        }
+        result = sources_grow() && (sources[nsources].name = strdup(source)) != NULL;
+        if (result) {
+            sources[nsources++].uses = sqlite3_column_int(stmt, 1);
+        }
+    }
+    release_stmt(amtdb, id);
+
+    if (result && nsources > 0) {
+        result = (ranked = malloc(nsources * sizeof(source_entry *))) != NULL;
+    }
+
+    if (!result) {
+        fprintf(stderr, "ERROR: unable to allocate memory for the list of sources.\n");
+        sources_free();
+        return false;
+    }
+
+    /** @note one order to find the sources starting with what is typed, and one to offer the most used first */
+    qsort(sources, nsources, sizeof(source_entry), compare_sources);
+    for (size_t i = 0; i < nsources; i++) {
+        ranked[i] = &sources[i];
+    }
+    qsort(ranked, nsources, sizeof(source_entry *), compare_uses);
+    for (size_t i = 0; i < nsources; i++) {
+        ranked[i]->rank = i;
+    }
+
+    sources_loaded = true;
+    return true;
+}
+
+
+/**
+ * @brief Get the number of distinct sources loaded by 'sources_load()'.
+ */
+size_t sources_count(void)
+{
+    return nsources;
+}
+
+
+/**
+ * @brief Find the sources starting with what has been typed, for tab completion.
+ * @param const char *prefix : the text typed so far. Case is ignored. If empty every source is found.
+ * @param const char **found : set to the sources found, most used first.
+ * @param int *uses : if not NULL, set to the number of records using each source found.
+ * @param size_t max : the most sources to return.
+ * @return size_t : the number of sources found.
+ * @note When more than 'max' sources match only the 'max' most used are returned. They are kept in order as they
+ * are found, so the work is in proportion to the number of matching sources.
+ */
+size_t sources_complete(const char *prefix, const char **found, int *uses, size_t max)
+{
+    const size_t len = strlen(prefix);
+    size_t count = 0;
+
+    if (len == 0) {
+        for (count = 0; count < nsources && count < max; count++) {
+            found[count] = ranked[count]->name;
+            if (uses != NULL) {
+                uses[count] = ranked[count]->uses;
+            }
+        }
+        return count;
+    }
+
+    const source_entry *best[AMT_SOURCES_MAX_COMPLETE];
+    if (max > AMT_SOURCES_MAX_COMPLETE) {
+        max = AMT_SOURCES_MAX_COMPLETE;
+    }
+
+    for (size_t i = source_position(prefix); i < nsources; i++) {
+        const source_entry *entry = &sources[i];
+        if (strncasecmp(entry->name, prefix, len) != 0) {
+            break;
+        }
+        if (count == max && entry->rank > best[count - 1]->rank) {
+            continue;
+        }
+        size_t pos = (count < max) ? count++ : count - 1;
+        while (pos > 0 && best[pos - 1]->rank > entry->rank) {
+            best[pos] = best[pos - 1];
+            pos--;
+        }
+        best[pos] = entry;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        found[i] = best[i]->name;
+        if (uses != NULL) {
+            uses[i] = best[i]->uses;
+        }
+    }
+    return count;
+}
+
+
+/**
+ * @brief linenoise completion callback for the source prompt. Each press of 'tab' shows the next source starting
+ * with what has been typed, most used first.
+ */
+void source_completion(const char *buf, linenoiseCompletions *lc)
+{
+    const char *found[AMT_SOURCES_MAX_COMPLETE];
+    const size_t count = sources_complete(buf, found, NULL, AMT_SOURCES_MAX_COMPLETE);
+
+    for (size_t i = 0; i < count; i++) {
+        linenoiseAddCompletion(lc, found[i]);
+    }
+}
+
+
+/**
+ * @brief Note that a record has been added, changed or deleted, so the sources and their counts may have changed.
+ * @note The triggers have already updated 'ACRONYMS_SOURCES', so the sources are read again from it by the next call
+ * to 'sources_load()'. That is only as many rows as there are distinct sources.
+ */
+void sources_changed(void)
+{
+    sources_free();
+}
+
+
+/**
+ * @brief Release the memory held by the sources. They are loaded again by the next call to 'sources_load()'.
+ */
+void sources_free(void)
+{
+    for (size_t i = 0; i < nsources; i++) {
+        free(sources[i].name);
+    }
+    free(sources);
+    free(ranked);
+    sources = NULL;
+    ranked = NULL;
+    nsources = 0;
+    maxsources = 0;
+    sources_loaded = false;
+}
@@ -0,0 +1,31 @@
+/**
+ * @file amt-sources.h
+ * @brief Acronym Management Tool (amt). A program to managed SQLite database containing acronyms.
+ *
+ * @author     simon rowe <simon@wiremoons.com>
+ * @license    open-source released under "MIT License"
+ * @source     https://github.com/wiremoons/acroman
+ *
+ */
+
+#ifndef AMT_AMT_SOURCES_H /* Include guard */
+#define AMT_AMT_SOURCES_H
+
+#include "types.h"      /** @note Programs own structure to manage SQLite database information */
+#include "sqlite3.h"    /** @note SQLite database C amalgamation header */
+#include <stdbool.h>    /** @note use of true / false booleans for declarations below*/
+#include <stddef.h>     /** @note size_t */
+#include "linenoise.h"  /** @note Linenoise library: readline replacement */
+
+#define AMT_SOURCES_MAX_COMPLETE 100 /** @note most sources offered in turn by pressing 'tab' */
+#define AMT_SOURCES_MAX_SHOWN 20     /** @note most used sources listed at the prompt */
+
+bool ensure_sources_table(amtdb_struct *amtdb);                      /* trigger maintained sources with counts */
+bool sources_load(amtdb_struct *amtdb);                              /* load every distinct source once */
+size_t sources_count(void);                                          /* number of distinct sources loaded */
+size_t sources_complete(const char *prefix, const char **found, int *uses, size_t max); /* most used first */
+void source_completion(const char *buf, linenoiseCompletions *lc);   /* linenoise tab completion of sources */
+void sources_changed(void);                                          /* reload the sources when next needed */
+void sources_free(void);                                             /* release the memory held by the sources */
+
+#endif // AMT_AMT_SOURCES_H
@@ -114,6 +114,8 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include "linenoise.h"
 
@@ -131,8 +133,23 @@ static int mlmode = 0;  /* Multi line mode. Default is single line. */
 static int atexit_registered = 0; /* Register atexit just 1 time. */
 static int history_max_len = LINENOISE_DEFAULT_HISTORY_MAX_LEN;
 static int history_len = 0;
+static int history_start = 0;
 static char **history = NULL;
 
+/* We define a very simple "append buffer" structure, that is an heap
+ * allocated string where we can append to. This is useful in order to
+ * write all the escape sequences in a buffer and flush them to the standard
+ * output in a single call, to avoid flickering effects. The buffer grows
+ * geometrically and is kept between refreshes, so redrawing a long line
+ * on every keystroke does not realloc for every piece appended. */
+struct abuf {
+    char *b;
+    int len;
+    int cap;
+};
+
+static struct abuf renderbuf; /* Render buffer shared by every edit. */
+
 /* The linenoiseState structure represents the state during line editing.
  * We pass this state to functions implementing specific editing
  * functionalities. */
@@ -149,6 +166,7 @@ struct linenoiseState {
     size_t cols;        /* Number of columns in terminal. */
     size_t maxrows;     /* Maximum num of rows used so far (multiline mode) */
     int history_index;  /* The history index we are currently editing. */
+    struct abuf *ab;    /* Render buffer, reused by every refresh. */
 };
 
 enum KEY_ACTION{
@@ -176,6 +194,8 @@ enum KEY_ACTION{
 static void linenoiseAtExit(void);
 int linenoiseHistoryAdd(const char *line);
 static void refreshLine(struct linenoiseState *l);
+static char **historySlot(int i);
+static void historyPopNewest(void);
 
 /* Debugging macro. */
 #if 0
@@ -458,31 +478,28 @@ void linenoiseAddCompletion(linenoiseCompletions *lc, const char *str) {
 
 /* =========================== Line editing ================================= */
 
-/* We define a very simple "append buffer" structure, that is an heap
- * allocated string where we can append to. This is useful in order to
- * write all the escape sequences in a buffer and flush them to the standard
- * output in a single call, to avoid flickering effects. */
-struct abuf {
-    char *b;
-    int len;
-};
-
-static void abInit(struct abuf *ab) {
-    ab->b = NULL;
+/* Start a new refresh in the buffer, keeping the memory it already has. */
+static void abReset(struct abuf *ab) {
     ab->len = 0;
 }
 
 static void abAppend(struct abuf *ab, const char *s, int len) {
-    char *new = realloc(ab->b,ab->len+len);
-
-    if (new == NULL) return;
-    memcpy(new+ab->len,s,len);
-    ab->b = new;
+    if (ab->len+len > ab->cap) {
+        int cap = ab->cap ? ab->cap : 256;
+        while (cap < ab->len+len) cap *= 2;
+        char *new = realloc(ab->b,cap);
+        if (new == NULL) return;
+        ab->b = new;
+        ab->cap = cap;
+    }
+    memcpy(ab->b+ab->len,s,len);
     ab->len += len;
 }
 
 static void abFree(struct abuf *ab) {
     free(ab->b);
+    ab->b = NULL;
+    ab->len = ab->cap = 0;
 }
 
 /* Helper of refreshSingleLine() and refreshMultiLine() to show hints
@@ -522,7 +539,7 @@ static void refreshSingleLine(struct linenoiseState *l) {
     char *buf = l->buf;
     size_t len = l->len;
     size_t pos = l->pos;
-    struct abuf ab;
+    struct abuf *ab = l->ab;
 
     while((plen+pos) >= l->cols) {
         buf++;
@@ -533,27 +550,26 @@ static void refreshSingleLine(struct linenoiseState *l) {
         len--;
     }
 
-    abInit(&ab);
+    abReset(ab);
     /* Cursor to left edge */
     snprintf(seq,64,"\r");
-    abAppend(&ab,seq,strlen(seq));
+    abAppend(ab,seq,strlen(seq));
     /* Write the prompt and the current buffer content */
-    abAppend(&ab,l->prompt,strlen(l->prompt));
+    abAppend(ab,l->prompt,strlen(l->prompt));
     if (maskmode == 1) {
-        while (len--) abAppend(&ab,"*",1);
+        while (len--) abAppend(ab,"*",1);
     } else {
-        abAppend(&ab,buf,len);
+        abAppend(ab,buf,len);
     }
     /* Show hits if any. */
-    refreshShowHints(&ab,l,plen);
+    refreshShowHints(ab,l,plen);
     /* Erase to right */
     snprintf(seq,64,"\x1b[0K");
-    abAppend(&ab,seq,strlen(seq));
+    abAppend(ab,seq,strlen(seq));
     /* Move cursor to original position. */
     snprintf(seq,64,"\r\x1b[%dC", (int)(pos+plen));
-    abAppend(&ab,seq,strlen(seq));
-    if (write(fd,ab.b,ab.len) == -1) {} /* Can't recover from write error. */
-    abFree(&ab);
+    abAppend(ab,seq,strlen(seq));
+    if (write(fd,ab->b,ab->len) == -1) {} /* Can't recover from write error. */
 }
 
 /* Multi line low level line refresh.
@@ -569,43 +585,43 @@ static void refreshMultiLine(struct linenoiseState *l) {
     int col; /* colum position, zero-based. */
     int old_rows = l->maxrows;
     int fd = l->ofd, j;
-    struct abuf ab;
+    struct abuf *ab = l->ab;
 
     /* Update maxrows if needed. */
     if (rows > (int)l->maxrows) l->maxrows = rows;
 
     /* First step: clear all the lines used before. To do so start by
      * going to the last row. */
-    abInit(&ab);
+    abReset(ab);
     if (old_rows-rpos > 0) {
         lndebug("go down %d", old_rows-rpos);
         snprintf(seq,64,"\x1b[%dB", old_rows-rpos);
-        abAppend(&ab,seq,strlen(seq));
+        abAppend(ab,seq,strlen(seq));
     }
 
     /* Now for every row clear it, go up. */
     for (j = 0; j < old_rows-1; j++) {
         lndebug("clear+up");
         snprintf(seq,64,"\r\x1b[0K\x1b[1A");
-        abAppend(&ab,seq,strlen(seq));
+        abAppend(ab,seq,strlen(seq));
     }
 
     /* Clean the top line. */
     lndebug("clear");
     snprintf(seq,64,"\r\x1b[0K");
-    abAppend(&ab,seq,strlen(seq));
+    abAppend(ab,seq,strlen(seq));
 
     /* Write the prompt and the current buffer content */
-    abAppend(&ab,l->prompt,strlen(l->prompt));
+    abAppend(ab,l->prompt,strlen(l->prompt));
     if (maskmode == 1) {
         unsigned int i;
-        for (i = 0; i < l->len; i++) abAppend(&ab,"*",1);
+        for (i = 0; i < l->len; i++) abAppend(ab,"*",1);
     } else {
-        abAppend(&ab,l->buf,l->len);
+        abAppend(ab,l->buf,l->len);
     }
 
     /* Show hits if any. */
-    refreshShowHints(&ab,l,plen);
+    refreshShowHints(ab,l,plen);
 
     /* If we are at the very end of the screen with our prompt, we need to
      * emit a newline and move the prompt to the first column. */
@@ -614,9 +630,9 @@ static void refreshMultiLine(struct linenoiseState *l) {
         (l->pos+plen) % l->cols == 0)
     {
         lndebug("<newline>");
-        abAppend(&ab,"\n",1);
+        abAppend(ab,"\n",1);
         snprintf(seq,64,"\r");
-        abAppend(&ab,seq,strlen(seq));
+        abAppend(ab,seq,strlen(seq));
         rows++;
         if (rows > (int)l->maxrows) l->maxrows = rows;
     }
@@ -629,7 +645,7 @@ static void refreshMultiLine(struct linenoiseState *l) {
     if (rows-rpos2 > 0) {
         lndebug("go-up %d", rows-rpos2);
         snprintf(seq,64,"\x1b[%dA", rows-rpos2);
-        abAppend(&ab,seq,strlen(seq));
+        abAppend(ab,seq,strlen(seq));
     }
 
     /* Set column. */
@@ -639,13 +655,12 @@ static void refreshMultiLine(struct linenoiseState *l) {
         snprintf(seq,64,"\r\x1b[%dC", col);
     else
         snprintf(seq,64,"\r");
-    abAppend(&ab,seq,strlen(seq));
+    abAppend(ab,seq,strlen(seq));
 
     lndebug("\n");
     l->oldpos = l->pos;
 
-    if (write(fd,ab.b,ab.len) == -1) {} /* Can't recover from write error. */
-    abFree(&ab);
+    if (write(fd,ab->b,ab->len) == -1) {} /* Can't recover from write error. */
 }
 
 /* Calls the two low level functions refreshSingleLine() or
@@ -667,10 +682,19 @@ int linenoiseEditInsert(struct linenoiseState *l, char c) {
             l->pos++;
             l->len++;
             l->buf[l->len] = '\0';
-            if ((!mlmode && l->plen+l->len < l->cols && !hintsCallback)) {
+            /* In multi line mode the cursor follows the character
+             * written unless it fills the last column of a row. */
+            int trivial = mlmode ? (l->plen+l->len) % l->cols != 0 :
+                                   l->plen+l->len < l->cols;
+            if (trivial && !hintsCallback) {
                 /* Avoid a full update of the line in the
                  * trivial case. */
                 char d = (maskmode==1) ? '*' : c;
+                if (mlmode) {
+                    size_t rows = (l->plen+l->len+l->cols-1)/l->cols;
+                    if (rows > l->maxrows) l->maxrows = rows;
+                    l->oldpos = l->pos;
+                }
                 if (write(l->ofd,&d,1) == -1) return -1;
             } else {
                 refreshLine(l);
@@ -727,8 +751,8 @@ void linenoiseEditHistoryNext(struct linenoiseState *l, int dir) {
     if (history_len > 1) {
         /* Update the current history entry before to
          * overwrite it with the next one. */
-        free(history[history_len - 1 - l->history_index]);
-        history[history_len - 1 - l->history_index] = strdup(l->buf);
+        free(*historySlot(history_len - 1 - l->history_index));
+        *historySlot(history_len - 1 - l->history_index) = strdup(l->buf);
         /* Show the new entry */
         l->history_index += (dir == LINENOISE_HISTORY_PREV) ? 1 : -1;
         if (l->history_index < 0) {
@@ -738,7 +762,7 @@ void linenoiseEditHistoryNext(struct linenoiseState *l, int dir) {
             l->history_index = history_len-1;
             return;
         }
-        strncpy(l->buf,history[history_len - 1 - l->history_index],l->buflen);
+        strncpy(l->buf,*historySlot(history_len - 1 - l->history_index),l->buflen);
         l->buf[l->buflen-1] = '\0';
         l->len = l->pos = strlen(l->buf);
         refreshLine(l);
@@ -808,6 +832,7 @@ static int linenoiseEdit(int stdin_fd, int stdout_fd, char *buf, size_t buflen,
     l.cols = getColumns(stdin_fd, stdout_fd);
     l.maxrows = 0;
     l.history_index = 0;
+    l.ab = &renderbuf;
 
     /* Buffer starts empty. */
     l.buf[0] = '\0';
@@ -839,8 +864,7 @@ static int linenoiseEdit(int stdin_fd, int stdout_fd, char *buf, size_t buflen,
 
         switch(c) {
         case ENTER:    /* enter */
-            history_len--;
-            free(history[history_len]);
+            historyPopNewest();
             if (mlmode) linenoiseEditMoveEnd(&l);
             if (hintsCallback) {
                 /* Force a refresh without hints to leave the previous
@@ -863,8 +887,7 @@ static int linenoiseEdit(int stdin_fd, int stdout_fd, char *buf, size_t buflen,
             if (l.len > 0) {
                 linenoiseEditDelete(&l);
             } else {
-                history_len--;
-                free(history[history_len]);
+                historyPopNewest();
                 return -1;
             }
             break;
@@ -1098,6 +1121,15 @@ void linenoiseFree(void *ptr) {
 
 /* ================================ History ================================= */
 
+/* The history is held in a circular buffer of 'history_max_len' entries.
+ * The oldest entry is at 'history_start', and entry 'i' counting from the
+ * oldest is at historySlot(i). Adding an entry to a full history replaces
+ * the oldest one in place, so it takes the same time however large the
+ * history is. */
+static char **historySlot(int i) {
+    return &history[(history_start + i) % history_max_len];
+}
+
 /* Free the history, but does not reset it. Only used when we have to
  * exit() to avoid memory leaks are reported by valgrind & co. */
 static void freeHistory(void) {
@@ -1105,51 +1137,84 @@ static void freeHistory(void) {
         int j;
 
         for (j = 0; j < history_len; j++)
-            free(history[j]);
+            free(*historySlot(j));
         free(history);
     }
 }
 
+/* Remove the newest entry from the history. */
+static void historyPopNewest(void) {
+    history_len--;
+    free(*historySlot(history_len));
+    *historySlot(history_len) = NULL;
+}
+
 /* At exit we'll try to fix the terminal to the initial conditions. */
 static void linenoiseAtExit(void) {
     disableRawMode(STDIN_FILENO);
     freeHistory();
+    abFree(&renderbuf);
+}
+
+/* Add an heap allocated line to the history, which takes ownership of it.
+ * If we reached the max length, the oldest line is replaced. */
+static int historyAddCopy(char *linecopy) {
+    if (history == NULL) {
+        history = calloc((size_t)history_max_len,sizeof(char*));
+        if (history == NULL) {
+            free(linecopy);
+            return 0;
+        }
+        history_start = 0;
+    }
+
+    if (history_len == history_max_len) {
+        free(*historySlot(0));
+        *historySlot(0) = linecopy;
+        history_start = (history_start + 1) % history_max_len;
+    } else {
+        *historySlot(history_len) = linecopy;
+        history_len++;
+    }
+    return 1;
 }
 
 /* This is the API call to add a new entry in the linenoise history.
- * It uses a fixed array of char pointers that are shifted (memmoved)
- * when the history max length is reached in order to remove the older
- * entry and make room for the new one, so it is not exactly suitable for huge
- * histories, but will work well for a few hundred of entries.
- *
- * Using a circular buffer is smarter, but a bit more complex to handle. */
+ * A line the same as the newest entry is not added. */
 int linenoiseHistoryAdd(const char *line) {
     char *linecopy;
 
     if (history_max_len == 0) return 0;
 
-    /* Initialization on first call. */
-    if (history == NULL) {
-        history = malloc(sizeof(char*)*history_max_len);
-        if (history == NULL) return 0;
-        memset(history,0,(sizeof(char*)*history_max_len));
-    }
-
     /* Don't add duplicated lines. */
-    if (history_len && !strcmp(history[history_len-1], line)) return 0;
+    if (history_len && !strcmp(*historySlot(history_len-1), line)) return 0;
 
-    /* Add an heap allocated copy of the line in the history.
-     * If we reached the max length, remove the older line. */
     linecopy = strdup(line);
     if (!linecopy) return 0;
-    if (history_len == history_max_len) {
-        free(history[0]);
-        memmove(history,history+1,sizeof(char*)*(history_max_len-1));
-        history_len--;
-    }
-    history[history_len] = linecopy;
-    history_len++;
-    return 1;
+    return historyAddCopy(linecopy);
+}
+
+/* Remove every entry from the history. The maximum length is unchanged. */
+void linenoiseHistoryClear(void) {
+    freeHistory();
+    history = NULL;
+    history_len = 0;
+    history_start = 0;
+}
+
+/* Swap the history in use with the one held in 'state', so a caller can
+ * give a prompt its own history and put the first one back afterwards,
+ * without copying either of them. A zeroed 'state' is taken to be an empty
+ * history of the current maximum length. */
+void linenoiseHistorySwap(linenoiseHistoryState *state) {
+    linenoiseHistoryState current = {history, history_max_len,
+                                     history_len, history_start};
+
+    history = state->history;
+    history_max_len = state->max_len > 0 ? state->max_len : history_max_len;
+    history_len = state->len;
+    history_start = state->start;
+    *state = current;
 }
 
 /* Set the maximum length for the history. This function can be called even
@@ -1161,65 +1226,208 @@ int linenoiseHistorySetMaxLen(int len) {
 
     if (len < 1) return 0;
     if (history) {
-        int tocopy = history_len;
+        int tocopy = history_len < len ? history_len : len;
+        int j;
 
-        new = malloc(sizeof(char*)*len);
+        new = calloc((size_t)len,sizeof(char*));
         if (new == NULL) return 0;
 
         /* If we can't copy everything, free the elements we'll not use. */
-        if (len < tocopy) {
-            int j;
+        for (j = 0; j < history_len-tocopy; j++) free(*historySlot(j));
 
-            for (j = 0; j < tocopy-len; j++) free(history[j]);
-            tocopy = len;
-        }
-        memset(new,0,sizeof(char*)*len);
-        memcpy(new,history+(history_len-tocopy), sizeof(char*)*tocopy);
+        /* Copy the rest oldest first, so the new buffer starts at zero. */
+        for (j = 0; j < tocopy; j++)
+            new[j] = *historySlot(history_len-tocopy+j);
         free(history);
         history = new;
+        history_start = 0;
+        history_len = tocopy;
     }
     history_max_len = len;
-    if (history_len > history_max_len)
-        history_len = history_max_len;
     return 1;
 }
 
+/* FNV-1a hash of a line, for finding duplicated lines. */
+static size_t historyHash(const char *line, size_t len) {
+    size_t hash = 2166136261u;
+    size_t j;
+
+    for (j = 0; j < len; j++) {
+        hash ^= (unsigned char)line[j];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* Mark in 'keep' the lines to hold in a history file: the newest copy of
+ * each different line, and at most 'max' of them, newest first. The lines
+ * are not nul terminated, and are given oldest first by 'lines' and 'lens'.
+ * Returns the number of lines kept, or -1 when out of memory. */
+static int historyDedup(const char **lines, const size_t *lens, int n,
+                        char *keep, int max) {
+    size_t size = 16, mask, slot;
+    int *table, kept = 0, j;
+
+    while (size < (size_t)n * 2) size *= 2;
+    mask = size - 1;
+    table = malloc(size * sizeof(int));
+    if (table == NULL) return -1;
+    memset(table,-1,size * sizeof(int));
+
+    for (j = n - 1; j >= 0; j--) {
+        keep[j] = 0;
+        if (kept == max || lens[j] == 0) continue;
+
+        /* Look for the line in the table of those already kept. */
+        slot = historyHash(lines[j],lens[j]) & mask;
+        while (table[slot] != -1 &&
+               (lens[table[slot]] != lens[j] ||
+                memcmp(lines[table[slot]],lines[j],lens[j]) != 0))
+            slot = (slot + 1) & mask;
+        if (table[slot] != -1) continue;
+
+        table[slot] = j;
+        keep[j] = 1;
+        kept++;
+    }
+    free(table);
+    return kept;
+}
+
 /* Save the history in the specified file. On success 0 is returned
- * otherwise -1 is returned. */
+ * otherwise -1 is returned.
+ *
+ * Only the newest copy of a line is saved. The file is written under a
+ * unique temporary name in the same directory and then renamed, so another
+ * program reading it never sees it half written, and two programs saving at
+ * once never write to the same temporary file. */
 int linenoiseHistorySave(const char *filename) {
-    mode_t old_umask = umask(S_IXUSR|S_IRWXG|S_IRWXO);
-    FILE *fp;
-    int j;
+    const char **lines;
+    size_t *lens;
+    char *keep, *tmpname;
+    FILE *fp = NULL;
+    int j, kept, ok, fd;
+
+    lines = malloc(sizeof(char*) * ((size_t)history_len + 1));
+    lens = malloc(sizeof(size_t) * ((size_t)history_len + 1));
+    keep = malloc((size_t)history_len + 1);
+    tmpname = malloc(strlen(filename) + 8);
+    if (lines == NULL || lens == NULL || keep == NULL || tmpname == NULL) {
+        kept = -1;
+    } else {
+        for (j = 0; j < history_len; j++) {
+            lines[j] = *historySlot(j);
+            lens[j] = strlen(lines[j]);
+        }
+        kept = historyDedup(lines,lens,history_len,keep,history_len);
+    }
+    if (kept < 0) {
+        free(lines); free(lens); free(keep); free(tmpname);
+        return -1;
+    }
 
-    fp = fopen(filename,"w");
-    umask(old_umask);
-    if (fp == NULL) return -1;
-    chmod(filename,S_IRUSR|S_IWUSR);
-    for (j = 0; j < history_len; j++)
-        fprintf(fp,"%s\n",history[j]);
-    fclose(fp);
-    return 0;
+    /* mkstemp() creates the file readable and writable by the owner only. */
+    sprintf(tmpname,"%s.XXXXXX",filename);
+    fd = mkstemp(tmpname);
+    if (fd != -1) {
+        fp = fdopen(fd,"w");
+        if (fp == NULL) {
+            close(fd);
+            unlink(tmpname);
+        }
+    }
+    ok = (fp != NULL);
+    if (ok) {
+        setvbuf(fp,NULL,_IOFBF,65536);
+        for (j = 0; j < history_len; j++) {
+            if (!keep[j]) continue;
+            fwrite(lines[j],1,lens[j],fp);
+            fputc('\n',fp);
+        }
+        ok = (fclose(fp) == 0) && rename(tmpname,filename) == 0;
+        if (!ok) unlink(tmpname);
+    }
+    free(lines); free(lens); free(keep); free(tmpname);
+    return ok ? 0 : -1;
 }
 
 /* Load the history from the specified file. If the file does not exist
  * zero is returned and no operation is performed.
  *
  * If the file exists and the operation succeeded 0 is returned, otherwise
- * on error -1 is returned. */
+ * on error -1 is returned.
+ *
+ * The file is memory mapped and read in place. Only the newest copy of a
+ * line is loaded, and only as many of the newest lines as the history can
+ * hold, so loading a large file does not copy lines that are then thrown
+ * away. */
 int linenoiseHistoryLoad(const char *filename) {
-    FILE *fp = fopen(filename,"r");
-    char buf[LINENOISE_MAX_LINE];
+    struct stat st;
+    const char *data, *pos, *end, **lines = NULL;
+    size_t *lens = NULL, n = 0, maxlines = 0;
+    char *keep = NULL;
+    int fd, j, result = 0;
+
+    fd = open(filename,O_RDONLY);
+    if (fd == -1) return -1;
+    if (fstat(fd,&st) == -1) {
+        close(fd);
+        return -1;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    data = mmap(NULL,(size_t)st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if (data == MAP_FAILED) return -1;
+    end = data + st.st_size;
+
+    /* Find the start and length of every line. */
+    for (pos = data; pos < end; ) {
+        const char *eol = memchr(pos,'\n',(size_t)(end - pos));
+        size_t len;
 
-    if (fp == NULL) return -1;
+        if (eol == NULL) eol = end;
+        len = (size_t)(eol - pos);
+        if (len && pos[len-1] == '\r') len--;
+        if (len >= LINENOISE_MAX_LINE) len = LINENOISE_MAX_LINE - 1;
+        if (n == maxlines) {
+            size_t newmax = maxlines ? maxlines * 2 : 1024;
+            const char **newlines = realloc(lines,newmax * sizeof(char*));
+            size_t *newlens = newlines ? realloc(lens,newmax * sizeof(size_t)) : NULL;
+
+            if (newlines) lines = newlines;
+            if (newlens == NULL) {
+                result = -1;
+                break;
+            }
+            lens = newlens;
+            maxlines = newmax;
+        }
+        lines[n] = pos;
+        lens[n] = len;
+        n++;
+        pos = eol + 1;
+    }
 
-    while (fgets(buf,LINENOISE_MAX_LINE,fp) != NULL) {
-        char *p;
+    if (result == 0) {
+        keep = malloc(n + 1);
+        if (keep == NULL ||
+            historyDedup(lines,lens,(int)n,keep,history_max_len) < 0)
+            result = -1;
+    }
+    for (j = 0; result == 0 && j < (int)n; j++) {
+        char *linecopy;
 
-        p = strchr(buf,'\r');
-        if (!p) p = strchr(buf,'\n');
-        if (p) *p = '\0';
-        linenoiseHistoryAdd(buf);
+        if (!keep[j]) continue;
+        linecopy = strndup(lines[j],lens[j]);
+        if (linecopy == NULL || !historyAddCopy(linecopy)) result = -1;
     }
-    fclose(fp);
-    return 0;
+
+    free(lines);
+    free(lens);
+    free(keep);
+    munmap((void*)data,(size_t)st.st_size);
+    return result;
 }
@@ -48,6 +48,15 @@ typedef struct linenoiseCompletions {
   char **cvec;
 } linenoiseCompletions;
 
+/* A history swapped out of linenoise by linenoiseHistorySwap(), for another
+ * history to be used in the meantime. A zeroed one is an empty history. */
+typedef struct linenoiseHistoryState {
+  char **history;
+  int max_len;
+  int len;
+  int start;
+} linenoiseHistoryState;
+
 typedef void(linenoiseCompletionCallback)(const char *, linenoiseCompletions *);
 typedef char*(linenoiseHintsCallback)(const char *, int *color, int *bold);
 typedef void(linenoiseFreeHintsCallback)(void *);
@@ -62,6 +71,8 @@ int linenoiseHistoryAdd(const char *line);
 int linenoiseHistorySetMaxLen(int len);
 int linenoiseHistorySave(const char *filename);
 int linenoiseHistoryLoad(const char *filename);
+void linenoiseHistoryClear(void);
+void linenoiseHistorySwap(linenoiseHistoryState *state);
 void linenoiseClearScreen(void);
 void linenoiseSetMultiLine(int ml);
 void linenoisePrintKeyCodes(void);
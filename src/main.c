@@ -40,6 +40,27 @@ int main(int argc, char **argv)
     /** @note ensure known state for `amtdb.db_OK` before execution */
     amtdb.db_OK = false;
 
+    /** @note remove any '--format' option so the other options are found in their usual places */
+    if (!parse_format_option(&argc, argv)) {
+        exit(EXIT_FAILURE);
+    }
+    amtdb.profile = parse_flag_option(&argc, argv, "--profile");
+    amtdb.mem_stats = parse_flag_option(&argc, argv, "--mem-stats");
+
+    /** @note a command profiled or measured must run here, not be answered by a running server */
+    const bool run_local = amtdb.profile || amtdb.mem_stats;
+
+    /** @note SQLite's memory is set up before it is first used, sized for the way the program is being run */
+    alloc_mode mode = ALLOC_COMMAND;
+    if (argc > 1 && strcmp(argv[1], "--shell") == 0) {
+        mode = ALLOC_SHELL;
+    } else if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        mode = ALLOC_SERVER;
+    }
+    if (!alloc_configure(mode)) {
+        exit(EXIT_FAILURE);
+    }
+
 #if DEBUG
     fprintf(stderr, "DEBUG: the programs was built in 'debug' mode\n");
 #endif
@@ -63,13 +84,43 @@ int main(int argc, char **argv)
 
         /** @note SEARCH : search for provided acronym */
         if (strcmp(argv[1], "-s") == 0 || strcmp(argv[1], "--search") == 0) {
+            /** @note more than one acronym provided - search for them all in one batch */
+            if (argc > 3) {
+                if (!run_local && serve_forward("s", &argv[2], argc - 2, &amtdb)) {
+                    return (EXIT_SUCCESS);
+                }
+                setvbuf(stdout, NULL, _IOFBF, BUFSIZ * 16);
+                if (!bootstrap_db(true)) {
+                    return (EXIT_FAILURE);
+                }
+                outbuf_header();
+                if (do_batch_search(NULL, &argv[2], argc - 2, &amtdb) < 0) {
+                    exit(EXIT_FAILURE);
+                }
+                outbuf_footer();
+                return (EXIT_SUCCESS);
+            }
             if (argc > 2 && strlen(argv[2]) > 0) {
-                if (!bootstrap_db()) {
+                if (!run_local && serve_forward("s", &argv[2], 1, &amtdb)) {
+                    return (EXIT_SUCCESS);
+                }
+                if (!bootstrap_db(true)) {
                     return (EXIT_FAILURE);
                 }
+                outbuf_header();
                 const int rec_match = do_acronym_search(argv[2], &amtdb);
-                printf("\nSearch of '%'d' records for '%s' found '%d' matches.\n\n", amtdb.totalrec, argv[2],
-                       rec_match);
+                if (rec_match < 0) {
+                    fprintf(stderr, "ERROR: failed to complete the search.\n");
+                    exit(EXIT_FAILURE);
+                }
+                if (amtdb.format == OUTPUT_TEXT) {
+                    printf("\nSearch of '%'d' records for '%s' found '%d' matches.\n\n", amtdb.totalrec, argv[2],
+                           rec_match);
+                    if (rec_match == 0) {
+                        do_fuzzy_suggest(argv[2], &amtdb);
+                    }
+                }
+                outbuf_footer();
                 return (EXIT_SUCCESS);
 
             } else {
@@ -79,9 +130,122 @@ int main(int argc, char **argv)
             }
         }
 
+        /** @note BATCH : search for each acronym read from stdin, one per line */
+        if (strcmp(argv[1], "-b") == 0 || strcmp(argv[1], "--batch") == 0) {
+            /** @note output is fully buffered as it is normally going to a pipe or file */
+            setvbuf(stdout, NULL, _IOFBF, BUFSIZ * 16);
+            if (!bootstrap_db(true)) {
+                return (EXIT_FAILURE);
+            }
+            outbuf_header();
+            if (do_batch_search(stdin, NULL, 0, &amtdb) < 0) {
+                fprintf(stderr, "ERROR: failed to complete the batch search.\n");
+                exit(EXIT_FAILURE);
+            }
+            outbuf_footer();
+            return (EXIT_SUCCESS);
+        }
+
+        /** @note SCAN : report every known acronym found in a file */
+        if (strcmp(argv[1], "--scan") == 0) {
+            if (argc > 2 && strlen(argv[2]) > 0) {
+                if (!bootstrap_db(true)) {
+                    return (EXIT_FAILURE);
+                }
+                if (do_document_scan(argv[2], &amtdb)) {
+                    printf("\nSCAN DONE\n");
+                    return (EXIT_SUCCESS);
+                } else {
+                    fprintf(stderr, "ERROR: failed to complete scanning the file.\n");
+                    exit(EXIT_FAILURE);
+                }
+            } else {
+                fprintf(stderr, "\nERROR: for '--scan' option please provide "
+                                "a file to scan for acronyms.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        /** @note IMPORT : add the records held in a CSV or TSV file */
+        if (strcmp(argv[1], "--import") == 0) {
+            if (argc > 2 && strlen(argv[2]) > 0) {
+                if (!bootstrap_db(false)) {
+                    return (EXIT_FAILURE);
+                }
+                if (do_import(argv[2], &amtdb)) {
+                    printf("\nIMPORT DONE\n");
+                    return (EXIT_SUCCESS);
+                } else {
+                    fprintf(stderr, "ERROR: failed to complete importing the file.\n");
+                    exit(EXIT_FAILURE);
+                }
+            } else {
+                fprintf(stderr, "\nERROR: for '--import' option please provide "
+                                "a CSV or TSV file to import.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        /** @note SERVE : answer searches sent to a UNIX domain socket, keeping the database open */
+        if (strcmp(argv[1], "--serve") == 0) {
+            if (!bootstrap_db(false)) {
+                return (EXIT_FAILURE);
+            }
+            if (do_serve((argc > 2 && strlen(argv[2]) > 0) ? argv[2] : NULL, &amtdb)) {
+                printf("\nSERVE DONE\n");
+                return (EXIT_SUCCESS);
+            } else {
+                fprintf(stderr, "ERROR: failed to start the server.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        /** @note SHELL : run many commands typed by the user against one open database */
+        if (strcmp(argv[1], "--shell") == 0) {
+            if (!bootstrap_db(false)) {
+                return (EXIT_FAILURE);
+            }
+            if (do_shell(&amtdb)) {
+                printf("\nSHELL DONE\n");
+                return (EXIT_SUCCESS);
+            } else {
+                fprintf(stderr, "ERROR: failed to run the shell.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        /** @note TEXT : search the acronyms definitions and descriptions for the provided words */
+        if (strcmp(argv[1], "-t") == 0 || strcmp(argv[1], "--text") == 0) {
+            if (argc > 2 && strlen(argv[2]) > 0) {
+                if (!run_local && serve_forward("t", &argv[2], 1, &amtdb)) {
+                    return (EXIT_SUCCESS);
+                }
+                if (!bootstrap_db(false)) {
+                    return (EXIT_FAILURE);
+                }
+                outbuf_header();
+                const int rec_match = do_text_search(argv[2], &amtdb);
+                if (rec_match < 0) {
+                    fprintf(stderr, "ERROR: failed to complete the text search.\n");
+                    exit(EXIT_FAILURE);
+                }
+                if (amtdb.format == OUTPUT_TEXT) {
+                    printf("\nText search of '%'d' records for '%s' found '%d' matches.\n\n", amtdb.totalrec,
+                           argv[2], rec_match);
+                }
+                outbuf_footer();
+                return (EXIT_SUCCESS);
+
+            } else {
+                fprintf(stderr, "\nERROR: for '-t' or '--text' option please provide "
+                                "the words to search for.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
         /** @note NEW : add a new acronym via user prompts */
         if (strcmp(argv[1], "-n") == 0 || strcmp(argv[1], "--new") == 0) {
-            if (!bootstrap_db()) {
+            if (!bootstrap_db(false)) {
                 return (EXIT_FAILURE);
             }
             if (new_acronym(&amtdb)) {
@@ -95,11 +259,18 @@ int main(int argc, char **argv)
 
         /** @note LATEST : list the 5 newest acronyms */
         if (strcmp(argv[1], "-l") == 0 || strcmp(argv[1], "--latest") == 0) {
-            if (!bootstrap_db()) {
+            if (!run_local && serve_forward("l", NULL, 0, &amtdb)) {
+                return (EXIT_SUCCESS);
+            }
+            if (!bootstrap_db(true)) {
                 return (EXIT_FAILURE);
             }
+            outbuf_header();
             if (latest_acronym(&amtdb)) {
-                printf("\nLATEST DONE\n");
+                if (amtdb.format == OUTPUT_TEXT) {
+                    printf("\nLATEST DONE\n");
+                }
+                outbuf_footer();
                 return (EXIT_SUCCESS);
             } else {
                 fprintf(stderr, "ERROR: failed to complete listing the new records.\n");
@@ -107,10 +278,55 @@ int main(int argc, char **argv)
             }
         }
 
+        /** @note LIST : output every acronym record, ordered by acronym */
+        if (strcmp(argv[1], "--list") == 0) {
+            if (!bootstrap_db(true)) {
+                return (EXIT_FAILURE);
+            }
+            outbuf_header();
+            const int rec_count = do_list_all(&amtdb);
+            if (rec_count < 0) {
+                fprintf(stderr, "ERROR: failed to complete listing the records.\n");
+                exit(EXIT_FAILURE);
+            }
+            if (amtdb.format == OUTPUT_TEXT) {
+                printf("\nListed '%'d' records.\n", rec_count);
+                printf("\nLIST DONE\n");
+            }
+            outbuf_footer();
+            return (EXIT_SUCCESS);
+        }
+
+        /** @note EXPORT : output every acronym record for use by other programs */
+        if (strcmp(argv[1], "--export") == 0) {
+            export_sort sort = EXPORT_SORT_NONE;
+            size_t sort_mb = AMT_EXPORT_SORT_MB;
+            if (!parse_export_options(argc, argv, &sort, &sort_mb)) {
+                exit(EXIT_FAILURE);
+            }
+            /** @note an export is always for another program, so is CSV unless another format is chosen */
+            if (amtdb.format == OUTPUT_TEXT) {
+                amtdb.format = OUTPUT_CSV;
+                outbuf_set_format(amtdb.format);
+            }
+            if (!bootstrap_db(true)) {
+                return (EXIT_FAILURE);
+            }
+            outbuf_header();
+            const int rec_count = do_export(sort, sort_mb, &amtdb);
+            if (rec_count < 0) {
+                fprintf(stderr, "ERROR: failed to complete exporting the records.\n");
+                exit(EXIT_FAILURE);
+            }
+            outbuf_footer();
+            fprintf(stderr, "Exported '%'d' records.\n", rec_count);
+            return (EXIT_SUCCESS);
+        }
+
         /** @note DELETE : delete an acronym record */
         if (strcmp(argv[1], "-d") == 0 || strcmp(argv[1], "--delete") == 0) {
             if (argc > 2) {
-                if (!bootstrap_db()) {
+                if (!bootstrap_db(false)) {
                     return (EXIT_FAILURE);
                 }
                 long record_ID = strtol(argv[2], NULL, 10);
@@ -145,7 +361,7 @@ int main(int argc, char **argv)
         /** @note UPDATE : update an acronym record */
         if (strcmp(argv[1], "-u") == 0 || strcmp(argv[1], "--update") == 0) {
             if (argc > 2) {
-                if (!bootstrap_db()) {
+                if (!bootstrap_db(false)) {
                     return (EXIT_FAILURE);
                 }
                 long record_ID = strtol(argv[2], NULL, 10);
@@ -185,11 +401,26 @@ int main(int argc, char **argv)
 
         /** no matching command lines options - default action to search */
         if (strlen(argv[1]) > 0) {
-            if (!bootstrap_db()) {
+            if (!run_local && serve_forward("s", &argv[1], 1, &amtdb)) {
+                return (EXIT_SUCCESS);
+            }
+            if (!bootstrap_db(true)) {
                 return (EXIT_FAILURE);
             }
+            outbuf_header();
             const int rec_match = do_acronym_search(argv[1], &amtdb);
-            printf("\nSearch of '%'d' records for '%s' found '%d' matches.\n\n", amtdb.totalrec, argv[1], rec_match);
+            if (rec_match < 0) {
+                fprintf(stderr, "ERROR: failed to complete the search.\n");
+                exit(EXIT_FAILURE);
+            }
+            if (amtdb.format == OUTPUT_TEXT) {
+                printf("\nSearch of '%'d' records for '%s' found '%d' matches.\n\n", amtdb.totalrec, argv[1],
+                       rec_match);
+                if (rec_match == 0) {
+                    do_fuzzy_suggest(argv[1], &amtdb);
+                }
+            }
+            outbuf_footer();
             return (EXIT_SUCCESS);
         } else {
             fprintf(stderr, "\nERROR: for '-s' or '--search' option please provide "
@@ -200,7 +431,7 @@ int main(int argc, char **argv)
     } else { /** @note NO COMMAND LINE ARGS PROVIDED */
         fprintf(stderr, "\nERROR: no command lines argument provided.\n");
         display_version();
-        if (bootstrap_db()) {
+        if (bootstrap_db(true)) {
             output_db_stats(&amtdb);
         }
         show_help();
@@ -209,14 +440,118 @@ int main(int argc, char **argv)
     // exit main()
 }
 
+/**
+ * @brief Find a '--format <name>' or '--format=<name>' option anywhere on the command line, set the output format
+ * from it, and remove it from the command line arguments.
+ * @param int *argc : number of command line arguments. Reduced by the number of arguments removed.
+ * @param char **argv : array of command line arguments. Later arguments are moved down over those removed.
+ * @note accesses the global variable `amtdb_struct *amtdb` structure.
+ * @return bool : false if the format name is missing or not known.
+ */
+bool parse_format_option(int *argc, char **argv)
+{
+    amtdb.format = OUTPUT_TEXT;
+
+    for (int i = 1; i < *argc; i++) {
+        const char *name = NULL;
+        int used = 0;
+
+        if (strcmp(argv[i], "--format") == 0) {
+            name = (i + 1 < *argc) ? argv[i + 1] : "";
+            used = (i + 1 < *argc) ? 2 : 1;
+        } else if (strncmp(argv[i], "--format=", 9) == 0) {
+            name = argv[i] + 9;
+            used = 1;
+        } else {
+            continue;
+        }
+
+        if (!outbuf_parse_format(name, &amtdb.format)) {
+            fprintf(stderr, "\nERROR: unknown '--format' of '%s'. Use one of: text, ndjson, csv, tsv, sql.\n", name);
+            return false;
+        }
+
+        /** @note move the rest of the arguments down, including the terminating NULL */
+        memmove(&argv[i], &argv[i + used], (size_t)(*argc - i - used + 1) * sizeof(char *));
+        *argc -= used;
+        i--;
+    }
+
+    outbuf_set_format(amtdb.format);
+    return true;
+}
+
+/**
+ * @brief Find an option without a value, such as '--profile', anywhere on the command line, and remove it from the
+ * command line arguments.
+ * @param int *argc : number of command line arguments. Reduced by the number of arguments removed.
+ * @param char **argv : array of command line arguments. Later arguments are moved down over those removed.
+ * @param const char *flag : the option to find.
+ * @return bool : true if the option was given.
+ */
+bool parse_flag_option(int *argc, char **argv, const char *flag)
+{
+    bool found = false;
+    for (int i = 1; i < *argc; i++) {
+        if (strcmp(argv[i], flag) == 0) {
+            found = true;
+            memmove(&argv[i], &argv[i + 1], (size_t)(*argc - i) * sizeof(char *));
+            (*argc)--;
+            i--;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Read the '--sort <order>' and '--sort-mem <MB>' options that may follow '--export'.
+ * @param int argc : number of command line arguments.
+ * @param char **argv : array of command line arguments, where 'argv[1]' is '--export'.
+ * @param export_sort *sort : set to the order given with '--sort'.
+ * @param size_t *sort_mb : set to the megabytes of memory given with '--sort-mem'.
+ * @return bool : false if an option or its value is not known.
+ */
+bool parse_export_options(int argc, char **argv, export_sort *sort, size_t *sort_mb)
+{
+    for (int i = 2; i < argc; i++) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : "";
+
+        if (strcmp(argv[i], "--sort") == 0) {
+            if (strcmp(value, "acronym") == 0) {
+                *sort = EXPORT_SORT_ACRONYM;
+            } else if (strcmp(value, "id") == 0) {
+                *sort = EXPORT_SORT_NONE;
+            } else {
+                fprintf(stderr, "\nERROR: unknown '--sort' of '%s'. Use one of: acronym, id.\n", value);
+                return false;
+            }
+        } else if (strcmp(argv[i], "--sort-mem") == 0) {
+            long mb = strtol(value, NULL, 10);
+            if (mb < 1) {
+                fprintf(stderr, "\nERROR: '--sort-mem' of '%s' is not a number of megabytes.\n", value);
+                return false;
+            }
+            *sort_mb = (size_t)mb;
+        } else {
+            fprintf(stderr, "\nERROR: unknown '--export' option '%s'.\n", argv[i]);
+            return false;
+        }
+        i++;
+    }
+    return true;
+}
+
 /**
  * @brief Start the programs SQLite database file validation and connections.
- * @param none
+ * @param bool read_only : true for commands that only search or list records, so the database can be opened read
+ * only.
  * @note accesses the global variable `amtdb_struct *amtdb` structure.
  * @return none.
  */
-bool bootstrap_db(void)
+bool bootstrap_db(bool read_only)
 {
+    amtdb.read_only = read_only;
+
 
     /** @note check for a valid database file */
     if (!check_4_db_file(&amtdb)) {
@@ -290,17 +625,34 @@ void show_help(void)
            "Usage: %s [switches] [arguments]\n"
            "\n"
            "[Switches]        [Arguments]      [Description]\n"
+           "-b, --batch                        search for each acronym read from stdin, one per line.\n"
            "-d, --delete       <rec_id>        delete an acronym record. Argument is mandatory.\n"
+           "    --export       [--sort <order>] output every record as CSV, or as given with '--format'.\n"
            "-h, --help                         display help information.\n"
+           "    --import       <file>          add the records held in a CSV or TSV file.\n"
            "-l, --latest                       display the five latest records added.\n"
+           "    --list                         display every record, ordered by acronym.\n"
            "-n, --new                          add a new record.\n"
-           "-s, --search       <acronym>       find a acronym record. Argument is mandatory.\n"
+           "-s, --search       <acronym> ...   find a acronym record. Argument is mandatory.\n"
+           "    --scan         <file>          list every known acronym found in a file.\n"
+           "    --serve        [socket]        answer '-s', '-t' and '-l' from other runs of amt over a socket.\n"
+           "    --shell                        run search, new, update, delete and latest commands interactively.\n"
+           "-t, --text         <words>         find acronyms by words in their definition or description.\n"
            "-u, --update       <rec_id>        update an existing record. Argument is mandatory.\n"
            "-v, --version                      display program version information.\n"
+           "    --format       <format>        output records for '-s', '-b', '-l', '--list', '-t' and '--export' as: <format>.\n"
+           "    --profile                      show each SQL statement run by any command, with its time, on stderr.\n"
+           "    --mem-stats                    show the memory used by SQLite and amt after any command, on stderr.\n"
            "\n"
            "Arguments\n"
            " <acronym> : a string representing an acronym to be found. Use quotes if contains spaces.\n"
            " <rec_id>  : unique number assigned to each acronym. Can be found with a '-s, --search'.\n"
+           " <file>    : for '--scan' a text file. Acronyms must match in case and be whole words.\n"
+           "             for '--import' a CSV or TSV file, as output by '--format'. Use '-' for stdin.\n"
+           " <words>   : words that must all appear in an acronyms definition or description. Best matches first.\n"
+           " <order>   : 'acronym' or 'id' (the default). Add '--sort-mem <MB>' to set the memory used to sort.\n"
+           " [socket]  : UNIX socket path. Default '$XDG_RUNTIME_DIR/amt.sock'. Set env 'AMT_SOCKET' to match.\n"
+           " <format>  : one of 'text' (the default), 'ndjson', 'csv', 'tsv' or 'sql'.\n"
            "Use '%%' for wildcard searches.\n\n",
            amtdb.prog_name);
 }
@@ -309,20 +661,40 @@ void show_help(void)
  * @brief Used by applications 'atexit()' call on successful program exit.
  * @param none
  * @note accesses the global variable `amtdb_struct *amtdb` structure.
+ * @note it must not call 'exit()' itself, so the exit status given to 'exit()' or returned from 'main()' is kept.
  * @return none.
  */
 void exit_cleanup(void)
 {
+    if (amtdb.mem_stats) {
+        output_mem_stats(&amtdb, stderr);
+    }
+
     if (amtdb.db == NULL) {
-        exit(EXIT_SUCCESS);
+        return;
     }
 
+    /** @note the profile report includes the registry statement counts, so a debug build only adds them without it */
+    if (amtdb.profile) {
+        profile_report(&amtdb);
+    }
+#if DEBUG
+    else {
+        output_stmt_stats(&amtdb);
+    }
+#endif
+
+    /** @note statements in the registry must be finalized before the database can be closed cleanly */
+    finalize_stmts(&amtdb);
+
+    /** @note keep the WAL file from growing while other programs always have the database open */
+    checkpoint_database(&amtdb);
+
     int rc = sqlite3_close_v2(amtdb.db);
     if (rc != SQLITE_OK) {
         fprintf(stderr, "\nWARNING: error '%s' when trying to close the database\n", sqlite3_errstr(rc));
-        exit(EXIT_FAILURE);
+        return;
     }
     sqlite3_shutdown();
     amtdb.db_OK = false;
-    exit(EXIT_SUCCESS);
 }
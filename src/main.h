@@ -19,15 +19,27 @@
  * alterations of existing, and deletion of records no longer required.
  *
  * @note The program can e compiled with CMake or directly with
- * @code cc -Wall -std=gnu11 -g -o amt ./src/amt-db-funcs.c ./src/main.c ./src/sqlite3.c ./src/linenoise.c -lpthread
- * -ldl
+ * @code cc -Wall -std=gnu11 -g -DSQLITE_ENABLE_FTS5 -DSQLITE_ENABLE_MEMSYS5 -o amt ./src/amt-alloc.c
+ * ./src/amt-db-funcs.c ./src/amt-export.c ./src/amt-fuzzy.c
+ * ./src/amt-hints.c ./src/amt-import.c ./src/amt-memstats.c ./src/amt-scan.c ./src/amt-output.c ./src/amt-profile.c ./src/amt-server.c
+ * ./src/amt-shell.c ./src/amt-sources.c ./src/main.c ./src/sqlite3.c ./src/linenoise.c -lpthread -ldl -lm
  *
  */
 
 #ifndef AMT_MAIN_H /* Include guard */
 #define AMT_MAIN_H
 
+#include "amt-alloc.h"    /* memory SQLite uses: malloc, or an arena sized for each mode */
 #include "amt-db-funcs.h" /* manages the database access for the application */
+#include "amt-export.h"   /* export of every record, optionally sorted with spill files */
+#include "amt-fuzzy.h"    /* 'did you mean' suggestions when a search finds no matches */
+#include "amt-import.h"   /* bulk import of records from CSV or TSV files */
+#include "amt-memstats.h" /* '--mem-stats' memory use of SQLite and the program */
+#include "amt-output.h"   /* buffered record output in text, NDJSON, CSV or TSV formats */
+#include "amt-profile.h"  /* '--profile' timing of each SQL statement run */
+#include "amt-scan.h"     /* scan a document for every known acronym */
+#include "amt-server.h"   /* resident server answering searches over a UNIX domain socket */
+#include "amt-shell.h"    /* interactive shell running many commands against one open database */
 #include "sqlite3.h"      /* SQLite header */
 #include "types.h"        /* Structure to manage SQLite database information */
 
@@ -37,6 +49,9 @@ amtdb_struct amtdb;                 /** @note Declared globally for 'atexit()'.
 void exit_cleanup(void);    /** @note Run by 'atexit()' on normal program exit */
 void show_help(void);       /** @note display help and usage information to screen */
 void display_version(void); /** @note display program version details */
-bool bootstrap_db(void);    /** @note ensure database is available and accessible */
+bool bootstrap_db(bool read_only); /** @note ensure database is available and accessible */
+bool parse_format_option(int *argc, char **argv); /** @note set output format from any '--format' option */
+bool parse_flag_option(int *argc, char **argv, const char *flag); /** @note find and remove an option like '--profile' */
+bool parse_export_options(int argc, char **argv, export_sort *sort, size_t *sort_mb); /** @note '--export' options */
 
 #endif // AMT_MAIN_H
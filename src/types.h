@@ -8,6 +8,58 @@
 
 #include "sqlite3.h"
 #include <stdbool.h>
+#include <time.h>
+
+/** @note the SQL statements held in the 'amtdb_struct' prepared statement registry */
+typedef enum AmtStmt_Id {
+    AMT_STMT_META_COUNT,
+    AMT_STMT_TABLE_COUNT,
+    AMT_STMT_META_MAXID,
+    AMT_STMT_TABLE_MAXID,
+    AMT_STMT_META_READ,
+    AMT_STMT_META_LAST,
+    AMT_STMT_TABLE_LAST,
+    AMT_STMT_OBJECT_EXISTS,
+    AMT_STMT_LATEST,
+    AMT_STMT_SEARCH_EXACT,
+    AMT_STMT_SEARCH_RANGE,
+    AMT_STMT_SEARCH_FROM,
+    AMT_STMT_SEARCH_LIKE,
+    AMT_STMT_TEXT_SEARCH,
+    AMT_STMT_FTS_IN_STEP,
+    AMT_STMT_INSERT,
+    AMT_STMT_RECORD_BY_ID,
+    AMT_STMT_DELETE,
+    AMT_STMT_SOURCE_LIST,
+    AMT_STMT_SOURCE_COUNTS,
+    AMT_STMT_UPDATE,
+    AMT_STMT_ACRONYM_EXISTS,
+    AMT_STMT_DISTINCT_ACRONYMS,
+    AMT_STMT_FUZZY_INSERT,
+    AMT_STMT_FUZZY_DELETE,
+    AMT_STMT_FUZZY_LOOKUP,
+    AMT_STMT_DEFINITIONS,
+    AMT_STMT_LIST_ALL,
+    AMT_STMT_EXPORT,
+    AMT_STMT_HINTS,
+    AMT_STMT_MAX /* number of statements - must be last */
+} amt_stmt_id;
+
+/** @note a registry entry: the statement is prepared once on first use and kept until 'exit_cleanup()' */
+typedef struct AmtStmt_Struct {
+    sqlite3_stmt *stmt;
+    int prepares;
+    long long steps;
+} amtstmt_struct;
+
+/** @note how records are written out by searches and listings. Selected with '--format' */
+typedef enum AmtOutput_Format {
+    OUTPUT_TEXT,    /* record blocks for people to read */
+    OUTPUT_NDJSON,  /* one JSON object per line */
+    OUTPUT_CSV,     /* RFC 4180 comma separated values, with a header line */
+    OUTPUT_TSV,     /* tab separated values, with a header line */
+    OUTPUT_SQL      /* SQL 'INSERT' statements, in one transaction */
+} output_format;
 
 typedef struct AmtDB_Struct {
     char *dbfile;
@@ -19,7 +71,25 @@ typedef struct AmtDB_Struct {
     int totalrec;
     int prevtotalrec;
     int maxrecid;
+    bool meta_OK;
+    bool read_only;
+    bool profile;
+    bool mem_stats;
+    bool wal_OK;
+    int busy_timeout;
+    struct timespec busy_start;
+    bool index_checked;
+    bool index_OK;
+    output_format format;
+    amtstmt_struct stmts[AMT_STMT_MAX];
 } amtdb_struct;
 
+/** @note how 'do_acronym_search()' will run a search pattern */
+typedef enum AmtSearch_Plan {
+    SEARCH_EXACT,   /* no wildcards: index equality lookup */
+    SEARCH_PREFIX,  /* trailing '%' only: index range scan */
+    SEARCH_LIKE     /* any other wildcards: 'LIKE' table scan */
+} search_plan;
+
 
 #endif //AMT_TYPES_H